@@ -0,0 +1,366 @@
+# include "chtable.h"
+
+static uint64_t chtable_hash (int64_t key);
+static struct _chtable_table *chtable_newtable (uint64_t capacity);
+static uint64_t chtable_freeslot (struct _chtable_table *t, uint64_t hash);
+static bool chtable_resize (struct _chtable_stripe *st, uint64_t capacity);
+static void chtable_writebegin (struct _chtable_stripe *st);
+static void chtable_writeend (struct _chtable_stripe *st);
+
+/**
+ * @brief Hashes a key using the murmur3 finalizer
+ *
+ * Bits 32 and up pick the stripe, the low bits pick the slot.
+ */
+static uint64_t chtable_hash (int64_t key)
+{
+    uint64_t x = key;
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdull;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ull;
+    x ^= x >> 33;
+    return x;
+}
+
+/**
+ * @brief Allocates a table with all slots empty, states are stored after the slots
+ * @return struct _chtable_table* NULL if allocation fails
+ */
+static struct _chtable_table *chtable_newtable (uint64_t capacity)
+{
+    if (capacity > (UINT64_MAX - sizeof (struct _chtable_table)) / (sizeof (struct _chtable_slot) + 1))
+        return NULL;
+    struct _chtable_table *t = malloc (sizeof (struct _chtable_table) + capacity * (sizeof (struct _chtable_slot) + 1));
+    if (!t)
+        return NULL;
+    t->capacity = capacity;
+    t->threshold = capacity / 4 * 3;
+    t->retired = NULL;
+    t->states = (_Atomic uint8_t *) &t->slots[capacity];
+    for (uint64_t i = 0; i < capacity; i++)
+        atomic_init (&t->states[i], CHTABLE_EMPTY);
+    return t;
+}
+
+/**
+ * @brief Finds the first empty slot on the probe sequence of hash
+ *
+ * Only called by writers, there's always such a slot as the threshold is
+ * under the capacity.
+ */
+static uint64_t chtable_freeslot (struct _chtable_table *t, uint64_t hash)
+{
+    uint64_t mask = t->capacity - 1;
+    uint64_t i = hash & mask;
+    while (atomic_load_explicit (&t->states[i], memory_order_relaxed) == CHTABLE_FULL)
+        i = (i + 1) & mask;
+    return i;
+}
+
+/**
+ * @brief Moves entries of a stripe to a new table and publishes it
+ *
+ * The new table is filled before readers can see it, so the stripe is
+ * only marked as changing while its table pointer is swapped.
+ *
+ * @param st The stripe, its lock must be held
+ * @param capacity Number of slots, a power of 2
+ * @return bool False if allocation fails, the stripe is unchanged then
+ */
+static bool chtable_resize (struct _chtable_stripe *st, uint64_t capacity)
+{
+    struct _chtable_table *old = atomic_load_explicit (&st->table, memory_order_relaxed);
+    struct _chtable_table *t = chtable_newtable (capacity);
+    if (!t)
+        return false;
+    for (uint64_t i = 0; i < old->capacity; i++) {
+        if (atomic_load_explicit (&old->states[i], memory_order_relaxed) != CHTABLE_FULL)
+            continue;
+        int64_t key = atomic_load_explicit (&old->slots[i].key, memory_order_relaxed);
+        uint64_t j = chtable_freeslot (t, chtable_hash (key));
+        atomic_init (&t->slots[j].key, key);
+        atomic_init (&t->slots[j].value, atomic_load_explicit (&old->slots[i].value, memory_order_relaxed));
+        atomic_init (&t->states[j], CHTABLE_FULL);
+    }
+    t->retired = old;
+    chtable_writebegin (st);
+    // release pairs with the acquire load in chtable_find, so a reader that sees t also sees it filled
+    atomic_store_explicit (&st->table, t, memory_order_release);
+    chtable_writeend (st);
+    return true;
+}
+
+/**
+ * @brief Makes sequence number of a stripe odd before a writer changes it
+ */
+static void chtable_writebegin (struct _chtable_stripe *st)
+{
+    uint64_t seq = atomic_load_explicit (&st->seq, memory_order_relaxed);
+    atomic_store_explicit (&st->seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence (memory_order_release);
+}
+
+/**
+ * @brief Makes sequence number of a stripe even again once a writer is done
+ */
+static void chtable_writeend (struct _chtable_stripe *st)
+{
+    uint64_t seq = atomic_load_explicit (&st->seq, memory_order_relaxed);
+    atomic_store_explicit (&st->seq, seq + 1, memory_order_release);
+}
+
+/**
+ * @brief Allocates a new chtable in the heap
+ *
+ * Remember to free the chtable using chtable_delete (&ct);
+ *
+ * @param stripes Number of stripes, rounded up to a power of 2, CHTABLE_STRIPES if 0
+ * @return chtable Returns NULL if stripes is above CHTABLE_MAXSTRIPES
+ */
+chtable new_chtable (uint32_t stripes)
+{
+    if (!stripes)
+        stripes = CHTABLE_STRIPES;
+    if (stripes > CHTABLE_MAXSTRIPES)
+        return NULL;
+    uint64_t count = 1;
+    while (count < stripes)
+        count *= 2;
+    chtable ct = malloc (sizeof (struct _chtable));
+    if (!ct)
+        return NULL;
+    ct->stripes = aligned_alloc (_Alignof (struct _chtable_stripe), count * sizeof (struct _chtable_stripe));
+    if (!ct->stripes) {
+        free (ct);
+        return NULL;
+    }
+    ct->stripemask = count - 1;
+    for (uint64_t s = 0; s < count; s++) {
+        struct _chtable_stripe *st = &ct->stripes[s];
+        struct _chtable_table *t = chtable_newtable (CHTABLE_MINCAPACITY);
+        if (!t || pthread_mutex_init (&st->lock, NULL)) {
+            free (t);
+            while (s--) {
+                free (atomic_load (&ct->stripes[s].table));
+                pthread_mutex_destroy (&ct->stripes[s].lock);
+            }
+            free (ct->stripes);
+            free (ct);
+            return NULL;
+        }
+        atomic_init (&st->seq, 0);
+        atomic_init (&st->table, t);
+        atomic_init (&st->length, 0);
+    }
+    return ct;
+}
+
+/**
+ * @brief Sets value of a key, adding the key if it's not in the chtable
+ * @param ct The chtable
+ * @param key The key
+ * @param value The value
+ * @return bool True if successful
+ */
+bool chtable_set (chtable ct, int64_t key, int64_t value)
+{
+    if (!ct)
+        return false;
+    uint64_t hash = chtable_hash (key);
+    struct _chtable_stripe *st = &ct->stripes[(hash >> 32) & ct->stripemask];
+    pthread_mutex_lock (&st->lock);
+    struct _chtable_table *t = atomic_load_explicit (&st->table, memory_order_relaxed);
+    uint64_t mask = t->capacity - 1;
+    uint64_t i = hash & mask;
+    for (uint64_t n = 0; n < t->capacity; n++, i = (i + 1) & mask) {
+        uint8_t state = atomic_load_explicit (&t->states[i], memory_order_relaxed);
+        if (state == CHTABLE_EMPTY)
+            break;
+        if (atomic_load_explicit (&t->slots[i].key, memory_order_relaxed) == key) {
+            // a reader sees either value, so the stripe isn't marked as changing
+            atomic_store_explicit (&t->slots[i].value, value, memory_order_relaxed);
+            pthread_mutex_unlock (&st->lock);
+            return true;
+        }
+    }
+    // the probe stopped at the empty slot the new entry goes to, unless the stripe has to grow
+    uint64_t length = atomic_load_explicit (&st->length, memory_order_relaxed);
+    if (length >= t->threshold) {
+        if (!chtable_resize (st, 2 * t->capacity)) {
+            pthread_mutex_unlock (&st->lock);
+            return false;
+        }
+        t = atomic_load_explicit (&st->table, memory_order_relaxed);
+        i = chtable_freeslot (t, hash);
+    }
+    chtable_writebegin (st);
+    atomic_store_explicit (&t->slots[i].key, key, memory_order_relaxed);
+    atomic_store_explicit (&t->slots[i].value, value, memory_order_relaxed);
+    atomic_store_explicit (&t->states[i], CHTABLE_FULL, memory_order_relaxed);
+    chtable_writeend (st);
+    atomic_store_explicit (&st->length, length + 1, memory_order_relaxed);
+    pthread_mutex_unlock (&st->lock);
+    return true;
+}
+
+/**
+ * @brief Gets value of a key without taking any lock
+ *
+ * There's no way to be sure that CHTABLE_ERROR value was returned as a
+ * result of error, or if that exact number had actually been stored.
+ * Use chtable_find if that matters.
+ *
+ * @param ct The chtable
+ * @param key The key
+ * @return int64_t Returns CHTABLE_ERROR if key isn't found
+ */
+int64_t chtable_get (chtable ct, int64_t key)
+{
+    int64_t value;
+    if (!chtable_find (ct, key, &value))
+        return CHTABLE_ERROR;
+    return value;
+}
+
+/**
+ * @brief Finds value of a key without taking any lock
+ * @param ct The chtable
+ * @param key The key
+ * @param value Set to value of key if it's found, may be NULL
+ * @return bool True if key is found
+ */
+bool chtable_find (chtable ct, int64_t key, int64_t *value)
+{
+    if (!ct)
+        return false;
+    uint64_t hash = chtable_hash (key);
+    struct _chtable_stripe *st = &ct->stripes[(hash >> 32) & ct->stripemask];
+    for (;;) {
+        uint64_t seq = atomic_load_explicit (&st->seq, memory_order_acquire);
+        if (seq & 1)
+            continue;
+        // replaced tables aren't freed, so the probe is safe even if the stripe grows meanwhile,
+        // and acquire orders reading a just grown table after the writes that filled it
+        struct _chtable_table *t = atomic_load_explicit (&st->table, memory_order_acquire);
+        uint64_t mask = t->capacity - 1;
+        uint64_t i = hash & mask;
+        bool found = false;
+        int64_t v = 0;
+        for (uint64_t n = 0; n < t->capacity; n++, i = (i + 1) & mask) {
+            uint8_t state = atomic_load_explicit (&t->states[i], memory_order_relaxed);
+            if (state == CHTABLE_EMPTY)
+                break;
+            if (atomic_load_explicit (&t->slots[i].key, memory_order_relaxed) == key) {
+                v = atomic_load_explicit (&t->slots[i].value, memory_order_relaxed);
+                found = true;
+                break;
+            }
+        }
+        atomic_thread_fence (memory_order_acquire);
+        if (atomic_load_explicit (&st->seq, memory_order_relaxed) != seq)
+            continue;
+        if (found && value)
+            *value = v;
+        return found;
+    }
+}
+
+/**
+ * @brief Removes a key and its value
+ * @param ct The chtable
+ * @param key The key
+ * @return bool False if key isn't found
+ */
+bool chtable_remove (chtable ct, int64_t key)
+{
+    if (!ct)
+        return false;
+    uint64_t hash = chtable_hash (key);
+    struct _chtable_stripe *st = &ct->stripes[(hash >> 32) & ct->stripemask];
+    pthread_mutex_lock (&st->lock);
+    struct _chtable_table *t = atomic_load_explicit (&st->table, memory_order_relaxed);
+    uint64_t mask = t->capacity - 1;
+    uint64_t i = hash & mask;
+    for (uint64_t n = 0; n < t->capacity; n++, i = (i + 1) & mask) {
+        uint8_t state = atomic_load_explicit (&t->states[i], memory_order_relaxed);
+        if (state == CHTABLE_EMPTY)
+            break;
+        if (atomic_load_explicit (&t->slots[i].key, memory_order_relaxed) != key)
+            continue;
+        // shift back following entries that i is on the probe sequence of, leaving no tombstones
+        chtable_writebegin (st);
+        uint64_t j = (i + 1) & mask;
+        while (atomic_load_explicit (&t->states[j], memory_order_relaxed) != CHTABLE_EMPTY) {
+            int64_t k = atomic_load_explicit (&t->slots[j].key, memory_order_relaxed);
+            uint64_t home = chtable_hash (k) & mask;
+            // the entry at j can move to i if its home isn't between them
+            if (((j - home) & mask) >= ((j - i) & mask)) {
+                int64_t v = atomic_load_explicit (&t->slots[j].value, memory_order_relaxed);
+                atomic_store_explicit (&t->slots[i].key, k, memory_order_relaxed);
+                atomic_store_explicit (&t->slots[i].value, v, memory_order_relaxed);
+                i = j;
+            }
+            j = (j + 1) & mask;
+        }
+        atomic_store_explicit (&t->states[i], CHTABLE_EMPTY, memory_order_relaxed);
+        chtable_writeend (st);
+        atomic_store_explicit (&st->length, atomic_load_explicit (&st->length, memory_order_relaxed) - 1, memory_order_relaxed);
+        pthread_mutex_unlock (&st->lock);
+        return true;
+    }
+    pthread_mutex_unlock (&st->lock);
+    return false;
+}
+
+/**
+ * @brief Gets number of entries
+ *
+ * Stripes are counted one after another, so the count may be off while
+ * other threads change the chtable.
+ *
+ * @param ct The chtable
+ * @return uint64_t
+ */
+uint64_t chtable_getlen (chtable ct)
+{
+    if (!ct)
+        return 0;
+    uint64_t length = 0;
+    for (uint64_t s = 0; s <= ct->stripemask; s++)
+        length += atomic_load_explicit (&ct->stripes[s].length, memory_order_relaxed);
+    return length;
+}
+
+/**
+ * @brief Deletes a chtable
+ *
+ * This function is basically a wrapper around free().
+ * Also sets chtable pointer to NULL.
+ *
+ * This function is recommended over free as the programmer
+ * might forget to set chtable pointer to NULL. As a result,
+ * another chtable operation will cause some undefined behaviour.
+ * Additionally, this function is more convenient.
+ *
+ * No other thread may be using the chtable.
+ *
+ * @param chtable* Reference to the chtable, is set to NULL.
+ */
+void chtable_delete (chtable *ct)
+{
+    if (!ct || !*ct)
+        return;
+    for (uint64_t s = 0; s <= (*ct)->stripemask; s++) {
+        struct _chtable_table *t = atomic_load (&(*ct)->stripes[s].table);
+        while (t) {
+            struct _chtable_table *retired = t->retired;
+            free (t);
+            t = retired;
+        }
+        pthread_mutex_destroy (&(*ct)->stripes[s].lock);
+    }
+    free ((*ct)->stripes);
+    free (*ct);
+    *ct = NULL;
+}
@@ -0,0 +1,164 @@
+# ifndef CHTABLE_H
+# define CHTABLE_H 1
+
+# include <stdlib.h>
+# include <inttypes.h>
+# include <stdint.h>
+# include <stdbool.h>
+# include <string.h>
+# include <stdatomic.h>
+# include <pthread.h>
+
+# define CHTABLE_ERROR 0x0123456789abcdeful
+// number of stripes when 0 is passed to new_chtable
+# define CHTABLE_STRIPES 64
+# define CHTABLE_MAXSTRIPES 65536
+// number of slots of a new stripe, always a power of 2
+# define CHTABLE_MINCAPACITY 16
+// states of a slot
+# define CHTABLE_EMPTY 0
+# define CHTABLE_FULL 1
+
+struct _chtable_slot {
+    _Atomic int64_t key;
+    _Atomic int64_t value;
+};
+
+// open addressing table of a stripe, replaced as a whole when the stripe grows
+struct _chtable_table {
+    uint64_t capacity;              // number of slots, a power of 2
+    uint64_t threshold;             // max number of entries
+    struct _chtable_table *retired; // tables this one replaced, readers may still be in them
+    _Atomic uint8_t *states;        // state of each slot, inside this allocation
+    struct _chtable_slot slots[];
+};
+
+struct _chtable_stripe {
+    _Alignas (64) _Atomic uint64_t seq;         // odd while a writer changes the stripe
+    _Atomic (struct _chtable_table *) table;
+    pthread_mutex_t lock;                       // held by writers
+    _Atomic uint64_t length;                    // number of entries
+};
+
+struct _chtable {
+    struct _chtable_stripe *stripes;
+    uint64_t stripemask;                        // number of stripes - 1
+};
+
+/**
+ * @brief The chtable struct
+ *
+ * A hash table from int64_t keys to int64_t values that many threads can
+ * use at once. Keys are split by hash into a power of 2 number of stripes,
+ * each an open addressing table of its own with its own lock, so writers
+ * to different stripes never wait for each other and each stripe grows
+ * on its own.
+ *
+ * Readers take no lock and write no shared memory. Each stripe has a
+ * sequence number that writers make odd while they change the stripe; a
+ * reader retries if the number was odd or changed while it probed. Value
+ * updates of existing keys are single atomic stores and don't bump it.
+ * Removal shifts following entries back instead of leaving tombstones,
+ * so a stripe only ever replaces its table to grow.
+ *
+ * A grown stripe publishes a new table with an atomic store. The tables
+ * it replaced are kept until chtable_delete, as readers may still be in
+ * them; they add up to less than the current size of the stripe.
+ *
+ * // new chtable
+ * chtable ct = new_chtable (0);
+ *
+ * // functions, all of them may be called from any thread
+ * bool chtable_set (chtable ct, int64_t key, int64_t value);
+ * int64_t chtable_get (chtable ct, int64_t key);
+ * bool chtable_find (chtable ct, int64_t key, int64_t *value);
+ * bool chtable_remove (chtable ct, int64_t key);
+ * uint64_t chtable_getlen (chtable ct);
+ *
+ * // deleting chtable, no other thread may be using it
+ * void chtable_delete (chtable *ct);
+ *
+ * // avoid accessing following chtable members
+ * ct->stripes;     // chtable stripes
+ * ct->stripemask;  // chtable number of stripes - 1
+ */
+typedef struct _chtable *chtable;
+
+/**
+ * @brief Allocates a new chtable in the heap
+ *
+ * Remember to free the chtable using chtable_delete (&ct);
+ *
+ * @param stripes Number of stripes, rounded up to a power of 2, CHTABLE_STRIPES if 0
+ * @return chtable Returns NULL if stripes is above CHTABLE_MAXSTRIPES
+ */
+chtable new_chtable (uint32_t stripes);
+
+/**
+ * @brief Sets value of a key, adding the key if it's not in the chtable
+ * @param ct The chtable
+ * @param key The key
+ * @param value The value
+ * @return bool True if successful
+ */
+bool chtable_set (chtable ct, int64_t key, int64_t value);
+
+/**
+ * @brief Gets value of a key without taking any lock
+ *
+ * There's no way to be sure that CHTABLE_ERROR value was returned as a
+ * result of error, or if that exact number had actually been stored.
+ * Use chtable_find if that matters.
+ *
+ * @param ct The chtable
+ * @param key The key
+ * @return int64_t Returns CHTABLE_ERROR if key isn't found
+ */
+int64_t chtable_get (chtable ct, int64_t key);
+
+/**
+ * @brief Finds value of a key without taking any lock
+ * @param ct The chtable
+ * @param key The key
+ * @param value Set to value of key if it's found, may be NULL
+ * @return bool True if key is found
+ */
+bool chtable_find (chtable ct, int64_t key, int64_t *value);
+
+/**
+ * @brief Removes a key and its value
+ * @param ct The chtable
+ * @param key The key
+ * @return bool False if key isn't found
+ */
+bool chtable_remove (chtable ct, int64_t key);
+
+/**
+ * @brief Gets number of entries
+ *
+ * Stripes are counted one after another, so the count may be off while
+ * other threads change the chtable.
+ *
+ * @param ct The chtable
+ * @return uint64_t
+ */
+uint64_t chtable_getlen (chtable ct);
+
+/**
+ * @brief Deletes a chtable
+ *
+ * This function is basically a wrapper around free().
+ * Also sets chtable pointer to NULL.
+ *
+ * This function is recommended over free as the programmer
+ * might forget to set chtable pointer to NULL. As a result,
+ * another chtable operation will cause some undefined behaviour.
+ * Additionally, this function is more convenient.
+ *
+ * No other thread may be using the chtable.
+ *
+ * @param chtable* Reference to the chtable, is set to NULL.
+ */
+void chtable_delete (chtable *ct);
+
+# endif
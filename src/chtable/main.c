@@ -0,0 +1,95 @@
+# include <stdio.h>
+# include <time.h>
+# include "chtable.h"
+
+// keys are 0 to KEYS - 1, every other one is in the chtable at start and writes add or remove them
+# define KEYS 1000000
+# define OPS 2000000
+
+struct job {
+    chtable ct;
+    uint64_t seed;
+    int readpct;
+    pthread_mutex_t *lock;      // taken around every operation, NULL to use chtable as it is
+};
+
+double now ()
+{
+    struct timespec ts;
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+void *worker (void *arg)
+{
+    struct job *job = arg;
+    uint64_t x = job->seed;
+    uint64_t sum = 0;
+    for (uint64_t i = 0; i < OPS; i++) {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        int64_t key = x % KEYS, value;
+        if (job->lock)
+            pthread_mutex_lock (job->lock);
+        // a write removes a key that's there and adds one that isn't, so the chtable stays about half full
+        if ((int) ((x >> 32) % 100) < job->readpct) {
+            if (chtable_find (job->ct, key, &value))
+                sum += (uint64_t) value;
+        }
+        else if (chtable_find (job->ct, key, NULL))
+            chtable_remove (job->ct, key);
+        else
+            chtable_set (job->ct, key, i);
+        if (job->lock)
+            pthread_mutex_unlock (job->lock);
+    }
+    return (void *) sum;
+}
+
+void bench (int threads, int readpct, uint32_t stripes, bool locked)
+{
+    pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+    chtable ct = new_chtable (stripes);
+    for (int64_t key = 0; key < KEYS; key += 2)
+        chtable_set (ct, key, key);
+    pthread_t tids[threads];
+    struct job jobs[threads];
+    double start = now ();
+    for (int t = 0; t < threads; t++) {
+        jobs[t] = (struct job) { ct, 0x9e3779b97f4a7c15ull * (t + 1), readpct, locked ? &lock : NULL };
+        pthread_create (&tids[t], NULL, worker, &jobs[t]);
+    }
+    for (int t = 0; t < threads; t++)
+        pthread_join (tids[t], NULL);
+    double secs = now () - start;
+    printf ("%8d %6d/%-3d %8u %10s %12.2f\n", threads, readpct, 100 - readpct, stripes,
+        locked ? "mutex" : "lock-free", threads * (double) OPS / secs / 1e6);
+    chtable_delete (&ct);
+}
+
+int main (int argc, char **argv)
+{
+    chtable ct = new_chtable (0);
+
+    chtable_set (ct, 45, 1);
+    chtable_set (ct, 25, 2);
+    chtable_set (ct, 19, 3);
+    chtable_remove (ct, 19);
+    int64_t value;
+    printf ("Value of 25 = %ld, has 19 = %d, length = %lu\n", chtable_get (ct, 25),
+        chtable_find (ct, 19, &value), chtable_getlen (ct));
+    chtable_delete (&ct);
+
+    // scaling from 1 thread up to the first argument, against one mutex around every operation as a baseline
+    int maxthreads = argc > 1 ? atoi (argv[1]) : 4;
+    int mixes[] = { 99, 90, 50 };
+    printf ("\n%8s %10s %8s %10s %12s\n", "threads", "read/write", "stripes", "reads", "Mops/s");
+    for (int m = 0; m < 3; m++)
+        for (int threads = 1; threads <= maxthreads; threads *= 2) {
+            bench (threads, mixes[m], 1, true);
+            bench (threads, mixes[m], 1, false);
+            bench (threads, mixes[m], CHTABLE_STRIPES, false);
+        }
+    return 0;
+}
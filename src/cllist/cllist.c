@@ -0,0 +1,416 @@
+# include <stdio.h>
+# include "cllist.h"
+
+static uint32_t cllist_newslot (cllist cl);
+static void cllist_freeslot (cllist cl, uint32_t slot);
+static uint32_t cllist_getslot (cllist cl, uint64_t index);
+
+/**
+ * @brief Takes a slot from the free slot stack, or a new one, growing the arrays if needed
+ *
+ * @param cllist The cllist
+ * @return uint32_t -- The slot, CLLIST_NIL if fails
+ */
+static uint32_t cllist_newslot (cllist cl)
+{
+    if (cl->freetop != CLLIST_NIL) {
+        uint32_t slot = cl->freetop;
+        cl->freetop = cl->link[slot].next;
+        return slot;
+    }
+    if (cl->used == cl->capacity) {
+        // CLLIST_NIL is never a slot, so at most CLLIST_NIL slots
+        if (cl->capacity == CLLIST_NIL)
+            return CLLIST_NIL;
+        uint64_t capacity = cl->capacity == 0 ? 8 : 2 * (uint64_t) cl->capacity;
+        if (capacity > CLLIST_NIL)
+            capacity = CLLIST_NIL;
+        int64_t *element = realloc (cl->element, capacity * sizeof (cl->element[0]));
+        if (element == NULL)
+            return CLLIST_NIL;
+        cl->element = element;
+        struct _cllist_link *link = realloc (cl->link, capacity * sizeof (cl->link[0]));
+        if (link == NULL)
+            return CLLIST_NIL;
+        cl->link = link;
+        cl->capacity = capacity;
+    }
+    return cl->used++;
+}
+
+/**
+ * @brief Pushes an unlinked slot to the free slot stack
+ *
+ * @param cllist The cllist
+ * @param uint32_t slot The slot
+ */
+static void cllist_freeslot (cllist cl, uint32_t slot)
+{
+    cl->link[slot].prev = CLLIST_NIL;
+    cl->link[slot].next = cl->freetop;
+    cl->freetop = slot;
+}
+
+/**
+ * @brief Gets slot at an index of cllist, O(1) if sequential, else walks from the nearer end
+ *
+ * @param cllist The cllist
+ * @param uint64_t index The index, must be less than cl->length
+ * @return uint32_t -- The slot
+ */
+static uint32_t cllist_getslot (cllist cl, uint64_t index)
+{
+    if (cl->sequential)
+        return index;
+    uint32_t slot;
+    if (index < cl->length / 2) {
+        slot = cl->start;
+        for (uint64_t i = 0; i < index; i++)
+            slot = cl->link[slot].next;
+    } else {
+        slot = cl->end;
+        for (uint64_t i = cl->length - 1; i > index; i--)
+            slot = cl->link[slot].prev;
+    }
+    return slot;
+}
+
+/**
+ * @brief Allocates a new cllist in the heap
+ *
+ * Remember to free the cllist using cllist_delete (&cl);
+ *
+ * @return cllist The cllist
+ */
+cllist new_cllist ()
+{
+    cllist cl = malloc (1 * sizeof (struct _cllist));
+    if (cl == NULL)
+        return NULL;
+    cl->element = NULL;
+    cl->link = NULL;
+    cl->start = CLLIST_NIL;
+    cl->end = CLLIST_NIL;
+    cl->freetop = CLLIST_NIL;
+    cl->used = 0;
+    cl->capacity = 0;
+    cl->sequential = true;
+    cl->length = 0;
+    return cl;
+}
+
+/**
+ * @brief Get length of the cllist
+ *
+ * If cllist is NULL, returns 0
+ *
+ * @param cl The cllist
+ * @return uint64_t The length
+ */
+uint64_t cllist_getlen (cllist cl)
+{
+    if (cl != NULL)
+        return cl->length;
+    return 0;
+}
+
+/**
+ * @brief Appends a value to the cllist and returns true.
+ *
+ * A cllist holds at most 0xfffffffe elements.
+ *
+ * @param cllist The cllist
+ * @param int64_t Value to append
+ * @return bool -- true if successful
+ */
+bool cllist_append (cllist cl, int64_t element)
+{
+    if (cl == NULL)
+        return false;
+    uint32_t slot = cllist_newslot (cl);
+    if (slot == CLLIST_NIL)
+        return false;
+    cl->link[slot].prev = cl->end;
+    cl->link[slot].next = CLLIST_NIL;
+    if (cl->length == 0)
+        cl->start = slot;
+    else
+        cl->link[cl->end].next = slot;
+    cl->end = slot;
+    cl->element[slot] = element;
+    cl->sequential = cl->sequential && slot == cl->length;
+    cl->length++;
+    return true;
+}
+
+/**
+ * @brief Pops a value from cllist and returns it.
+ *
+ * If pop fails, CLLIST_UNDERFLOW value is returned.
+ *
+ * There's no way to be sure that CLLIST_UNDERFLOW value was returned as a
+ * result of error, or if that exact number had actually been popped from
+ * the cllist.
+ *
+ * Thus, you should know: CLLIST_UNDERFLOW = 0x0123456789abcdeful
+ *
+ * @param cllist The cllist
+ * @return int64_t -- Popped value, if failed, CLLIST_UNDERFLOW is returned
+ */
+int64_t cllist_pop (cllist cl)
+{
+    if (cllist_isempty (cl))
+        return CLLIST_UNDERFLOW;
+    return cllist_remove (cl, cl->length - 1);
+}
+
+/**
+ * @brief Peeks to a value in cllist and returns it
+ *
+ * There's no way to be sure that CLLIST_UNDERFLOW value was returned as a
+ * result of error, or if that exact number had actually been peeked to
+ * from the cllist.
+ *
+ * Thus, you should know: CLLIST_UNDERFLOW = 0x0123456789abcdeful
+ *
+ * @param cllist The cllist
+ * @return int64_t -- Peeked value, if failed, CLLIST_UNDERFLOW is returned
+ */
+int64_t cllist_peek (cllist cl)
+{
+    if (cllist_isempty (cl))
+        return CLLIST_UNDERFLOW;
+    return cl->element[cl->end];
+}
+
+/**
+ * @brief Inserts a value to the cllist index and returns true.
+ *
+ * @param cllist The cllist
+ * @param uint64_t Index to where value is to be inserted
+ * @param int64_t Value to insert
+ * @return bool -- true if successful
+ */
+bool cllist_insert (cllist cl, uint64_t index, int64_t element)
+{
+    if (cl == NULL)
+        return false;
+    if (index > cl->length)
+        return false;
+    if (index == cl->length)
+        return cllist_append (cl, element);
+    uint32_t next_slot = cllist_getslot (cl, index);
+    uint32_t slot = cllist_newslot (cl);
+    if (slot == CLLIST_NIL)
+        return false;
+    uint32_t prev_slot = cl->link[next_slot].prev;
+    if (prev_slot == CLLIST_NIL)
+        cl->start = slot;
+    else
+        cl->link[prev_slot].next = slot;
+    cl->link[slot].prev = prev_slot;
+    cl->link[slot].next = next_slot;
+    cl->link[next_slot].prev = slot;
+    cl->element[slot] = element;
+    cl->sequential = false;
+    cl->length++;
+    return true;
+}
+
+/**
+ * @brief Removes a value from cllist index and returns it.
+ *
+ * If cllist_isempty (), returns CLLIST_UNDERFLOW = 0x0123456789abcdeful
+ * if index >= cl->length, returns CLLIST_OUTOFBOUNDS = 0xfedcba9876543210ul
+ *
+ * There's no way to be sure if any those error values were returned as a
+ * result of error, or if that exact number had actually been removed from
+ * the cllist.
+ *
+ * @param cllist The cllist
+ * @param uint64_t Index from where element is to be removed
+ * @return int64_t -- Removed value, if failed, an error value is returned
+ */
+int64_t cllist_remove (cllist cl, uint64_t index)
+{
+    if (cllist_isempty (cl))
+        return CLLIST_UNDERFLOW;
+    if (index >= cl->length)
+        return CLLIST_OUTOFBOUNDS;
+    uint32_t slot = cllist_getslot (cl, index);
+    uint32_t prev_slot = cl->link[slot].prev;
+    uint32_t next_slot = cl->link[slot].next;
+    if (prev_slot == CLLIST_NIL)
+        cl->start = next_slot;
+    else
+        cl->link[prev_slot].next = next_slot;
+    if (next_slot == CLLIST_NIL)
+        cl->end = prev_slot;
+    else
+        cl->link[next_slot].prev = prev_slot;
+    int64_t return_val = cl->element[slot];
+    cllist_freeslot (cl, slot);
+    // removing the last element keeps slots in order
+    cl->sequential = cl->sequential && next_slot == CLLIST_NIL;
+    cl->length--;
+    return return_val;
+}
+
+/**
+ * @brief Gets value from an index of cllist
+ *
+ * If cllist_isempty (), returns CLLIST_UNDERFLOW = 0x0123456789abcdeful
+ * if index >= cl->length, returns CLLIST_OUTOFBOUNDS = 0xfedcba9876543210ul
+ *
+ * There's no way to be sure if any those error values were returned as a
+ * result of error, or if that exact number had actually been present in
+ * the cllist.
+ *
+ * @param cllist The cllist
+ * @param uint64_t index The index from where value is to be returned
+ * @return int64_t -- The value
+ */
+int64_t cllist_get (cllist cl, uint64_t index)
+{
+    if (cllist_isempty (cl))
+        return CLLIST_UNDERFLOW;
+    if (index >= cl->length)
+        return CLLIST_OUTOFBOUNDS;
+    return cl->element[cllist_getslot (cl, index)];
+}
+
+/**
+ * @brief Sets value to an index of cllist
+ *
+ * @param cllist The cllist
+ * @param uint64_t index The index to where value is to be set
+ * @param int64_t value The value to be set at the index
+ * @return bool -- false if fails
+ */
+bool cllist_set (cllist cl, uint64_t index, int64_t value)
+{
+    if (cllist_isempty (cl))
+        return false;
+    if (index >= cl->length)
+        return false;
+    cl->element[cllist_getslot (cl, index)] = value;
+    return true;
+}
+
+/**
+ * @brief Renumbers slots into traversal order and releases free slots
+ *
+ * After this, slot i holds the element at index i, so positional access
+ * is O(1) and traversal is a linear sweep over the arrays, until an
+ * insertion or removal in the middle of the cllist.
+ *
+ * If allocation of the new arrays fails, the cllist is left unchanged.
+ *
+ * @param cllist The cllist
+ * @return bool -- false if fails
+ */
+bool cllist_compact (cllist cl)
+{
+    if (cl == NULL)
+        return false;
+    int64_t *element = NULL;
+    struct _cllist_link *link = NULL;
+    if (cl->length > 0) {
+        element = malloc (cl->length * sizeof (element[0]));
+        link = malloc (cl->length * sizeof (link[0]));
+        if (element == NULL || link == NULL) {
+            free (element);
+            free (link);
+            return false;
+        }
+    }
+    uint32_t slot = cl->start;
+    for (uint32_t i = 0; i < cl->length; i++) {
+        element[i] = cl->element[slot];
+        link[i].prev = i == 0 ? CLLIST_NIL : i - 1;
+        link[i].next = i == cl->length - 1 ? CLLIST_NIL : i + 1;
+        slot = cl->link[slot].next;
+    }
+    free (cl->element);
+    free (cl->link);
+    cl->element = element;
+    cl->link = link;
+    cl->start = cl->length == 0 ? CLLIST_NIL : 0;
+    cl->end = cl->length == 0 ? CLLIST_NIL : cl->length - 1;
+    cl->freetop = CLLIST_NIL;
+    cl->used = cl->length;
+    cl->capacity = cl->length;
+    cl->sequential = true;
+    return true;
+}
+
+/**
+ * @brief Loop through cllist and take action using a callback function
+ *
+ * @param cllist The cllist
+ * @param callback Function pointer to a function. The arguments of the function is an index and a pointer to the element.
+ * @return bool -- false if failed
+ */
+bool cllist_foreach (cllist cl, void (*callback)(int64_t index, int64_t *element))
+{
+    if (cllist_isempty (cl))
+        return false;
+    uint32_t next_slot = cl->start;
+    for (uint64_t i = 0; next_slot != CLLIST_NIL; i++) {
+        callback (i, &(cl->element[next_slot]));
+        next_slot = cl->link[next_slot].next;
+    }
+    return true;
+}
+
+/**
+ * @brief Prints cllist content
+ *
+ * @param cllist The cllist
+ * @return bool -- false if print failed
+ */
+bool cllist_print (cllist cl)
+{
+    if (cllist_isempty (cl))
+        return false;
+    uint32_t next_slot = cl->start;
+    while (next_slot != CLLIST_NIL) {
+        printf ("%" PRId64 " ", cl->element[next_slot]);
+        next_slot = cl->link[next_slot].next;
+    }
+    printf ("\n");
+    return true;
+}
+
+/**
+ * @brief True if empty
+ *
+ * @param cllist The cllist
+ * @return bool -- True if empty
+ */
+bool cllist_isempty (cllist cl)
+{
+    return cl == NULL || cl->length == 0;
+}
+
+/**
+ * @brief Deletes a cllist
+ *
+ * This function is basically a wrapper around free().
+ * Also sets cllist pointer to NULL.
+ *
+ * This function is recommended over free as the programmer
+ * might forget to set cllist pointer to NULL. As a result,
+ * another cllist operation will cause some undefined behaviour.
+ *
+ * @param cllist* Reference to the cllist, is set to NULL.
+ */
+void cllist_delete (cllist *cl)
+{
+    if (cl == NULL || *cl == NULL)
+        return;
+    free ((*cl)->element);
+    free ((*cl)->link);
+    free (*cl);
+    *cl = NULL;
+}
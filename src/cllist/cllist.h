@@ -0,0 +1,242 @@
+# ifndef CLLIST_H
+# define CLLIST_H 1
+
+# include <stdlib.h>
+# include <inttypes.h>
+# include <stdint.h>
+# include <stdbool.h>
+
+# define CLLIST_UNDERFLOW 0x0123456789abcdeful
+# define CLLIST_OUTOFBOUNDS 0xfedcba9876543210ul
+# define CLLIST_NIL 0xffffffffu
+
+// prev and next slot of a slot, CLLIST_NIL if none
+struct _cllist_link {
+    uint32_t prev;
+    uint32_t next;
+};
+
+struct _cllist {
+    int64_t *element;               // element of each slot
+    struct _cllist_link *link;      // links of each slot, free slots are stacked through next
+    uint32_t start;                 // slot of first element
+    uint32_t end;                   // slot of last element
+    uint32_t freetop;               // top of free slot stack
+    uint32_t used;                  // slots handed out at least once
+    uint32_t capacity;              // slots allocated
+    bool sequential;                // true if slot i holds index i
+    uint64_t length;
+};
+
+/**
+ * @brief The cllist struct
+ *
+ * A compact llist. Nodes are slots in two arrays, one holding elements
+ * and one holding 32-bit prev and next slot indices. That is 16 bytes
+ * per node instead of a 24 byte heap node plus malloc overhead, and the
+ * whole list lives in two allocations. Removed slots are kept on a free
+ * slot stack and reused by later insertions.
+ *
+ * cllist_compact renumbers slots into traversal order. Until the next
+ * insertion or removal in the middle of the list, positional access is
+ * then O(1) and scans go through memory linearly.
+ *
+ * // new cllist
+ * cllist cl = new_cllist ();
+ *
+ * // functions
+ * uint64_t cllist_getlen (cllist cl);
+ * bool cllist_append (cllist cl, int64_t element);
+ * int64_t cllist_pop (cllist cl);
+ * int64_t cllist_peek (cllist cl);
+ * bool cllist_insert (cllist cl, uint64_t index, int64_t element);
+ * int64_t cllist_remove (cllist cl, uint64_t index);
+ * int64_t cllist_get (cllist cl, uint64_t index);
+ * bool cllist_set (cllist cl, uint64_t index, int64_t value);
+ * bool cllist_compact (cllist cl);
+ * bool cllist_foreach (cllist cl, void (*callback)(int64_t index, int64_t *element));
+ * bool cllist_print (cllist cl);
+ * bool cllist_isempty (cllist cl);
+ *
+ * // deleting cllist
+ * void cllist_delete (cllist *cl);
+ *
+ * // avoid accessing following cllist members
+ * cl->element;     // cllist elements array
+ * cl->link;        // cllist links array
+ * cl->start;       // cllist first slot
+ * cl->end;         // cllist last slot
+ * cl->freetop;     // cllist free slot stack
+ * cl->used;        // cllist slots handed out
+ * cl->capacity;    // cllist slots allocated
+ * cl->sequential;  // cllist slot order
+ * cl->length;      // cllist length
+ */
+typedef struct _cllist *cllist;
+
+/**
+ * @brief Allocates a new cllist in the heap
+ *
+ * Remember to free the cllist using cllist_delete (&cl);
+ *
+ * @return cllist The cllist
+ */
+cllist new_cllist ();
+
+/**
+ * @brief Get length of the cllist
+ *
+ * If cllist is NULL, returns 0
+ *
+ * @param cl The cllist
+ * @return uint64_t The length
+ */
+uint64_t cllist_getlen (cllist cl);
+
+/**
+ * @brief Appends a value to the cllist and returns true.
+ *
+ * A cllist holds at most 0xfffffffe elements.
+ *
+ * @param cllist The cllist
+ * @param int64_t Value to append
+ * @return bool -- true if successful
+ */
+bool cllist_append (cllist cl, int64_t element);
+
+/**
+ * @brief Pops a value from cllist and returns it.
+ *
+ * If pop fails, CLLIST_UNDERFLOW value is returned.
+ *
+ * There's no way to be sure that CLLIST_UNDERFLOW value was returned as a
+ * result of error, or if that exact number had actually been popped from
+ * the cllist.
+ *
+ * Thus, you should know: CLLIST_UNDERFLOW = 0x0123456789abcdeful
+ *
+ * @param cllist The cllist
+ * @return int64_t -- Popped value, if failed, CLLIST_UNDERFLOW is returned
+ */
+int64_t cllist_pop (cllist cl);
+
+/**
+ * @brief Peeks to a value in cllist and returns it
+ *
+ * There's no way to be sure that CLLIST_UNDERFLOW value was returned as a
+ * result of error, or if that exact number had actually been peeked to
+ * from the cllist.
+ *
+ * Thus, you should know: CLLIST_UNDERFLOW = 0x0123456789abcdeful
+ *
+ * @param cllist The cllist
+ * @return int64_t -- Peeked value, if failed, CLLIST_UNDERFLOW is returned
+ */
+int64_t cllist_peek (cllist cl);
+
+/**
+ * @brief Inserts a value to the cllist index and returns true.
+ *
+ * @param cllist The cllist
+ * @param uint64_t Index to where value is to be inserted
+ * @param int64_t Value to insert
+ * @return bool -- true if successful
+ */
+bool cllist_insert (cllist cl, uint64_t index, int64_t element);
+
+/**
+ * @brief Removes a value from cllist index and returns it.
+ *
+ * If cllist_isempty (), returns CLLIST_UNDERFLOW = 0x0123456789abcdeful
+ * if index >= cl->length, returns CLLIST_OUTOFBOUNDS = 0xfedcba9876543210ul
+ *
+ * There's no way to be sure if any those error values were returned as a
+ * result of error, or if that exact number had actually been removed from
+ * the cllist.
+ *
+ * @param cllist The cllist
+ * @param uint64_t Index from where element is to be removed
+ * @return int64_t -- Removed value, if failed, an error value is returned
+ */
+int64_t cllist_remove (cllist cl, uint64_t index);
+
+/**
+ * @brief Gets value from an index of cllist
+ *
+ * If cllist_isempty (), returns CLLIST_UNDERFLOW = 0x0123456789abcdeful
+ * if index >= cl->length, returns CLLIST_OUTOFBOUNDS = 0xfedcba9876543210ul
+ *
+ * There's no way to be sure if any those error values were returned as a
+ * result of error, or if that exact number had actually been present in
+ * the cllist.
+ *
+ * @param cllist The cllist
+ * @param uint64_t index The index from where value is to be returned
+ * @return int64_t -- The value
+ */
+int64_t cllist_get (cllist cl, uint64_t index);
+
+/**
+ * @brief Sets value to an index of cllist
+ *
+ * @param cllist The cllist
+ * @param uint64_t index The index to where value is to be set
+ * @param int64_t value The value to be set at the index
+ * @return bool -- false if fails
+ */
+bool cllist_set (cllist cl, uint64_t index, int64_t value);
+
+/**
+ * @brief Renumbers slots into traversal order and releases free slots
+ *
+ * After this, slot i holds the element at index i, so positional access
+ * is O(1) and traversal is a linear sweep over the arrays, until an
+ * insertion or removal in the middle of the cllist.
+ *
+ * If allocation of the new arrays fails, the cllist is left unchanged.
+ *
+ * @param cllist The cllist
+ * @return bool -- false if fails
+ */
+bool cllist_compact (cllist cl);
+
+/**
+ * @brief Loop through cllist and take action using a callback function
+ *
+ * @param cllist The cllist
+ * @param callback Function pointer to a function. The arguments of the function is an index and a pointer to the element.
+ * @return bool -- false if failed
+ */
+bool cllist_foreach (cllist cl, void (*callback)(int64_t index, int64_t *element));
+
+/**
+ * @brief Prints cllist content
+ *
+ * @param cllist The cllist
+ * @return bool -- false if print failed
+ */
+bool cllist_print (cllist cl);
+
+/**
+ * @brief True if empty
+ *
+ * @param cllist The cllist
+ * @return bool -- True if empty
+ */
+bool cllist_isempty (cllist cl);
+
+/**
+ * @brief Deletes a cllist
+ *
+ * This function is basically a wrapper around free().
+ * Also sets cllist pointer to NULL.
+ *
+ * This function is recommended over free as the programmer
+ * might forget to set cllist pointer to NULL. As a result,
+ * another cllist operation will cause some undefined behaviour.
+ *
+ * @param cllist* Reference to the cllist, is set to NULL.
+ */
+void cllist_delete (cllist *cl);
+
+# endif
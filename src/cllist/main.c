@@ -0,0 +1,33 @@
+# include <stdio.h>
+# include "cllist.h"
+
+void callback (int64_t i, int64_t *e)
+{
+    printf ("i = %ld: %ld\n", i, *e);
+}
+
+int main ()
+{
+    cllist cl = new_cllist ();
+
+    cllist_append (cl, 45);
+    cllist_append (cl, 25);
+    cllist_append (cl, 19);
+    cllist_append (cl, 38);
+    cllist_insert (cl, 0, 90);
+    cllist_insert (cl, 2, 13);
+    cllist_remove (cl, 4);
+
+    printf ("Before compact:\n");
+    cllist_foreach (cl, callback);
+
+    // slots are renumbered to traversal order, get is now O(1)
+    cllist_compact (cl);
+    printf ("Value at i3 = %ld\n", cllist_get (cl, 3));
+
+    printf ("After compact: ");
+    cllist_print (cl);
+
+    cllist_delete (&cl);
+    return 0;
+}
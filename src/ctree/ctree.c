@@ -0,0 +1,569 @@
+# include "ctree.h"
+
+// max depth of a path a writer copies without allocating
+# define CTREE_STACKDEPTH 64
+// no reader slot taken by this thread
+# define CTREE_NOSLOT 0xffffffffu
+
+static bool ctree_nextseg (const char *path, uint64_t len, uint64_t *pos, const char **seg, uint64_t *seglen);
+static int ctree_cmpname (const char *name, uint64_t len, struct _ctree_node *node);
+static uint32_t ctree_search (struct _ctree_node *node, const char *name, uint64_t len, bool *found);
+static struct _ctree_node *ctree_newnode (const char *name, uint32_t namelen, uint32_t childcount, int64_t value);
+static void ctree_freesubtree (struct _ctree_node *node);
+static void ctree_keyinit ();
+static void ctree_releaseslot (void *slot);
+static uint32_t ctree_getslot ();
+static bool ctree_reserve (ctree ct, uint64_t count);
+static void ctree_retire (ctree ct, struct _ctree_node *node, bool subtree);
+static int64_t ctree_lookup (struct _ctree_node *node, const char *path, uint64_t len);
+static void ctree_reclaim (ctree ct);
+static bool ctree_collect (ctree ct, const char *path, uint64_t len, struct _ctree_node ***nodes,
+    uint32_t **indices, uint64_t *depth, uint64_t *found, struct _ctree_node **stacknodes, uint32_t *stackindices);
+static bool ctree_publish (ctree ct, struct _ctree_node **nodes, uint32_t *indices, uint64_t depth,
+    struct _ctree_node *child, bool insert);
+
+// reader slots taken by threads, shared by all ctrees
+static _Atomic uint64_t ctree_slots[CTREE_MAXTHREADS / 64];
+static pthread_once_t ctree_once = PTHREAD_ONCE_INIT;
+// releases the slot of a thread when it exits
+static pthread_key_t ctree_key;
+static _Thread_local uint32_t ctree_slot = CTREE_NOSLOT;
+
+/**
+ * @brief Finds next segment of a path, skipping empty segments
+ * @return bool False if there are no more segments
+ */
+static bool ctree_nextseg (const char *path, uint64_t len, uint64_t *pos, const char **seg, uint64_t *seglen)
+{
+    uint64_t i = *pos;
+    while (i < len && path[i] == '/')
+        i++;
+    if (i == len) {
+        *pos = len;
+        return false;
+    }
+    uint64_t start = i;
+    while (i < len && path[i] != '/')
+        i++;
+    *seg = path + start;
+    *seglen = i - start;
+    *pos = i;
+    return true;
+}
+
+/**
+ * @brief Compares a name to the name of a node, shorter names go first
+ */
+static int ctree_cmpname (const char *name, uint64_t len, struct _ctree_node *node)
+{
+    if (len != node->namelen)
+        return len < node->namelen ? -1 : 1;
+    return memcmp (name, node->name, len);
+}
+
+/**
+ * @brief Binary searches the children of node for a name
+ * @param found Set to true if a child has the name
+ * @return uint32_t Index of the child, or where it would be inserted
+ */
+static uint32_t ctree_search (struct _ctree_node *node, const char *name, uint64_t len, bool *found)
+{
+    uint32_t lo = 0, hi = node->childcount;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        int cmp = ctree_cmpname (name, len, node->children[mid]);
+        if (!cmp) {
+            *found = true;
+            return mid;
+        }
+        if (cmp < 0)
+            hi = mid;
+        else
+            lo = mid + 1;
+    }
+    *found = false;
+    return lo;
+}
+
+/**
+ * @brief Allocates a node with room for its children, in one allocation
+ * @return struct _ctree_node* NULL if allocation failed
+ */
+static struct _ctree_node *ctree_newnode (const char *name, uint32_t namelen, uint32_t childcount, int64_t value)
+{
+    // the name goes right after the header, the children after it, aligned
+    uint64_t nameroom = (namelen + sizeof (void *) - 1) & ~(sizeof (void *) - 1);
+    struct _ctree_node *node = malloc (sizeof (struct _ctree_node)
+        + nameroom + childcount * sizeof (struct _ctree_node *));
+    if (!node)
+        return NULL;
+    node->value = value;
+    node->childcount = childcount;
+    node->namelen = namelen;
+    node->children = (struct _ctree_node **) (node->name + nameroom);
+    memcpy (node->name, name, namelen);
+    return node;
+}
+
+/**
+ * @brief Frees a subtree that no version of the tree reaches anymore
+ *
+ * Each node is freed once its last child is, the children arrays are
+ * used to walk, so no stack is needed. Children counts are counted down
+ * as children go, the nodes are being freed anyway.
+ */
+static void ctree_freesubtree (struct _ctree_node *node)
+{
+    if (!node)
+        return;
+    // parent of each node is parked in the slot of the child being freed
+    struct _ctree_node *parent = NULL;
+    for (;;) {
+        while (node->childcount) {
+            struct _ctree_node *child = node->children[node->childcount - 1];
+            node->children[node->childcount - 1] = parent;
+            parent = node;
+            node = child;
+        }
+        free (node);
+        if (!parent)
+            return;
+        node = parent;
+        parent = node->children[--node->childcount];
+    }
+}
+
+/**
+ * @brief Creates the key that releases reader slots of exiting threads
+ */
+static void ctree_keyinit ()
+{
+    pthread_key_create (&ctree_key, ctree_releaseslot);
+}
+
+/**
+ * @brief Gives the reader slot of an exiting thread back
+ */
+static void ctree_releaseslot (void *slot)
+{
+    uint32_t s = (uintptr_t) slot - 1;
+    atomic_fetch_and (&ctree_slots[s / 64], ~(1ull << (s % 64)));
+}
+
+/**
+ * @brief Gets reader slot of the calling thread, taking a free one on first use
+ * @return uint32_t The slot, CTREE_NOSLOT if all are taken
+ */
+static uint32_t ctree_getslot ()
+{
+    if (ctree_slot != CTREE_NOSLOT)
+        return ctree_slot;
+    pthread_once (&ctree_once, ctree_keyinit);
+    for (uint32_t w = 0; w < CTREE_MAXTHREADS / 64; w++) {
+        uint64_t taken = atomic_load (&ctree_slots[w]);
+        while (~taken) {
+            uint32_t bit = __builtin_ctzll (~taken);
+            if (atomic_compare_exchange_weak (&ctree_slots[w], &taken, taken | 1ull << bit)) {
+                ctree_slot = 64 * w + bit;
+                pthread_setspecific (ctree_key, (void *) (uintptr_t) (ctree_slot + 1));
+                return ctree_slot;
+            }
+        }
+    }
+    return CTREE_NOSLOT;
+}
+
+/**
+ * @brief Makes room to retire count nodes in the current epoch, writer lock held
+ * @return bool False if allocation failed
+ */
+static bool ctree_reserve (ctree ct, uint64_t count)
+{
+    struct _ctree_retired *list = &ct->retired[atomic_load (&ct->epoch) % 3];
+    if (list->count + count <= list->capacity)
+        return true;
+    uint64_t capacity = list->capacity ? list->capacity : 64;
+    while (list->count + count > capacity)
+        capacity *= 2;
+    uintptr_t *nodes = realloc (list->nodes, capacity * sizeof (uintptr_t));
+    if (!nodes)
+        return false;
+    list->nodes = nodes;
+    list->capacity = capacity;
+    return true;
+}
+
+/**
+ * @brief Queues a node, or a whole subtree, to be freed once no reader can reach it
+ *
+ * Writer lock held, after the node was unlinked from the published
+ * version. Room must have been made with ctree_reserve.
+ */
+static void ctree_retire (ctree ct, struct _ctree_node *node, bool subtree)
+{
+    struct _ctree_retired *list = &ct->retired[atomic_load (&ct->epoch) % 3];
+    list->nodes[list->count++] = (uintptr_t) node | subtree;
+}
+
+/**
+ * @brief Moves the global epoch on if every reader has seen it, freeing what is then safe
+ *
+ * Must be called with the writer lock held.
+ */
+static void ctree_reclaim (ctree ct)
+{
+    uint64_t epoch = atomic_load (&ct->epoch);
+    for (uint32_t s = 0; s < CTREE_MAXTHREADS; s++) {
+        uint64_t announced = atomic_load (&ct->readers[s].epoch);
+        if ((announced & 1) && announced >> 1 != epoch)
+            return;
+    }
+    // retired two epochs before the new one, so no reader can still be looking
+    struct _ctree_retired *list = &ct->retired[(epoch + 1) % 3];
+    for (uint64_t i = 0; i < list->count; i++) {
+        struct _ctree_node *node = (struct _ctree_node *) (list->nodes[i] & ~(uintptr_t) 1);
+        if (list->nodes[i] & 1)
+            ctree_freesubtree (node);
+        else
+            free (node);
+    }
+    list->count = 0;
+    atomic_store (&ct->epoch, epoch + 1);
+}
+
+/**
+ * @brief Allocates a new ctree in the heap
+ *
+ * Remember to free the ctree using ctree_delete (&ct);
+ *
+ * @return ctree
+ */
+ctree new_ctree ()
+{
+    ctree ct = calloc (1, sizeof (struct _ctree));
+    if (!ct)
+        return NULL;
+    struct _ctree_node *root = ctree_newnode ("", 0, 0, 0);
+    if (!root || pthread_mutex_init (&ct->writelock, NULL)) {
+        free (root);
+        free (ct);
+        return NULL;
+    }
+    atomic_init (&ct->root, root);
+    atomic_init (&ct->epoch, 1);
+    for (uint32_t s = 0; s < CTREE_MAXTHREADS; s++)
+        atomic_init (&ct->readers[s].epoch, 0);
+    return ct;
+}
+
+/**
+ * @brief Finds the nodes along a path in the published version, writer lock held
+ * @param nodes Set to the nodes from the root, nodes[0] is the root
+ * @param indices Set to indices[i], the index of nodes[i + 1] in nodes[i]
+ *                or where the next segment would be inserted
+ * @param depth Set to the number of nodes found
+ * @param found Set to offset of first segment that doesn't exist, len if whole path exists
+ * @param stacknodes Room for CTREE_STACKDEPTH nodes, used if the path isn't deeper
+ * @param stackindices Room for CTREE_STACKDEPTH indices
+ * @return bool False if allocation failed
+ */
+static bool ctree_collect (ctree ct, const char *path, uint64_t len, struct _ctree_node ***nodes,
+    uint32_t **indices, uint64_t *depth, uint64_t *found, struct _ctree_node **stacknodes, uint32_t *stackindices)
+{
+    uint64_t cap = CTREE_STACKDEPTH, d = 0, pos = 0;
+    const char *seg;
+    uint64_t seglen;
+    *nodes = stacknodes;
+    *indices = stackindices;
+    struct _ctree_node *node = atomic_load_explicit (&ct->root, memory_order_relaxed);
+    for (;;) {
+        if (d == cap) {
+            struct _ctree_node **n = malloc (2 * cap * sizeof (struct _ctree_node *));
+            uint32_t *i = malloc (2 * cap * sizeof (uint32_t));
+            if (!n || !i) {
+                free (n);
+                free (i);
+                return false;
+            }
+            memcpy (n, *nodes, d * sizeof (struct _ctree_node *));
+            memcpy (i, *indices, d * sizeof (uint32_t));
+            if (*nodes != stacknodes) {
+                free (*nodes);
+                free (*indices);
+            }
+            *nodes = n;
+            *indices = i;
+            cap *= 2;
+        }
+        (*nodes)[d] = node;
+        uint64_t start = pos;
+        if (!ctree_nextseg (path, len, &pos, &seg, &seglen))
+            break;
+        bool exists;
+        (*indices)[d++] = ctree_search (node, seg, seglen, &exists);
+        if (!exists) {
+            *found = start;
+            *depth = d;
+            return true;
+        }
+        node = node->children[(*indices)[d - 1]];
+    }
+    *found = len;
+    *depth = d + 1;
+    return true;
+}
+
+/**
+ * @brief Copies the nodes along a path with one child replaced, inserted or removed, and publishes the copy
+ *
+ * Writer lock held, with room to retire depth nodes. The copied nodes
+ * are retired.
+ *
+ * @param nodes Nodes along the path, from the root
+ * @param indices Index of the changed child in each node
+ * @param depth Number of nodes to copy, 0 to publish child as the root
+ * @param child New child at indices[depth - 1] of nodes[depth - 1], NULL to remove that child
+ * @param insert True if child is inserted rather than replacing
+ * @return bool False if allocation failed, nothing is changed then
+ */
+static bool ctree_publish (ctree ct, struct _ctree_node **nodes, uint32_t *indices, uint64_t depth,
+    struct _ctree_node *child, bool insert)
+{
+    struct _ctree_node *made = child;
+    for (uint64_t d = depth; d-- > 0;) {
+        struct _ctree_node *old = nodes[d];
+        uint32_t index = indices[d];
+        bool last = d == depth - 1;
+        uint32_t childcount = old->childcount + (last && insert) - (last && !child);
+        struct _ctree_node *copy = ctree_newnode (old->name, old->namelen, childcount, old->value);
+        if (!copy) {
+            // free the copies made so far, the one of nodes[l] points to that of nodes[l + 1]
+            for (uint64_t l = d + 1; l < depth; l++) {
+                struct _ctree_node *below = made;
+                made = l + 1 < depth ? made->children[indices[l]] : NULL;
+                free (below);
+            }
+            return false;
+        }
+        memcpy (copy->children, old->children, index * sizeof (struct _ctree_node *));
+        if (last && !child) {
+            memcpy (copy->children + index, old->children + index + 1,
+                (old->childcount - index - 1) * sizeof (struct _ctree_node *));
+        } else {
+            uint32_t skip = last && insert ? 0 : 1;
+            copy->children[index] = made;
+            memcpy (copy->children + index + 1, old->children + index + skip,
+                (old->childcount - index - skip) * sizeof (struct _ctree_node *));
+        }
+        made = copy;
+    }
+    // readers that load the new root see it fully built
+    atomic_store (&ct->root, made);
+    for (uint64_t d = 0; d < depth; d++)
+        ctree_retire (ct, nodes[d], false);
+    return true;
+}
+
+/**
+ * @brief Sets data of a node, creating the nodes of the path as needed
+ *
+ * Copies the nodes on the path and publishes them as a new version.
+ * Writers are serialized by a lock, readers aren't blocked.
+ *
+ * @param ct The ctree
+ * @param path Path to target node, need not be null terminated
+ * @param len Length of path
+ * @param val Value to be set at target node
+ * @return bool True if successful
+ */
+bool ctree_setdata (ctree ct, const char *path, uint64_t len, int64_t val)
+{
+    if (!ct)
+        return false;
+    struct _ctree_node *stacknodes[CTREE_STACKDEPTH], **nodes;
+    uint32_t stackindices[CTREE_STACKDEPTH], *indices;
+    uint64_t depth, found;
+    bool success = false;
+    pthread_mutex_lock (&ct->writelock);
+    if (!ctree_collect (ct, path, len, &nodes, &indices, &depth, &found, stacknodes, stackindices))
+        goto unlock;
+    if (found == len) {
+        // a copy of the target with the new value takes its place
+        struct _ctree_node *target = nodes[depth - 1];
+        struct _ctree_node *copy = ctree_newnode (target->name, target->namelen, target->childcount, val);
+        if (!copy)
+            goto done;
+        memcpy (copy->children, target->children, target->childcount * sizeof (struct _ctree_node *));
+        if (!ctree_reserve (ct, depth) || !ctree_publish (ct, nodes, indices, depth - 1, copy, false)) {
+            free (copy);
+            goto done;
+        }
+        ctree_retire (ct, target, false);
+        success = true;
+        goto done;
+    }
+    // the missing segments become a new chain, linked top down
+    uint64_t pos = found, segcount = 0;
+    const char *seg;
+    uint64_t seglen;
+    while (ctree_nextseg (path, len, &pos, &seg, &seglen))
+        segcount++;
+    struct _ctree_node *first = NULL, *prev = NULL;
+    pos = found;
+    for (uint64_t i = 0; ctree_nextseg (path, len, &pos, &seg, &seglen); i++) {
+        bool last = i == segcount - 1;
+        struct _ctree_node *node = seglen > UINT32_MAX ? NULL
+            : ctree_newnode (seg, seglen, last ? 0 : 1, last ? val : 0);
+        if (!node) {
+            ctree_freesubtree (first);
+            goto done;
+        }
+        if (prev)
+            prev->children[0] = node;
+        else
+            first = node;
+        // until its child is made, the chain ends here
+        node->childcount = 0;
+        if (prev)
+            prev->childcount = 1;
+        prev = node;
+    }
+    if (!ctree_reserve (ct, depth) || !ctree_publish (ct, nodes, indices, depth, first, true)) {
+        ctree_freesubtree (first);
+        goto done;
+    }
+    success = true;
+done:
+    if (nodes != stacknodes) {
+        free (nodes);
+        free (indices);
+    }
+    ctree_reclaim (ct);
+unlock:
+    pthread_mutex_unlock (&ct->writelock);
+    return success;
+}
+
+/**
+ * @brief Looks a path up in a version of the tree
+ */
+static int64_t ctree_lookup (struct _ctree_node *node, const char *path, uint64_t len)
+{
+    uint64_t pos = 0;
+    const char *seg;
+    uint64_t seglen;
+    while (ctree_nextseg (path, len, &pos, &seg, &seglen)) {
+        bool exists;
+        uint32_t index = ctree_search (node, seg, seglen, &exists);
+        if (!exists)
+            return CTREE_ERROR;
+        node = node->children[index];
+    }
+    return node->value;
+}
+
+/**
+ * @brief Gets data of a node without taking any lock
+ *
+ * The first call from a thread takes one of CTREE_MAXTHREADS reader
+ * slots, held until the thread exits. Threads beyond that read under
+ * the writer lock.
+ *
+ * @param ct The ctree
+ * @param path Path to target node, need not be null terminated
+ * @param len Length of path
+ * @return int64_t Returns CTREE_ERROR on error
+ */
+int64_t ctree_getdata (ctree ct, const char *path, uint64_t len)
+{
+    if (!ct)
+        return CTREE_ERROR;
+    uint32_t slot = ctree_getslot ();
+    if (slot == CTREE_NOSLOT) {
+        pthread_mutex_lock (&ct->writelock);
+        int64_t value = ctree_lookup (atomic_load (&ct->root), path, len);
+        pthread_mutex_unlock (&ct->writelock);
+        return value;
+    }
+    // announce the epoch before loading the root, so a writer either sees
+    // the announcement or retired its nodes before this reader could reach them
+    struct _ctree_reader *reader = &ct->readers[slot];
+    atomic_store (&reader->epoch, atomic_load (&ct->epoch) << 1 | 1);
+    int64_t value = ctree_lookup (atomic_load (&ct->root), path, len);
+    atomic_store_explicit (&reader->epoch, 0, memory_order_release);
+    return value;
+}
+
+/**
+ * @brief Deletes a node and its subtree
+ *
+ * The root can't be removed.
+ *
+ * @param ct The ctree
+ * @param path Path to target node, need not be null terminated
+ * @param len Length of path
+ * @return bool True if successful
+ */
+bool ctree_rmnode (ctree ct, const char *path, uint64_t len)
+{
+    if (!ct)
+        return false;
+    struct _ctree_node *stacknodes[CTREE_STACKDEPTH], **nodes;
+    uint32_t stackindices[CTREE_STACKDEPTH], *indices;
+    uint64_t depth, found;
+    bool success = false;
+    pthread_mutex_lock (&ct->writelock);
+    if (!ctree_collect (ct, path, len, &nodes, &indices, &depth, &found, stacknodes, stackindices))
+        goto unlock;
+    if (found != len || depth < 2)
+        goto done;
+    if (!ctree_reserve (ct, depth) || !ctree_publish (ct, nodes, indices, depth - 1, NULL, false))
+        goto done;
+    ctree_retire (ct, nodes[depth - 1], true);
+    success = true;
+done:
+    if (nodes != stacknodes) {
+        free (nodes);
+        free (indices);
+    }
+    ctree_reclaim (ct);
+unlock:
+    pthread_mutex_unlock (&ct->writelock);
+    return success;
+}
+
+/**
+ * @brief Deletes a ctree
+ *
+ * This function is basically a wrapper around free().
+ * Also sets ctree pointer to NULL.
+ *
+ * This function is recommended over free as the programmer
+ * might forget to set ctree pointer to NULL. As a result,
+ * another ctree operation will cause some undefined behaviour.
+ * Additionally, this function is more convenient.
+ *
+ * No other thread may be using the ctree.
+ *
+ * @param ctree* Reference to the ctree, is set to NULL.
+ */
+void ctree_delete (ctree *ct)
+{
+    if (!ct || !*ct)
+        return;
+    for (int e = 0; e < 3; e++) {
+        struct _ctree_retired *list = &(*ct)->retired[e];
+        for (uint64_t i = 0; i < list->count; i++) {
+            struct _ctree_node *node = (struct _ctree_node *) (list->nodes[i] & ~(uintptr_t) 1);
+            if (list->nodes[i] & 1)
+                ctree_freesubtree (node);
+            else
+                free (node);
+        }
+        free (list->nodes);
+    }
+    ctree_freesubtree (atomic_load (&(*ct)->root));
+    pthread_mutex_destroy (&(*ct)->writelock);
+    free (*ct);
+    *ct = NULL;
+}
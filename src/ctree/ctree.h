@@ -0,0 +1,149 @@
+# ifndef CTREE_H
+# define CTREE_H 1
+
+# include <stdlib.h>
+# include <inttypes.h>
+# include <stdint.h>
+# include <stdbool.h>
+# include <string.h>
+# include <stdatomic.h>
+# include <pthread.h>
+
+# define CTREE_ERROR 0x0123456789abcdeful
+// max number of threads reading at once without a lock, more threads read under the writer lock
+# define CTREE_MAXTHREADS 128
+
+// a node of one version of the tree, never changed once published
+struct _ctree_node {
+    int64_t value;
+    uint32_t childcount;
+    uint32_t namelen;
+    struct _ctree_node **children;  // sorted by name, points into this allocation
+    char name[];                    // not null terminated
+};
+
+// epoch announced by a reading thread, on its own cache line
+struct _ctree_reader {
+    _Atomic uint64_t epoch;         // 2 * epoch + 1 while reading, 0 otherwise
+    char padding[64 - sizeof (uint64_t)];
+};
+
+// nodes waiting until no reader can reach them
+struct _ctree_retired {
+    uintptr_t *nodes;               // low bit set for a whole subtree
+    uint64_t count;
+    uint64_t capacity;
+};
+
+struct _ctree {
+    _Atomic (struct _ctree_node *) root;
+    _Atomic uint64_t epoch;                         // global epoch
+    struct _ctree_reader readers[CTREE_MAXTHREADS];
+    pthread_mutex_t writelock;                      // held by writers
+    struct _ctree_retired retired[3];               // retired in epoch e go to retired[e % 3]
+};
+
+/**
+ * @brief The ctree struct
+ *
+ * A path-keyed tree for many readers and few writers. Readers never
+ * lock or write to shared memory other than their own epoch slot:
+ * published nodes are never modified, so a reader sees one consistent
+ * version of the tree for the whole lookup.
+ *
+ * A writer takes a lock, copies the nodes on the path it changes, and
+ * publishes the new root with an atomic store. Replaced nodes are
+ * retired and freed by epoch based reclamation: nodes retired in epoch e
+ * are freed once the global epoch reaches e + 2, which can only happen
+ * after every reader that could have seen them is done.
+ *
+ * Paths are split into segments at '/', empty segments are ignored, so
+ * "/a//b/" is the same as "a/b". Intermediate nodes hold 0, as in tree.
+ *
+ * // new ctree
+ * ctree ct = new_ctree ();
+ *
+ * // functions, all of them may be called from any thread
+ * bool ctree_setdata (ctree ct, const char *path, uint64_t len, int64_t val);
+ * int64_t ctree_getdata (ctree ct, const char *path, uint64_t len);
+ * bool ctree_rmnode (ctree ct, const char *path, uint64_t len);
+ *
+ * // deleting ctree, no other thread may be using it
+ * void ctree_delete (ctree *ct);
+ *
+ * // avoid accessing following ctree members
+ * ct->root;        // ctree current version
+ * ct->epoch;       // ctree global epoch
+ * ct->readers;     // ctree epochs of readers
+ * ct->writelock;   // ctree writer lock
+ * ct->retired;     // ctree nodes waiting to be freed
+ */
+typedef struct _ctree *ctree;
+
+/**
+ * @brief Allocates a new ctree in the heap
+ *
+ * Remember to free the ctree using ctree_delete (&ct);
+ *
+ * @return ctree
+ */
+ctree new_ctree ();
+
+/**
+ * @brief Sets data of a node, creating the nodes of the path as needed
+ *
+ * Copies the nodes on the path and publishes them as a new version.
+ * Writers are serialized by a lock, readers aren't blocked.
+ *
+ * @param ct The ctree
+ * @param path Path to target node, need not be null terminated
+ * @param len Length of path
+ * @param val Value to be set at target node
+ * @return bool True if successful
+ */
+bool ctree_setdata (ctree ct, const char *path, uint64_t len, int64_t val);
+
+/**
+ * @brief Gets data of a node without taking any lock
+ *
+ * The first call from a thread takes one of CTREE_MAXTHREADS reader
+ * slots, held until the thread exits. Threads beyond that read under
+ * the writer lock.
+ *
+ * @param ct The ctree
+ * @param path Path to target node, need not be null terminated
+ * @param len Length of path
+ * @return int64_t Returns CTREE_ERROR on error
+ */
+int64_t ctree_getdata (ctree ct, const char *path, uint64_t len);
+
+/**
+ * @brief Deletes a node and its subtree
+ *
+ * The root can't be removed.
+ *
+ * @param ct The ctree
+ * @param path Path to target node, need not be null terminated
+ * @param len Length of path
+ * @return bool True if successful
+ */
+bool ctree_rmnode (ctree ct, const char *path, uint64_t len);
+
+/**
+ * @brief Deletes a ctree
+ *
+ * This function is basically a wrapper around free().
+ * Also sets ctree pointer to NULL.
+ *
+ * This function is recommended over free as the programmer
+ * might forget to set ctree pointer to NULL. As a result,
+ * another ctree operation will cause some undefined behaviour.
+ * Additionally, this function is more convenient.
+ *
+ * No other thread may be using the ctree.
+ *
+ * @param ctree* Reference to the ctree, is set to NULL.
+ */
+void ctree_delete (ctree *ct);
+
+# endif
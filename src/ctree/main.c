@@ -0,0 +1,55 @@
+# include <stdio.h>
+# include "ctree.h"
+
+# define READERS 4
+# define ROUNDS 100000
+
+ctree ct;
+_Atomic bool done;
+
+void *reader (void *arg)
+{
+    const char *path = "/config/limit";
+    uint64_t reads = 0, misses = 0;
+    // never locks, sees either the old or the new version of the path
+    while (!atomic_load (&done)) {
+        if (ctree_getdata (ct, path, strlen (path)) == CTREE_ERROR) misses++;
+        reads++;
+    }
+    printf ("reader %ld: %" PRIu64 " reads, %" PRIu64 " misses\n", (long) arg, reads, misses);
+    return NULL;
+}
+
+int main ()
+{
+    ct = new_ctree ();
+
+    const char *n1_n2_n3 = "/node1/node2/node3";
+    const char *n1_n2 = "/node1/node2";
+    const char *limit = "/config/limit";
+
+    // auto creates the nodes of the path
+    ctree_setdata (ct, n1_n2_n3, strlen (n1_n2_n3), 45);
+    ctree_setdata (ct, n1_n2, strlen (n1_n2), 19);
+    printf ("%s = %ld\n", n1_n2_n3, ctree_getdata (ct, n1_n2_n3, strlen (n1_n2_n3)));
+    printf ("%s = %ld\n", n1_n2, ctree_getdata (ct, n1_n2, strlen (n1_n2)));
+
+    ctree_rmnode (ct, n1_n2, strlen (n1_n2));
+    printf ("%s exists after removing %s: %s\n", n1_n2_n3, n1_n2,
+        ctree_getdata (ct, n1_n2_n3, strlen (n1_n2_n3)) == CTREE_ERROR ? "no" : "yes");
+
+    // one writer updates while readers look up the same path
+    ctree_setdata (ct, limit, strlen (limit), 0);
+    pthread_t threads[READERS];
+    for (long i = 0; i < READERS; i++)
+        pthread_create (&threads[i], NULL, reader, (void *) i);
+    for (int64_t i = 1; i <= ROUNDS; i++)
+        ctree_setdata (ct, limit, strlen (limit), i);
+    atomic_store (&done, true);
+    for (int i = 0; i < READERS; i++)
+        pthread_join (threads[i], NULL);
+    printf ("%s = %ld\n", limit, ctree_getdata (ct, limit, strlen (limit)));
+
+    ctree_delete (&ct);
+    return 0;
+}
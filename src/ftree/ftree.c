@@ -0,0 +1,523 @@
+# include "ftree.h"
+
+static uint64_t ftree_hash (const char *name, uint64_t len);
+static bool ftree_nextseg (const char *path, uint64_t len, uint64_t *pos, const char **seg, uint64_t *seglen);
+static uint32_t ftree_findname (ftree ft, const char *name, uint64_t len, uint32_t hash);
+static uint32_t ftree_intern (ftree ft, const char *name, uint64_t len, uint32_t hash);
+static uint64_t ftree_edgehash (uint32_t parent, uint32_t nameid);
+static uint32_t ftree_findchild (ftree ft, uint32_t parent, uint32_t nameid);
+static bool ftree_growedges (ftree ft);
+static void ftree_indexedge (ftree ft, uint32_t node);
+static void ftree_unindexedge (ftree ft, uint32_t node);
+static uint32_t ftree_newnode (ftree ft);
+static uint32_t ftree_mkchild (ftree ft, uint32_t parent, const char *seg, uint64_t seglen);
+static void ftree_unlink (ftree ft, uint32_t node);
+
+/**
+ * @brief Hashes a name using FNV-1a
+ */
+static uint64_t ftree_hash (const char *name, uint64_t len)
+{
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (uint64_t i = 0; i < len; i++) {
+        hash ^= (unsigned char) name[i];
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+/**
+ * @brief Finds next segment of a path, skipping empty segments
+ * @param path The path
+ * @param len Length of path
+ * @param pos Offset to start from, set to offset just past the segment
+ * @param seg Set to start of segment
+ * @param seglen Set to length of segment
+ * @return bool False if there are no more segments
+ */
+static bool ftree_nextseg (const char *path, uint64_t len, uint64_t *pos, const char **seg, uint64_t *seglen)
+{
+    uint64_t i = *pos;
+    while (i < len && path[i] == '/')
+        i++;
+    if (i == len) {
+        *pos = len;
+        return false;
+    }
+    uint64_t start = i;
+    while (i < len && path[i] != '/')
+        i++;
+    *seg = path + start;
+    *seglen = i - start;
+    *pos = i;
+    return true;
+}
+
+/**
+ * @brief Finds id of an interned name
+ * @return uint32_t The name id, FTREE_NIL if name isn't interned
+ */
+static uint32_t ftree_findname (ftree ft, const char *name, uint64_t len, uint32_t hash)
+{
+    if (!ft->nameindex)
+        return FTREE_NIL;
+    uint64_t mask = ft->nameindexcap - 1;
+    for (uint64_t i = hash & mask; ft->nameindex[i]; i = (i + 1) & mask) {
+        uint32_t id = ft->nameindex[i] - 1;
+        if (ft->namehash[id] == hash && ft->namelen[id] == len && !memcmp (ft->namestr[id], name, len))
+            return id;
+    }
+    return FTREE_NIL;
+}
+
+/**
+ * @brief Interns a name, copying it into the name arena if it's new
+ * @return uint32_t The name id, FTREE_NIL if allocation failed
+ */
+static uint32_t ftree_intern (ftree ft, const char *name, uint64_t len, uint32_t hash)
+{
+    uint32_t nameid = ftree_findname (ft, name, len, hash);
+    if (nameid != FTREE_NIL)
+        return nameid;
+    if (len >= FTREE_NIL || ft->namecount == FTREE_NIL - 1)
+        return FTREE_NIL;
+    // keep load factor of name index under 1/2
+    if (2 * (ft->namecount + 1) > ft->nameindexcap) {
+        uint64_t indexcap = ft->nameindexcap ? 2 * ft->nameindexcap : 64;
+        uint32_t *nameindex = calloc (indexcap, sizeof (uint32_t));
+        if (!nameindex)
+            return FTREE_NIL;
+        for (uint32_t id = 0; id < ft->namecount; id++) {
+            uint64_t i = ft->namehash[id] & (indexcap - 1);
+            while (nameindex[i])
+                i = (i + 1) & (indexcap - 1);
+            nameindex[i] = id + 1;
+        }
+        free (ft->nameindex);
+        ft->nameindex = nameindex;
+        ft->nameindexcap = indexcap;
+    }
+    if (ft->namecount == ft->namecap) {
+        uint64_t namecap = ft->namecap ? 2 * (uint64_t) ft->namecap : 64;
+        if (namecap > FTREE_NIL)
+            namecap = FTREE_NIL;
+        const char **namestr = realloc (ft->namestr, namecap * sizeof (ft->namestr[0]));
+        if (!namestr)
+            return FTREE_NIL;
+        ft->namestr = namestr;
+        uint32_t *namelen = realloc (ft->namelen, namecap * sizeof (ft->namelen[0]));
+        if (!namelen)
+            return FTREE_NIL;
+        ft->namelen = namelen;
+        uint32_t *namehash = realloc (ft->namehash, namecap * sizeof (ft->namehash[0]));
+        if (!namehash)
+            return FTREE_NIL;
+        ft->namehash = namehash;
+        ft->namecap = namecap;
+    }
+    if (ft->arenaused + len + 1 > ft->arenacap) {
+        // blocks are never moved, so names stay where they are
+        uint64_t arenacap = len + 1 > FTREE_ARENA_BLOCK ? len + 1 : FTREE_ARENA_BLOCK;
+        char *block = malloc (sizeof (char *) + arenacap);
+        if (!block)
+            return FTREE_NIL;
+        *(char **) block = ft->arena;
+        ft->arena = block;
+        ft->arenaused = 0;
+        ft->arenacap = arenacap;
+    }
+    char *str = ft->arena + sizeof (char *) + ft->arenaused;
+    memcpy (str, name, len);
+    str[len] = '\0';
+    ft->arenaused += len + 1;
+    nameid = ft->namecount++;
+    ft->namestr[nameid] = str;
+    ft->namelen[nameid] = len;
+    ft->namehash[nameid] = hash;
+    uint64_t mask = ft->nameindexcap - 1;
+    uint64_t i = hash & mask;
+    while (ft->nameindex[i])
+        i = (i + 1) & mask;
+    ft->nameindex[i] = nameid + 1;
+    return nameid;
+}
+
+/**
+ * @brief Hashes a (parent, name id) pair for the edge index
+ */
+static uint64_t ftree_edgehash (uint32_t parent, uint32_t nameid)
+{
+    uint64_t key = ((uint64_t) parent << 32 | nameid) * 0x9e3779b97f4a7c15ull;
+    return key ^ (key >> 32);
+}
+
+/**
+ * @brief Finds child of parent with a name id
+ * @return uint32_t Id of the child, FTREE_NIL if there's none
+ */
+static uint32_t ftree_findchild (ftree ft, uint32_t parent, uint32_t nameid)
+{
+    uint64_t mask = ft->edgeindexcap - 1;
+    for (uint64_t i = ftree_edgehash (parent, nameid) & mask; ft->edgeindex[i]; i = (i + 1) & mask) {
+        uint32_t node = ft->edgeindex[i] - 1;
+        if (ft->parent[node] == parent && ft->nameid[node] == nameid)
+            return node;
+    }
+    return FTREE_NIL;
+}
+
+/**
+ * @brief Doubles the edge index, keeping its load factor under 1/2
+ * @return bool False if allocation failed, index is unchanged then
+ */
+static bool ftree_growedges (ftree ft)
+{
+    uint64_t indexcap = 2 * ft->edgeindexcap;
+    uint32_t *edgeindex = calloc (indexcap, sizeof (uint32_t));
+    if (!edgeindex)
+        return false;
+    uint64_t mask = indexcap - 1;
+    for (uint64_t s = 0; s < ft->edgeindexcap; s++) {
+        if (!ft->edgeindex[s])
+            continue;
+        uint32_t node = ft->edgeindex[s] - 1;
+        uint64_t i = ftree_edgehash (ft->parent[node], ft->nameid[node]) & mask;
+        while (edgeindex[i])
+            i = (i + 1) & mask;
+        edgeindex[i] = node + 1;
+    }
+    free (ft->edgeindex);
+    ft->edgeindex = edgeindex;
+    ft->edgeindexcap = indexcap;
+    return true;
+}
+
+/**
+ * @brief Adds a node to the edge index, there must be room
+ */
+static void ftree_indexedge (ftree ft, uint32_t node)
+{
+    uint64_t mask = ft->edgeindexcap - 1;
+    uint64_t i = ftree_edgehash (ft->parent[node], ft->nameid[node]) & mask;
+    while (ft->edgeindex[i])
+        i = (i + 1) & mask;
+    ft->edgeindex[i] = node + 1;
+}
+
+/**
+ * @brief Removes a node from the edge index using backward shift deletion
+ */
+static void ftree_unindexedge (ftree ft, uint32_t node)
+{
+    uint64_t mask = ft->edgeindexcap - 1;
+    uint64_t i = ftree_edgehash (ft->parent[node], ft->nameid[node]) & mask;
+    while (ft->edgeindex[i] != node + 1)
+        i = (i + 1) & mask;
+    // move back entries that probed past the freed slot
+    for (uint64_t j = (i + 1) & mask; ft->edgeindex[j]; j = (j + 1) & mask) {
+        uint32_t other = ft->edgeindex[j] - 1;
+        uint64_t home = ftree_edgehash (ft->parent[other], ft->nameid[other]) & mask;
+        if ((j > i && (home <= i || home > j)) || (j < i && home <= i && home > j)) {
+            ft->edgeindex[i] = ft->edgeindex[j];
+            i = j;
+        }
+    }
+    ft->edgeindex[i] = 0;
+}
+
+/**
+ * @brief Takes a node id from the free node stack, or the next new one, growing the arrays if needed
+ * @return uint32_t The node id, FTREE_NIL if allocation failed
+ */
+static uint32_t ftree_newnode (ftree ft)
+{
+    if (ft->freetop != FTREE_NIL) {
+        uint32_t node = ft->freetop;
+        ft->freetop = ft->nextsibling[node];
+        return node;
+    }
+    if (ft->used == ft->capacity) {
+        // FTREE_NIL is never a node id
+        if (ft->capacity == FTREE_NIL)
+            return FTREE_NIL;
+        uint64_t capacity = ft->capacity == 0 ? 64 : 2 * (uint64_t) ft->capacity;
+        if (capacity > FTREE_NIL)
+            capacity = FTREE_NIL;
+        uint32_t **arrays[] = { &ft->firstchild, &ft->nextsibling, &ft->prevsibling, &ft->parent, &ft->nameid };
+        for (uint64_t a = 0; a < sizeof (arrays) / sizeof (arrays[0]); a++) {
+            uint32_t *grown = realloc (*arrays[a], capacity * sizeof (uint32_t));
+            if (!grown)
+                return FTREE_NIL;
+            *arrays[a] = grown;
+        }
+        int64_t *value = realloc (ft->value, capacity * sizeof (int64_t));
+        if (!value)
+            return FTREE_NIL;
+        ft->value = value;
+        ft->capacity = capacity;
+    }
+    return ft->used++;
+}
+
+/**
+ * @brief Finds child of parent named by a path segment, creating it if needed
+ *
+ * A new child becomes the first child of parent, so children are listed
+ * newest first.
+ *
+ * @return uint32_t Id of the child, FTREE_NIL if allocation failed
+ */
+static uint32_t ftree_mkchild (ftree ft, uint32_t parent, const char *seg, uint64_t seglen)
+{
+    uint32_t nameid = ftree_intern (ft, seg, seglen, ftree_hash (seg, seglen));
+    if (nameid == FTREE_NIL)
+        return FTREE_NIL;
+    uint32_t node = ftree_findchild (ft, parent, nameid);
+    if (node != FTREE_NIL)
+        return node;
+    if (2 * ((uint64_t) ft->nodecount + 1) > ft->edgeindexcap && !ftree_growedges (ft))
+        return FTREE_NIL;
+    node = ftree_newnode (ft);
+    if (node == FTREE_NIL)
+        return FTREE_NIL;
+    ft->parent[node] = parent;
+    ft->nameid[node] = nameid;
+    ft->value[node] = 0;
+    ft->firstchild[node] = FTREE_NIL;
+    ft->prevsibling[node] = FTREE_NIL;
+    ft->nextsibling[node] = ft->firstchild[parent];
+    if (ft->firstchild[parent] != FTREE_NIL)
+        ft->prevsibling[ft->firstchild[parent]] = node;
+    ft->firstchild[parent] = node;
+    ftree_indexedge (ft, node);
+    ft->nodecount++;
+    return node;
+}
+
+/**
+ * @brief Unlinks a node from the children of its parent
+ */
+static void ftree_unlink (ftree ft, uint32_t node)
+{
+    uint32_t prev = ft->prevsibling[node], next = ft->nextsibling[node];
+    if (prev != FTREE_NIL)
+        ft->nextsibling[prev] = next;
+    else
+        ft->firstchild[ft->parent[node]] = next;
+    if (next != FTREE_NIL)
+        ft->prevsibling[next] = prev;
+}
+
+/**
+ * @brief Allocates a new ftree in the heap
+ *
+ * Remember to free the ftree using ftree_delete (&ft);
+ *
+ * @return ftree
+ */
+ftree new_ftree ()
+{
+    ftree ft = calloc (1, sizeof (struct _ftree));
+    if (!ft)
+        return NULL;
+    ft->freetop = FTREE_NIL;
+    ft->edgeindexcap = 64;
+    ft->edgeindex = calloc (ft->edgeindexcap, sizeof (uint32_t));
+    uint32_t nameid = ft->edgeindex ? ftree_intern (ft, "", 0, ftree_hash ("", 0)) : FTREE_NIL;
+    if (nameid == FTREE_NIL || ftree_newnode (ft) != FTREE_ROOT) {
+        ftree_delete (&ft);
+        return NULL;
+    }
+    ft->firstchild[FTREE_ROOT] = FTREE_NIL;
+    ft->nextsibling[FTREE_ROOT] = FTREE_NIL;
+    ft->prevsibling[FTREE_ROOT] = FTREE_NIL;
+    ft->parent[FTREE_ROOT] = FTREE_NIL;
+    ft->nameid[FTREE_ROOT] = nameid;
+    ft->value[FTREE_ROOT] = 0;
+    ft->nodecount = 1;
+    return ft;
+}
+
+/**
+ * @brief Sets data of a node, creating the nodes of the path as needed
+ * @param ft The ftree
+ * @param path Path to target node, need not be null terminated
+ * @param len Length of path
+ * @param val Value to be set at target node
+ * @return bool True if successful
+ */
+bool ftree_setdata (ftree ft, const char *path, uint64_t len, int64_t val)
+{
+    if (!ft)
+        return false;
+    uint32_t node = FTREE_ROOT;
+    uint64_t pos = 0;
+    const char *seg;
+    uint64_t seglen;
+    while (ftree_nextseg (path, len, &pos, &seg, &seglen)) {
+        node = ftree_mkchild (ft, node, seg, seglen);
+        if (node == FTREE_NIL)
+            return false;
+    }
+    ft->value[node] = val;
+    return true;
+}
+
+/**
+ * @brief Gets data of a node
+ * @param ft The ftree
+ * @param path Path to target node, need not be null terminated
+ * @param len Length of path
+ * @return int64_t Returns FTREE_ERROR on error
+ */
+int64_t ftree_getdata (ftree ft, const char *path, uint64_t len)
+{
+    uint32_t node = ftree_getnode (ft, path, len);
+    if (node == FTREE_NIL)
+        return FTREE_ERROR;
+    return ft->value[node];
+}
+
+/**
+ * @brief Gets id of target node
+ * @param ft The ftree
+ * @param path Path to target node, need not be null terminated
+ * @param len Length of path
+ * @return uint32_t Returns FTREE_NIL if path doesn't exist
+ */
+uint32_t ftree_getnode (ftree ft, const char *path, uint64_t len)
+{
+    if (!ft)
+        return FTREE_NIL;
+    uint32_t node = FTREE_ROOT;
+    uint64_t pos = 0;
+    const char *seg;
+    uint64_t seglen;
+    while (ftree_nextseg (path, len, &pos, &seg, &seglen)) {
+        uint32_t nameid = ftree_findname (ft, seg, seglen, ftree_hash (seg, seglen));
+        if (nameid == FTREE_NIL)
+            return FTREE_NIL;
+        node = ftree_findchild (ft, node, nameid);
+        if (node == FTREE_NIL)
+            return FTREE_NIL;
+    }
+    return node;
+}
+
+/**
+ * @brief Deletes a node and its subtree
+ *
+ * The root can't be removed. Ids of removed nodes are reused by later
+ * insertions.
+ *
+ * @param ft The ftree
+ * @param path Path to target node, need not be null terminated
+ * @param len Length of path
+ * @return bool True if successful
+ */
+bool ftree_rmnode (ftree ft, const char *path, uint64_t len)
+{
+    uint32_t top = ftree_getnode (ft, path, len);
+    if (top == FTREE_NIL || top == FTREE_ROOT)
+        return false;
+    ftree_unlink (ft, top);
+    // frees bottom up, always taking the first child, so no stack is needed
+    uint32_t node = top;
+    for (;;) {
+        while (ft->firstchild[node] != FTREE_NIL)
+            node = ft->firstchild[node];
+        uint32_t parent = ft->parent[node], next = ft->nextsibling[node];
+        ftree_unindexedge (ft, node);
+        ft->nameid[node] = FTREE_NIL;
+        ft->nextsibling[node] = ft->freetop;
+        ft->freetop = node;
+        ft->nodecount--;
+        if (node == top)
+            break;
+        ft->firstchild[parent] = next;
+        node = next != FTREE_NIL ? next : parent;
+    }
+    return true;
+}
+
+/**
+ * @brief Gets name of a node
+ * @param ft The ftree
+ * @param node Id of node
+ * @return const char* Null terminated name, owned by the ftree, NULL if node isn't live
+ */
+const char *ftree_getname (ftree ft, uint32_t node)
+{
+    if (!ft || node >= ft->used || ft->nameid[node] == FTREE_NIL)
+        return NULL;
+    return ft->namestr[ft->nameid[node]];
+}
+
+/**
+ * @brief Gets number of nodes, the root included
+ * @param ft The ftree
+ * @return uint32_t
+ */
+uint32_t ftree_getnodecount (ftree ft)
+{
+    if (!ft)
+        return 0;
+    return ft->nodecount;
+}
+
+/**
+ * @brief Loop through all nodes in id order and take action using a callback function
+ *
+ * Visits nodes in the order they sit in memory, not in tree order.
+ *
+ * @param ft The ftree
+ * @param callback Function pointer to a function. The arguments of the function is a node id and a pointer to its value.
+ * @return bool
+ */
+bool ftree_foreach (ftree ft, void (*callback)(uint32_t node, int64_t *value))
+{
+    if (!ft)
+        return false;
+    for (uint32_t node = 0; node < ft->used; node++)
+        if (ft->nameid[node] != FTREE_NIL)
+            callback (node, &ft->value[node]);
+    return true;
+}
+
+/**
+ * @brief Deletes an ftree
+ *
+ * This function is basically a wrapper around free().
+ * Also sets ftree pointer to NULL.
+ *
+ * This function is recommended over free as the programmer
+ * might forget to set ftree pointer to NULL. As a result,
+ * another ftree operation will cause some undefined behaviour.
+ * Additionally, this function is more convenient.
+ *
+ * @param ftree* Reference to the ftree, is set to NULL.
+ */
+void ftree_delete (ftree *ft)
+{
+    if (!ft || !*ft)
+        return;
+    char *block = (*ft)->arena;
+    while (block) {
+        char *prev = *(char **) block;
+        free (block);
+        block = prev;
+    }
+    free ((*ft)->firstchild);
+    free ((*ft)->nextsibling);
+    free ((*ft)->prevsibling);
+    free ((*ft)->parent);
+    free ((*ft)->nameid);
+    free ((*ft)->value);
+    free ((*ft)->edgeindex);
+    free ((*ft)->namestr);
+    free ((*ft)->namelen);
+    free ((*ft)->namehash);
+    free ((*ft)->nameindex);
+    free (*ft);
+    *ft = NULL;
+}
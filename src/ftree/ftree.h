@@ -0,0 +1,193 @@
+# ifndef FTREE_H
+# define FTREE_H 1
+
+# include <stdlib.h>
+# include <inttypes.h>
+# include <stdint.h>
+# include <stdbool.h>
+# include <string.h>
+
+# define FTREE_ERROR 0x0123456789abcdeful
+# define FTREE_NIL 0xffffffffu
+// id of the root node
+# define FTREE_ROOT 0
+// size of each block of the name arena
+# define FTREE_ARENA_BLOCK 65536
+
+struct _ftree {
+    // one entry per node id, the arrays grow together
+    uint32_t *firstchild;       // FTREE_NIL if none
+    uint32_t *nextsibling;      // FTREE_NIL if none, free nodes are stacked through it
+    uint32_t *prevsibling;      // FTREE_NIL if none
+    uint32_t *parent;           // FTREE_NIL for the root
+    uint32_t *nameid;           // FTREE_NIL for free nodes
+    int64_t *value;
+    uint32_t used;              // node ids handed out at least once
+    uint32_t capacity;          // node ids allocated
+    uint32_t freetop;           // top of free node stack
+    uint32_t nodecount;         // live nodes, the root included
+    // hash index over (parent, name id) of nodes, each slot holds node id + 1, 0 if empty
+    uint32_t *edgeindex;
+    uint64_t edgeindexcap;
+    // interned names, one entry per name id
+    const char **namestr;       // null terminated, inside the name arena
+    uint32_t *namelen;
+    uint32_t *namehash;
+    uint32_t namecount;
+    uint32_t namecap;
+    uint32_t *nameindex;        // hash index over names, each slot holds name id + 1, 0 if empty
+    uint64_t nameindexcap;
+    char *arena;                // current arena block, starts with pointer to previous block
+    uint64_t arenaused;
+    uint64_t arenacap;
+};
+
+/**
+ * @brief The ftree struct
+ *
+ * A path-keyed tree like tree, stored as a structure of arrays. Nodes
+ * are 32-bit ids into parallel arrays of first child, next and previous
+ * sibling, parent, name id and value, so a node costs 28 bytes and no
+ * allocation of its own. New nodes take the next id, or reuse the id of
+ * a removed node, and the arrays grow by doubling.
+ *
+ * Children are found through one hash index keyed by (parent, name id),
+ * so lookups take O(1) per segment whatever the number of children.
+ * ftree_foreach sweeps the arrays in id order.
+ *
+ * Paths are split into segments at '/', empty segments are ignored, so
+ * "/a//b/" is the same as "a/b".
+ *
+ * // new ftree
+ * ftree ft = new_ftree ();
+ *
+ * // functions
+ * bool ftree_setdata (ftree ft, const char *path, uint64_t len, int64_t val);
+ * int64_t ftree_getdata (ftree ft, const char *path, uint64_t len);
+ * uint32_t ftree_getnode (ftree ft, const char *path, uint64_t len);
+ * bool ftree_rmnode (ftree ft, const char *path, uint64_t len);
+ * const char *ftree_getname (ftree ft, uint32_t node);
+ * uint32_t ftree_getnodecount (ftree ft);
+ * bool ftree_foreach (ftree ft, void (*callback)(uint32_t node, int64_t *value));
+ *
+ * // deleting ftree
+ * void ftree_delete (ftree *ft);
+ *
+ * // avoid accessing following ftree members
+ * ft->firstchild;      // ftree first child of each node
+ * ft->nextsibling;     // ftree next sibling of each node
+ * ft->prevsibling;     // ftree previous sibling of each node
+ * ft->parent;          // ftree parent of each node
+ * ft->nameid;          // ftree name id of each node
+ * ft->value;           // ftree value of each node
+ * ft->used;            // ftree node ids handed out
+ * ft->capacity;        // ftree node ids allocated
+ * ft->freetop;         // ftree free node stack
+ * ft->nodecount;       // ftree live nodes
+ * ft->edgeindex;       // ftree child lookup index
+ * ft->edgeindexcap;    // ftree child lookup index slots
+ * ft->namestr;         // ftree interned names
+ * ft->namelen;         // ftree lengths of names
+ * ft->namehash;        // ftree hashes of names
+ * ft->namecount;       // ftree number of names
+ * ft->namecap;         // ftree names allocated
+ * ft->nameindex;       // ftree name lookup index
+ * ft->nameindexcap;    // ftree name lookup index slots
+ * ft->arena;           // ftree name arena
+ * ft->arenaused;       // ftree bytes used in arena block
+ * ft->arenacap;        // ftree bytes in arena block
+ */
+typedef struct _ftree *ftree;
+
+/**
+ * @brief Allocates a new ftree in the heap
+ *
+ * Remember to free the ftree using ftree_delete (&ft);
+ *
+ * @return ftree
+ */
+ftree new_ftree ();
+
+/**
+ * @brief Sets data of a node, creating the nodes of the path as needed
+ * @param ft The ftree
+ * @param path Path to target node, need not be null terminated
+ * @param len Length of path
+ * @param val Value to be set at target node
+ * @return bool True if successful
+ */
+bool ftree_setdata (ftree ft, const char *path, uint64_t len, int64_t val);
+
+/**
+ * @brief Gets data of a node
+ * @param ft The ftree
+ * @param path Path to target node, need not be null terminated
+ * @param len Length of path
+ * @return int64_t Returns FTREE_ERROR on error
+ */
+int64_t ftree_getdata (ftree ft, const char *path, uint64_t len);
+
+/**
+ * @brief Gets id of target node
+ * @param ft The ftree
+ * @param path Path to target node, need not be null terminated
+ * @param len Length of path
+ * @return uint32_t Returns FTREE_NIL if path doesn't exist
+ */
+uint32_t ftree_getnode (ftree ft, const char *path, uint64_t len);
+
+/**
+ * @brief Deletes a node and its subtree
+ *
+ * The root can't be removed. Ids of removed nodes are reused by later
+ * insertions.
+ *
+ * @param ft The ftree
+ * @param path Path to target node, need not be null terminated
+ * @param len Length of path
+ * @return bool True if successful
+ */
+bool ftree_rmnode (ftree ft, const char *path, uint64_t len);
+
+/**
+ * @brief Gets name of a node
+ * @param ft The ftree
+ * @param node Id of node
+ * @return const char* Null terminated name, owned by the ftree, NULL if node isn't live
+ */
+const char *ftree_getname (ftree ft, uint32_t node);
+
+/**
+ * @brief Gets number of nodes, the root included
+ * @param ft The ftree
+ * @return uint32_t
+ */
+uint32_t ftree_getnodecount (ftree ft);
+
+/**
+ * @brief Loop through all nodes in id order and take action using a callback function
+ *
+ * Visits nodes in the order they sit in memory, not in tree order.
+ *
+ * @param ft The ftree
+ * @param callback Function pointer to a function. The arguments of the function is a node id and a pointer to its value.
+ * @return bool
+ */
+bool ftree_foreach (ftree ft, void (*callback)(uint32_t node, int64_t *value));
+
+/**
+ * @brief Deletes an ftree
+ *
+ * This function is basically a wrapper around free().
+ * Also sets ftree pointer to NULL.
+ *
+ * This function is recommended over free as the programmer
+ * might forget to set ftree pointer to NULL. As a result,
+ * another ftree operation will cause some undefined behaviour.
+ * Additionally, this function is more convenient.
+ *
+ * @param ftree* Reference to the ftree, is set to NULL.
+ */
+void ftree_delete (ftree *ft);
+
+# endif
@@ -0,0 +1,35 @@
+# include <stdio.h>
+# include "ftree.h"
+
+void callback (uint32_t node, int64_t *value)
+{
+    printf ("node %u = %ld\n", node, *value);
+}
+
+int main ()
+{
+    ftree ft = new_ftree ();
+
+    const char *n1_n2_n3 = "/node1/node2/node3";
+    const char *n1_n2_n4 = "/node1/node2/node4";
+    const char *n1_n2 = "/node1/node2";
+
+    // auto creates the nodes of the path
+    ftree_setdata (ft, n1_n2_n3, strlen (n1_n2_n3), 45);
+    ftree_setdata (ft, n1_n2_n4, strlen (n1_n2_n4), 25);
+    ftree_setdata (ft, n1_n2, strlen (n1_n2), 19);
+
+    uint32_t node = ftree_getnode (ft, n1_n2, strlen (n1_n2));
+    printf ("%s is node %u named %s = %ld\n", n1_n2, node, ftree_getname (ft, node),
+        ftree_getdata (ft, n1_n2, strlen (n1_n2)));
+
+    // nodes are visited in id order, a linear sweep of the arrays
+    ftree_foreach (ft, callback);
+
+    // the freed ids are reused by later insertions
+    ftree_rmnode (ft, n1_n2, strlen (n1_n2));
+    printf ("%u nodes after removing %s\n", ftree_getnodecount (ft), n1_n2);
+
+    ftree_delete (&ft);
+    return 0;
+}
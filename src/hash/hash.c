@@ -0,0 +1,349 @@
+# include "hash.h"
+# include <time.h>
+# include <sys/random.h>
+# if defined (__x86_64__) || defined (__i386__)
+# include <immintrin.h>
+# define HASH_X86 1
+# endif
+
+static uint64_t hash_read64 (const uint8_t *p);
+static uint64_t hash_read32 (const uint8_t *p);
+static uint64_t hash_mum (uint64_t a, uint64_t b);
+static uint64_t hash_fmix (uint64_t x);
+static void hash_stripes (uint64_t *acc, const uint8_t *p, uint64_t count, const uint64_t *secret);
+static void hash_scramble (uint64_t *acc, const uint64_t *secret);
+# ifdef HASH_X86
+static void hash_stripesavx2 (uint64_t *acc, const uint8_t *p, uint64_t count, const uint64_t *secret);
+static void hash_scrambleavx2 (uint64_t *acc, const uint64_t *secret);
+# endif
+
+// odd constants of hash_wy, with about as many one bits as zero bits
+static const uint64_t hash_wyprimes[4] = {
+    0xa0761d6478bd642full, 0xe7037ed1a0b428dbull, 0x8ebc6af09c88c6e3ull, 0x589965cc75374cc3ull
+};
+
+// secrets of hash_xx with seed 0, one per stripe of a block and lane, the murmur3 finalizer of multiples of 2^64 / phi
+static const uint64_t hash_xxsecret[HASH_BLOCK + 7] = {
+    0x9ca066f1a4ab2eeaull, 0xd30b054265133dd7ull, 0xd7f1515598b6b983ull,
+    0x6ae4c48206c1097eull, 0x2295674ca6a1e887ull, 0x23828c1ddf82f350ull,
+    0x3e278dca88014e2aull, 0x3defdd576ee7b7daull, 0xf882315217641bc6ull,
+    0x9abee55e7809d5c2ull, 0x19bd02b83cbc82b7ull, 0xf47686fd2a7956deull,
+    0x4dd1bdd9424ceaebull, 0x33dadf69d1479245ull, 0x36b58f9e69a74aafull,
+    0xe26c4d18580b84adull, 0x32214cfaa835f522ull, 0x2ecfd2e72f1d6ffeull,
+    0xf834c6c48e12b1feull, 0x078f7ae406f4865full, 0x1b6e65b65e56bcbcull,
+    0x42a87508eb5887feull, 0x60116b8a19f1278aull
+};
+
+/**
+ * @brief Reads 8 bytes at any alignment, in the byte order of the CPU
+ */
+static uint64_t hash_read64 (const uint8_t *p)
+{
+    uint64_t x;
+    memcpy (&x, p, 8);
+    return x;
+}
+
+/**
+ * @brief Reads 4 bytes at any alignment, in the byte order of the CPU
+ */
+static uint64_t hash_read32 (const uint8_t *p)
+{
+    uint32_t x;
+    memcpy (&x, p, 4);
+    return x;
+}
+
+/**
+ * @brief Multiplies two 64 bit numbers and folds the 128 bit product into 64 bits
+ */
+static uint64_t hash_mum (uint64_t a, uint64_t b)
+{
+    __uint128_t product = (__uint128_t) a * b;
+    return (uint64_t) product ^ (uint64_t) (product >> 64);
+}
+
+/**
+ * @brief The murmur3 finalizer, each bit of the result depends on every bit of x
+ */
+static uint64_t hash_fmix (uint64_t x)
+{
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdull;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ull;
+    x ^= x >> 33;
+    return x;
+}
+
+/**
+ * @brief Mixes count stripes of HASH_STRIPE bytes into the 8 accumulators of hash_xx
+ *
+ * Each 8 byte lane of a stripe is xored with a secret that depends on the
+ * lane and on the stripe, then its halves are multiplied together. The
+ * lane itself is also added to the neighbouring accumulator, so that no
+ * input bit is lost when a product is 0.
+ *
+ * @param secret HASH_BLOCK + 7 secrets, stripe s uses secret[s] to secret[s + 7]
+ */
+static void hash_stripes (uint64_t *acc, const uint8_t *p, uint64_t count, const uint64_t *secret)
+{
+    for (uint64_t s = 0; s < count; s++, p += HASH_STRIPE)
+        for (int i = 0; i < 8; i++) {
+            uint64_t data = hash_read64 (p + 8 * i);
+            uint64_t key = data ^ secret[s + i];
+            acc[i ^ 1] += data;
+            acc[i] += (key & 0xffffffffull) * (key >> 32);
+        }
+}
+
+/**
+ * @brief Scrambles the accumulators of hash_xx after each block, so that stripes of different blocks can't cancel out
+ */
+static void hash_scramble (uint64_t *acc, const uint64_t *secret)
+{
+    for (int i = 0; i < 8; i++) {
+        acc[i] ^= acc[i] >> 47;
+        acc[i] ^= secret[i];
+        acc[i] *= 0x9e3779b1ull;
+    }
+}
+
+# ifdef HASH_X86
+/**
+ * @brief Same as hash_stripes, 4 lanes at a time in each of two AVX2 registers
+ */
+__attribute__ ((target ("avx2")))
+static void hash_stripesavx2 (uint64_t *acc, const uint8_t *p, uint64_t count, const uint64_t *secret)
+{
+    __m256i acc0 = _mm256_loadu_si256 ((const __m256i *) acc);
+    __m256i acc1 = _mm256_loadu_si256 ((const __m256i *) (acc + 4));
+    for (uint64_t s = 0; s < count; s++, p += HASH_STRIPE) {
+        __m256i data0 = _mm256_loadu_si256 ((const __m256i *) p);
+        __m256i data1 = _mm256_loadu_si256 ((const __m256i *) (p + 32));
+        __m256i key0 = _mm256_xor_si256 (data0, _mm256_loadu_si256 ((const __m256i *) (secret + s)));
+        __m256i key1 = _mm256_xor_si256 (data1, _mm256_loadu_si256 ((const __m256i *) (secret + s + 4)));
+        // swapping the 64 bit halves of each 128 bit lane adds lane i to accumulator i ^ 1
+        acc0 = _mm256_add_epi64 (acc0, _mm256_shuffle_epi32 (data0, _MM_SHUFFLE (1, 0, 3, 2)));
+        acc1 = _mm256_add_epi64 (acc1, _mm256_shuffle_epi32 (data1, _MM_SHUFFLE (1, 0, 3, 2)));
+        acc0 = _mm256_add_epi64 (acc0, _mm256_mul_epu32 (key0, _mm256_srli_epi64 (key0, 32)));
+        acc1 = _mm256_add_epi64 (acc1, _mm256_mul_epu32 (key1, _mm256_srli_epi64 (key1, 32)));
+    }
+    _mm256_storeu_si256 ((__m256i *) acc, acc0);
+    _mm256_storeu_si256 ((__m256i *) (acc + 4), acc1);
+}
+
+/**
+ * @brief Same as hash_scramble, the 64 by 32 bit multiply is made of two 32 by 32 bit ones
+ */
+__attribute__ ((target ("avx2")))
+static void hash_scrambleavx2 (uint64_t *acc, const uint64_t *secret)
+{
+    const __m256i prime = _mm256_set1_epi64x (0x9e3779b1ull);
+    for (int i = 0; i < 8; i += 4) {
+        __m256i a = _mm256_loadu_si256 ((const __m256i *) (acc + i));
+        a = _mm256_xor_si256 (a, _mm256_srli_epi64 (a, 47));
+        a = _mm256_xor_si256 (a, _mm256_loadu_si256 ((const __m256i *) (secret + i)));
+        __m256i lo = _mm256_mul_epu32 (a, prime);
+        __m256i hi = _mm256_mul_epu32 (_mm256_srli_epi64 (a, 32), prime);
+        _mm256_storeu_si256 ((__m256i *) (acc + i), _mm256_add_epi64 (lo, _mm256_slli_epi64 (hi, 32)));
+    }
+}
+# endif
+
+/**
+ * @brief Hashes an integer with one multiply and one shift
+ *
+ * Keys that differ only in their high bits differ in the high bits of
+ * the hash only. Use hash_murmur when tables take the low bits of keys
+ * like that.
+ *
+ * @param key The key
+ * @param seed The seed, 0 for the same hashes on every run
+ * @return uint64_t
+ */
+uint64_t hash_mulxor (uint64_t key, uint64_t seed)
+{
+    uint64_t x = (key ^ seed) * 0x9e3779b97f4a7c15ull;
+    return x ^ (x >> 32);
+}
+
+/**
+ * @brief Hashes an integer using the murmur3 finalizer
+ * @param key The key
+ * @param seed The seed, 0 for the same hashes on every run
+ * @return uint64_t
+ */
+uint64_t hash_murmur (uint64_t key, uint64_t seed)
+{
+    return hash_fmix (key ^ seed);
+}
+
+/**
+ * @brief Hashes bytes one at a time using FNV-1a
+ * @param data The bytes
+ * @param len Number of bytes
+ * @param seed The seed, 0 for plain FNV-1a
+ * @return uint64_t
+ */
+uint64_t hash_fnv1a (const void *data, uint64_t len, uint64_t seed)
+{
+    const uint8_t *p = data;
+    uint64_t hash = 0xcbf29ce484222325ull ^ seed;
+    for (uint64_t i = 0; i < len; i++) {
+        hash ^= p[i];
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+/**
+ * @brief Hashes bytes 16 at a time by folding 128 bit products, in the style of wyhash
+ * @param data The bytes
+ * @param len Number of bytes
+ * @param seed The seed, 0 for the same hashes on every run
+ * @return uint64_t
+ */
+uint64_t hash_wy (const void *data, uint64_t len, uint64_t seed)
+{
+    const uint64_t *primes = hash_wyprimes;
+    const uint8_t *p = data;
+    uint64_t a, b;
+    seed ^= hash_mum (seed ^ primes[0], primes[1]);
+    if (len <= 16) {
+        // overlapping reads cover 4 to 16 bytes without a loop
+        if (len >= 4) {
+            uint64_t off = (len >> 3) << 2;
+            a = (hash_read32 (p) << 32) | hash_read32 (p + off);
+            b = (hash_read32 (p + len - 4) << 32) | hash_read32 (p + len - 4 - off);
+        } else if (len) {
+            a = ((uint64_t) p[0] << 16) | ((uint64_t) p[len >> 1] << 8) | p[len - 1];
+            b = 0;
+        } else
+            a = b = 0;
+    } else {
+        uint64_t i = len;
+        if (i > 48) {
+            // three independent chains keep the multiplier busy
+            uint64_t see1 = seed, see2 = seed;
+            do {
+                seed = hash_mum (hash_read64 (p) ^ primes[1], hash_read64 (p + 8) ^ seed);
+                see1 = hash_mum (hash_read64 (p + 16) ^ primes[2], hash_read64 (p + 24) ^ see1);
+                see2 = hash_mum (hash_read64 (p + 32) ^ primes[3], hash_read64 (p + 40) ^ see2);
+                p += 48;
+                i -= 48;
+            } while (i > 48);
+            seed ^= see1 ^ see2;
+        }
+        for (; i > 16; i -= 16, p += 16)
+            seed = hash_mum (hash_read64 (p) ^ primes[1], hash_read64 (p + 8) ^ seed);
+        a = hash_read64 (p + i - 16);
+        b = hash_read64 (p + i - 8);
+    }
+    __uint128_t product = (__uint128_t) (a ^ primes[1]) * (b ^ seed);
+    return hash_mum ((uint64_t) product ^ primes[0] ^ len, (uint64_t) (product >> 64) ^ primes[1]);
+}
+
+/**
+ * @brief Hashes bytes using 8 accumulators in the style of xxh3, with AVX2 if the CPU has it
+ *
+ * Both code paths give the same hashes. Inputs shorter than HASH_XX_MIN
+ * are hashed by hash_wy.
+ *
+ * @param data The bytes
+ * @param len Number of bytes
+ * @param seed The seed, 0 for the same hashes on every run
+ * @return uint64_t
+ */
+uint64_t hash_xx (const void *data, uint64_t len, uint64_t seed)
+{
+    if (len < HASH_XX_MIN)
+        return hash_wy (data, len, seed);
+    const uint8_t *p = data;
+    // a secret per stripe of a block, so that swapping two stripes changes the hash
+    uint64_t secret[HASH_BLOCK + 7];
+    for (int i = 0; i < HASH_BLOCK + 7; i++)
+        secret[i] = i & 1 ? hash_xxsecret[i] - seed : hash_xxsecret[i] + seed;
+    uint64_t acc[8] = {
+        hash_wyprimes[0], hash_wyprimes[1], hash_wyprimes[2], hash_wyprimes[3],
+        ~hash_wyprimes[0], ~hash_wyprimes[1], ~hash_wyprimes[2], ~hash_wyprimes[3]
+    };
+    void (*stripes) (uint64_t *, const uint8_t *, uint64_t, const uint64_t *) = hash_stripes;
+    void (*scramble) (uint64_t *, const uint64_t *) = hash_scramble;
+# ifdef HASH_X86
+    if (hash_hasavx2 ()) {
+        stripes = hash_stripesavx2;
+        scramble = hash_scrambleavx2;
+    }
+# endif
+    // the last stripe is always hashed on its own, ending at the last byte
+    uint64_t count = (len - 1) / HASH_STRIPE;
+    for (; count >= HASH_BLOCK; count -= HASH_BLOCK, p += HASH_STRIPE * HASH_BLOCK) {
+        stripes (acc, p, HASH_BLOCK, secret);
+        scramble (acc, secret + HASH_BLOCK - 1);
+    }
+    stripes (acc, p, count, secret);
+    stripes (acc, (const uint8_t *) data + len - HASH_STRIPE, 1, secret + HASH_BLOCK - 1);
+    uint64_t hash = len * hash_wyprimes[0];
+    for (int i = 0; i < 8; i += 2)
+        hash += hash_mum (acc[i] ^ secret[i], acc[i + 1] ^ secret[i + 1]);
+    return hash_fmix (hash);
+}
+
+/**
+ * @brief Gets an integer hash function
+ * @param kind HASH_INT_MULXOR or HASH_INT_MURMUR
+ * @return hash_intfn Returns NULL if kind is unknown
+ */
+hash_intfn hash_getint (int kind)
+{
+    if (kind == HASH_INT_MULXOR)
+        return hash_mulxor;
+    if (kind == HASH_INT_MURMUR)
+        return hash_murmur;
+    return NULL;
+}
+
+/**
+ * @brief Gets a byte hash function
+ * @param kind HASH_BYTES_FNV1A, HASH_BYTES_WY or HASH_BYTES_XX
+ * @return hash_bytesfn Returns NULL if kind is unknown
+ */
+hash_bytesfn hash_getbytes (int kind)
+{
+    if (kind == HASH_BYTES_FNV1A)
+        return hash_fnv1a;
+    if (kind == HASH_BYTES_WY)
+        return hash_wy;
+    if (kind == HASH_BYTES_XX)
+        return hash_xx;
+    return NULL;
+}
+
+/**
+ * @brief Gets a seed from the random source of the system, for tables whose keys aren't trusted
+ * @return uint64_t
+ */
+uint64_t hash_randomseed ()
+{
+    uint64_t seed;
+    if (getrandom (&seed, sizeof (seed), 0) == sizeof (seed))
+        return seed;
+    // no random source, the time and stack address still differ between runs
+    struct timespec ts;
+    clock_gettime (CLOCK_REALTIME, &ts);
+    return hash_fmix (ts.tv_sec * 1000000000ull + ts.tv_nsec) ^ hash_fmix ((uintptr_t) &seed);
+}
+
+/**
+ * @brief Checks if hash_xx uses AVX2 on this CPU
+ * @return bool
+ */
+bool hash_hasavx2 ()
+{
+# ifdef HASH_X86
+    return __builtin_cpu_supports ("avx2");
+# else
+    return false;
+# endif
+}
@@ -0,0 +1,144 @@
+# ifndef HASH_H
+# define HASH_H 1
+
+# include <stdlib.h>
+# include <inttypes.h>
+# include <stdint.h>
+# include <stdbool.h>
+# include <string.h>
+
+// integer hashes, see hash_getint
+# define HASH_INT_MULXOR 0
+# define HASH_INT_MURMUR 1
+// byte hashes, see hash_getbytes
+# define HASH_BYTES_FNV1A 0
+# define HASH_BYTES_WY 1
+# define HASH_BYTES_XX 2
+// bytes of input mixed by one round of the 8 accumulators of hash_xx
+# define HASH_STRIPE 64
+// number of stripes between two scrambles of the accumulators of hash_xx
+# define HASH_BLOCK 16
+// inputs shorter than this are hashed by hash_wy within hash_xx
+# define HASH_XX_MIN 256
+
+/**
+ * @brief Hash functions of integers and of bytes
+ *
+ * Every function takes a seed. With seed 0 the hashes are the same on
+ * every run, which suits tables whose keys are trusted. A table whose
+ * keys come from outside should use a seed from hash_randomseed, so that
+ * nobody can pick keys that all land in the same slots without knowing it.
+ * That holds for every function but hash_mulxor, whose multiply keeps the
+ * structure of such keys whatever the seed. None of them is a keyed
+ * cryptographic hash.
+ *
+ * The functions of a kind share a signature, so a table can take one as a
+ * hash_intfn or hash_bytesfn pointer, and hash_getint and hash_getbytes
+ * pick one by number, e.g. from a command line option.
+ *
+ * hash_mulxor is one multiply and one shift, enough for keys that are
+ * already spread out. hash_murmur is the murmur3 finalizer, each bit of
+ * its result depends on every bit of key. hash_fnv1a is a byte at a time
+ * and only here as a reference. hash_wy mixes 16 bytes at a time using
+ * 64 by 64 bit multiplies in the style of wyhash, which is fastest for
+ * short keys. hash_xx keeps 8 accumulators over stripes of HASH_STRIPE
+ * bytes in the style of xxh3, using AVX2 when the CPU has it, and is
+ * fastest for long inputs.
+ *
+ * // types
+ * typedef uint64_t (*hash_intfn) (uint64_t key, uint64_t seed);
+ * typedef uint64_t (*hash_bytesfn) (const void *data, uint64_t len, uint64_t seed);
+ *
+ * // functions
+ * uint64_t hash_mulxor (uint64_t key, uint64_t seed);
+ * uint64_t hash_murmur (uint64_t key, uint64_t seed);
+ * uint64_t hash_fnv1a (const void *data, uint64_t len, uint64_t seed);
+ * uint64_t hash_wy (const void *data, uint64_t len, uint64_t seed);
+ * uint64_t hash_xx (const void *data, uint64_t len, uint64_t seed);
+ * hash_intfn hash_getint (int kind);
+ * hash_bytesfn hash_getbytes (int kind);
+ * uint64_t hash_randomseed ();
+ * bool hash_hasavx2 ();
+ */
+typedef uint64_t (*hash_intfn) (uint64_t key, uint64_t seed);
+typedef uint64_t (*hash_bytesfn) (const void *data, uint64_t len, uint64_t seed);
+
+/**
+ * @brief Hashes an integer with one multiply and one shift
+ *
+ * Keys that differ only in their high bits differ in the high bits of
+ * the hash only. Use hash_murmur when tables take the low bits of keys
+ * like that.
+ *
+ * @param key The key
+ * @param seed The seed, 0 for the same hashes on every run
+ * @return uint64_t
+ */
+uint64_t hash_mulxor (uint64_t key, uint64_t seed);
+
+/**
+ * @brief Hashes an integer using the murmur3 finalizer
+ * @param key The key
+ * @param seed The seed, 0 for the same hashes on every run
+ * @return uint64_t
+ */
+uint64_t hash_murmur (uint64_t key, uint64_t seed);
+
+/**
+ * @brief Hashes bytes one at a time using FNV-1a
+ * @param data The bytes
+ * @param len Number of bytes
+ * @param seed The seed, 0 for plain FNV-1a
+ * @return uint64_t
+ */
+uint64_t hash_fnv1a (const void *data, uint64_t len, uint64_t seed);
+
+/**
+ * @brief Hashes bytes 16 at a time by folding 128 bit products, in the style of wyhash
+ * @param data The bytes
+ * @param len Number of bytes
+ * @param seed The seed, 0 for the same hashes on every run
+ * @return uint64_t
+ */
+uint64_t hash_wy (const void *data, uint64_t len, uint64_t seed);
+
+/**
+ * @brief Hashes bytes using 8 accumulators in the style of xxh3, with AVX2 if the CPU has it
+ *
+ * Both code paths give the same hashes. Inputs shorter than HASH_XX_MIN
+ * are hashed by hash_wy.
+ *
+ * @param data The bytes
+ * @param len Number of bytes
+ * @param seed The seed, 0 for the same hashes on every run
+ * @return uint64_t
+ */
+uint64_t hash_xx (const void *data, uint64_t len, uint64_t seed);
+
+/**
+ * @brief Gets an integer hash function
+ * @param kind HASH_INT_MULXOR or HASH_INT_MURMUR
+ * @return hash_intfn Returns NULL if kind is unknown
+ */
+hash_intfn hash_getint (int kind);
+
+/**
+ * @brief Gets a byte hash function
+ * @param kind HASH_BYTES_FNV1A, HASH_BYTES_WY or HASH_BYTES_XX
+ * @return hash_bytesfn Returns NULL if kind is unknown
+ */
+hash_bytesfn hash_getbytes (int kind);
+
+/**
+ * @brief Gets a seed from the random source of the system, for tables whose keys aren't trusted
+ * @return uint64_t
+ */
+uint64_t hash_randomseed ();
+
+/**
+ * @brief Checks if hash_xx uses AVX2 on this CPU
+ * @return bool
+ */
+bool hash_hasavx2 ();
+
+# endif
@@ -0,0 +1,167 @@
+# include <stdio.h>
+# include <math.h>
+# include <time.h>
+# include "hash.h"
+
+// number of keys of each quality test, and of buckets they are counted in
+# define KEYS 65536
+# define KEYBYTES 300
+
+// sum of all hashes of the speed tests, which would be optimised away without it
+volatile uint64_t sink;
+
+const char *intnames[] = {"mulxor", "murmur"};
+const char *bytesnames[] = {"fnv1a", "wy", "xx"};
+
+double now ()
+{
+    struct timespec ts;
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+int compare (const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *) a, y = *(const uint64_t *) b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Prints how evenly hashes spread over KEYS buckets picked by their low bits, as a table would
+ *
+ * The chi-square statistic is shown as a z score, which stays within
+ * about -3 and 3 for a random function and grows with the square root of
+ * the number of keys for a biased one.
+ */
+void quality (const char *name, const char *keys, uint64_t seed, uint64_t *hashes)
+{
+    static uint32_t counts[KEYS];
+    memset (counts, 0, sizeof (counts));
+    for (uint64_t i = 0; i < KEYS; i++)
+        counts[hashes[i] & (KEYS - 1)]++;
+    double chi = 0;
+    for (uint64_t i = 0; i < KEYS; i++)
+        chi += ((double) counts[i] - 1) * ((double) counts[i] - 1);
+    double z = (chi - (KEYS - 1)) / sqrt (2.0 * (KEYS - 1));
+    qsort (hashes, KEYS, sizeof (uint64_t), compare);
+    uint64_t collisions = 0;
+    for (uint64_t i = 1; i < KEYS; i++)
+        collisions += hashes[i] == hashes[i - 1];
+    printf ("%-8s %-14s %-6s %14.1f %12lu\n", name, keys, seed ? "random" : "0", z, collisions);
+}
+
+/**
+ * @brief Inverse of x * odd modulo 2^64, by Newton's iteration
+ */
+uint64_t inverse (uint64_t odd)
+{
+    uint64_t x = odd;
+    for (int i = 0; i < 5; i++)
+        x *= 2 - odd * x;
+    return x;
+}
+
+/**
+ * @brief Integer keys of adversarial sets
+ *
+ * "flood" keys are made by inverting hash_mulxor without a seed, so that
+ * all of its hashes end in 16 zero bits.
+ */
+uint64_t intkey (int set, uint64_t i)
+{
+    if (set == 0)
+        return i;
+    if (set == 1)
+        return i << 32;
+    if (set == 2)
+        return i << 48;
+    uint64_t y = i << 16;
+    // x ^ (x >> 32) is its own inverse
+    return (y ^ (y >> 32)) * inverse (0x9e3779b97f4a7c15ull);
+}
+
+/**
+ * @brief Byte keys of adversarial sets
+ * @return uint64_t Length of the key
+ */
+uint64_t byteskey (int set, uint64_t i, char *key)
+{
+    if (set == 0)
+        return sprintf (key, "%lu", i);
+    if (set == 1)
+        return sprintf (key, "/usr/share/doc/package/very/deep/path/%08lu", i);
+    // long zero keys, as long as hash_xx's own path, that differ in 2 bytes
+    memset (key, 0, KEYBYTES);
+    key[KEYBYTES / 2] = i;
+    key[KEYBYTES / 2 + 1] = i >> 8;
+    return KEYBYTES;
+}
+
+int main (int argc, char **argv)
+{
+    uint64_t seed = hash_randomseed ();
+    uint64_t sum = 0;
+
+    printf ("hash_xx uses %s\n", hash_hasavx2 () ? "AVX2" : "scalar code");
+    printf ("xx of \"hello\" = %016lx, seeded = %016lx\n", hash_xx ("hello", 5, 0), hash_xx ("hello", 5, seed));
+
+    // speed of integer hashes, through a pointer as a table would call them
+    printf ("\n%-8s %14s\n", "hash", "ns per key");
+    for (int kind = HASH_INT_MULXOR; kind <= HASH_INT_MURMUR; kind++) {
+        hash_intfn hash = hash_getint (kind);
+        uint64_t n = 100000000;
+        double start = now ();
+        for (uint64_t i = 0; i < n; i++)
+            sum += hash (i, seed);
+        printf ("%-8s %14.2f\n", intnames[kind], (now () - start) / n);
+    }
+
+    // speed of byte hashes over each input size, total bytes given as first argument
+    uint64_t total = argc > 1 ? strtoull (argv[1], NULL, 10) : 1ull << 30;
+    uint64_t sizes[] = {8, 16, 64, 256, 4096, 1 << 20};
+    // 7 bytes past the largest size, so that every size can start at any alignment
+    uint8_t *data = malloc ((1 << 20) + 7);
+    for (uint64_t i = 0; i < (1 << 20) + 7; i++)
+        data[i] = (i * 2654435761u) >> 13;
+    printf ("\n%-8s", "hash");
+    for (int s = 0; s < 6; s++)
+        printf (" %10lu B", sizes[s]);
+    printf ("   GB/s\n");
+    for (int kind = HASH_BYTES_FNV1A; kind <= HASH_BYTES_XX; kind++) {
+        hash_bytesfn hash = hash_getbytes (kind);
+        printf ("%-8s", bytesnames[kind]);
+        for (int s = 0; s < 6; s++) {
+            uint64_t n = total / sizes[s] / (kind == HASH_BYTES_FNV1A ? 8 : 1);
+            double start = now ();
+            for (uint64_t i = 0; i < n; i++)
+                sum += hash (data + (i & 7), sizes[s], seed);
+            printf (" %12.2f", (double) n * sizes[s] / (now () - start));
+        }
+        printf ("\n");
+    }
+    free (data);
+
+    // quality over adversarial key sets, with and without a seed
+    static uint64_t hashes[KEYS];
+    const char *intsets[] = {"sequential", "stride 2^32", "stride 2^48", "flood mulxor"};
+    printf ("\n%-8s %-14s %-6s %14s %12s\n", "hash", "keys", "seed", "chi-square z", "collisions");
+    for (int kind = HASH_INT_MULXOR; kind <= HASH_INT_MURMUR; kind++)
+        for (int set = 0; set < 4; set++)
+            for (int seeded = 0; seeded < 2; seeded++) {
+                for (uint64_t i = 0; i < KEYS; i++)
+                    hashes[i] = hash_getint (kind) (intkey (set, i), seeded ? seed : 0);
+                quality (intnames[kind], intsets[set], seeded ? seed : 0, hashes);
+            }
+    char key[KEYBYTES];
+    const char *bytessets[] = {"decimal", "shared prefix", "long sparse"};
+    for (int kind = HASH_BYTES_FNV1A; kind <= HASH_BYTES_XX; kind++)
+        for (int set = 0; set < 3; set++)
+            for (int seeded = 0; seeded < 2; seeded++) {
+                for (uint64_t i = 0; i < KEYS; i++)
+                    hashes[i] = hash_getbytes (kind) (key, byteskey (set, i, key), seeded ? seed : 0);
+                quality (bytesnames[kind], bytessets[set], seeded ? seed : 0, hashes);
+            }
+
+    sink = sum;
+    return 0;
+}
@@ -0,0 +1,1137 @@
+# include "htable.h"
+# ifdef __SSE2__
+# include <emmintrin.h>
+# endif
+
+static uint64_t htable_hash (htable t, int64_t key);
+static uint64_t htable_thresholdof (uint64_t capacity, double maxload);
+static uint64_t htable_capacityfor (uint64_t count, double maxload, uint64_t capacity);
+static bool htable_insertat (struct _htable_slot *slots, uint8_t *dists, uint64_t mask, uint64_t i, uint64_t dist, int64_t key, int64_t value);
+static bool htable_place (struct _htable_slot *slots, uint8_t *dists, uint64_t mask, uint64_t hash, int64_t key, int64_t value);
+static bool htable_alloctable (htable t, uint64_t capacity);
+static void htable_freetable (htable t);
+static bool htable_resize (htable ht, uint64_t capacity);
+static uint64_t htable_find (htable ht, int64_t key);
+static bool htable_isfull (htable ht, uint64_t i);
+static uint32_t htable_groupmatch (const uint8_t *group, uint8_t byte);
+static uint32_t htable_groupfree (const uint8_t *group);
+static void htable_setctrl (uint8_t *ctrl, uint64_t capacity, uint64_t i, uint8_t byte);
+static uint64_t htable_swissfree (uint8_t *ctrl, uint64_t capacity, uint64_t hash);
+static uint64_t htable_swissfind (htable ht, int64_t key);
+static bool htable_swissset (htable ht, int64_t key, int64_t value);
+static void htable_cuckoobuckets (uint64_t hash, uint64_t capacity, uint64_t *b1, uint64_t *b2);
+static uint64_t htable_cuckoofind (htable ht, int64_t key);
+static uint64_t htable_cuckoopath (htable t, uint64_t b1, uint64_t b2);
+static bool htable_cuckooset (htable ht, int64_t key, int64_t value);
+static bool htable_tryput (htable t, int64_t key, int64_t value);
+static uint64_t htable_findslot (htable t, int64_t key);
+static struct _htable_slot *htable_lookupin (htable t, int64_t key);
+static struct _htable_slot *htable_lookup (htable ht, int64_t key);
+static void htable_removeat (htable t, uint64_t i);
+static bool htable_removekey (htable t, int64_t key);
+static bool htable_putnew (htable t, int64_t key, int64_t value);
+static uint64_t htable_total (htable ht);
+static bool htable_grow (htable ht, uint64_t capacity);
+static bool htable_startmigration (htable ht, uint64_t capacity);
+static bool htable_migratestep (htable ht, uint64_t count);
+static uint64_t htable_probelen (htable t, int64_t key, bool *found);
+static void htable_foreachin (htable t, void (*callback)(int64_t key, int64_t *value));
+
+/**
+ * @brief Hashes a key using the hash function of the table, the murmur3 finalizer by default so that low bits depend on all bits of key
+ */
+static uint64_t htable_hash (htable t, int64_t key)
+{
+    if (t->hash)
+        return t->hash (key, t->seed);
+    uint64_t x = key ^ t->seed;
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdull;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ull;
+    x ^= x >> 33;
+    return x;
+}
+
+/**
+ * @brief Max number of entries for a capacity, at least one slot is always left empty
+ */
+static uint64_t htable_thresholdof (uint64_t capacity, double maxload)
+{
+    uint64_t threshold = capacity * maxload;
+    return threshold < capacity ? threshold : capacity - 1;
+}
+
+/**
+ * @brief Smallest power of 2, not less than capacity, that fits count entries
+ * @return uint64_t The capacity, 0 if it's too large
+ */
+static uint64_t htable_capacityfor (uint64_t count, double maxload, uint64_t capacity)
+{
+    while (htable_thresholdof (capacity, maxload) < count) {
+        if (capacity > UINT64_MAX / 2 / sizeof (struct _htable_slot))
+            return 0;
+        capacity *= 2;
+    }
+    return capacity;
+}
+
+/**
+ * @brief Puts a new entry at slot i, shifting the entries from i to the next empty slot forward by one
+ *
+ * Slot i must be the first slot of the probe sequence of key whose entry
+ * is closer to its home than dist.
+ *
+ * @param i Slot of the entry
+ * @param dist Probe distance + 1 of the entry at slot i
+ * @return bool False if a probe distance would exceed HTABLE_MAXDIST, nothing is changed then
+ */
+static bool htable_insertat (struct _htable_slot *slots, uint8_t *dists, uint64_t mask, uint64_t i, uint64_t dist, int64_t key, int64_t value)
+{
+    if (dist > HTABLE_MAXDIST)
+        return false;
+    uint64_t j = i;
+    while (dists[j]) {
+        if (dists[j] == HTABLE_MAXDIST)
+            return false;
+        j = (j + 1) & mask;
+    }
+    while (j != i) {
+        uint64_t k = (j - 1) & mask;
+        slots[j] = slots[k];
+        dists[j] = dists[k] + 1;
+        j = k;
+    }
+    slots[i].key = key;
+    slots[i].value = value;
+    dists[i] = dist;
+    return true;
+}
+
+/**
+ * @brief Inserts an entry whose key isn't in the slots
+ * @return bool False if a probe distance would exceed HTABLE_MAXDIST
+ */
+static bool htable_place (struct _htable_slot *slots, uint8_t *dists, uint64_t mask, uint64_t hash, int64_t key, int64_t value)
+{
+    uint64_t i = hash & mask;
+    uint64_t dist = 1;
+    while (dists[i] >= dist) {
+        i = (i + 1) & mask;
+        dist++;
+    }
+    return htable_insertat (slots, dists, mask, i, dist, key, value);
+}
+
+/**
+ * @brief Allocates empty slots for a table, replacing none of its arrays on failure
+ *
+ * Slots are aligned to a cache line so that a cuckoo bucket never spans two.
+ *
+ * @param capacity Number of slots, a power of 2
+ * @return bool False if allocation fails
+ */
+static bool htable_alloctable (htable t, uint64_t capacity)
+{
+    struct _htable_slot *slots = aligned_alloc (64, capacity * sizeof (struct _htable_slot));
+    uint8_t *dists = NULL;
+    uint8_t *ctrl = NULL;
+    if (t->engine == HTABLE_ROBINHOOD)
+        dists = calloc (capacity, sizeof (uint8_t));
+    else if ((ctrl = malloc (capacity + HTABLE_GROUP - 1)))
+        memset (ctrl, HTABLE_CTRL_EMPTY, capacity + HTABLE_GROUP - 1);
+    if (!slots || (!dists && !ctrl)) {
+        free (slots);
+        free (dists);
+        free (ctrl);
+        return false;
+    }
+    t->slots = slots;
+    t->dists = dists;
+    t->ctrl = ctrl;
+    t->capacity = capacity;
+    t->deleted = 0;
+    t->stashed = 0;
+    t->threshold = htable_thresholdof (capacity, t->maxload);
+    return true;
+}
+
+/**
+ * @brief Frees the arrays of a table
+ */
+static void htable_freetable (htable t)
+{
+    free (t->slots);
+    free (t->dists);
+    free (t->ctrl);
+}
+
+/**
+ * @brief Moves all entries to a new array of slots
+ *
+ * If the entries don't fit, within HTABLE_MAXDIST for the robin hood
+ * engine or without overflowing the stash for the cuckoo engine, tries
+ * twice the capacity. Also drops deleted marks of the swiss engine.
+ *
+ * @param capacity Number of slots, a power of 2
+ * @return bool False if allocation fails, the htable is unchanged then
+ */
+static bool htable_resize (htable ht, uint64_t capacity)
+{
+    while (capacity) {
+        struct _htable t = *ht;
+        if (!htable_alloctable (&t, capacity))
+            return false;
+        bool placed = true;
+        for (uint64_t i = 0; i < ht->capacity && placed; i++)
+            if (htable_isfull (ht, i))
+                placed = htable_tryput (&t, ht->slots[i].key, ht->slots[i].value);
+        for (uint64_t k = 0; k < ht->stashed && placed; k++)
+            placed = htable_tryput (&t, ht->stash[k].key, ht->stash[k].value);
+        if (placed) {
+            htable_freetable (ht);
+            *ht = t;
+            return true;
+        }
+        htable_freetable (&t);
+        capacity = htable_capacityfor (0, ht->maxload, capacity * 2);
+    }
+    return false;
+}
+
+/**
+ * @brief Finds slot of a key
+ * @return uint64_t The slot, ht->capacity if key isn't found
+ */
+static uint64_t htable_find (htable ht, int64_t key)
+{
+    uint64_t mask = ht->capacity - 1;
+    uint64_t i = htable_hash (ht, key) & mask;
+    uint64_t dist = 1;
+    // entries of key's probe sequence are never closer to their home than key would be
+    while (ht->dists[i] >= dist) {
+        if (ht->dists[i] == dist && ht->slots[i].key == key)
+            return i;
+        i = (i + 1) & mask;
+        dist++;
+    }
+    return ht->capacity;
+}
+
+/**
+ * @brief Checks if slot i holds an entry
+ */
+static bool htable_isfull (htable ht, uint64_t i)
+{
+    if (ht->engine != HTABLE_ROBINHOOD)
+        return ht->ctrl[i] < HTABLE_CTRL_EMPTY;
+    return ht->dists[i];
+}
+
+/**
+ * @brief Finds the control bytes of a group equal to byte
+ * @return uint32_t Bit i is set if byte i of group matches
+ */
+static uint32_t htable_groupmatch (const uint8_t *group, uint8_t byte)
+{
+# ifdef __SSE2__
+    __m128i ctrl = _mm_loadu_si128 ((const __m128i *) group);
+    return _mm_movemask_epi8 (_mm_cmpeq_epi8 (ctrl, _mm_set1_epi8 (byte)));
+# else
+    uint32_t mask = 0;
+    for (int i = 0; i < HTABLE_GROUP; i++)
+        mask |= (uint32_t) (group[i] == byte) << i;
+    return mask;
+# endif
+}
+
+/**
+ * @brief Finds the empty or deleted slots of a group, whose control bytes have the high bit set
+ * @return uint32_t Bit i is set if slot i of group is free
+ */
+static uint32_t htable_groupfree (const uint8_t *group)
+{
+# ifdef __SSE2__
+    return _mm_movemask_epi8 (_mm_loadu_si128 ((const __m128i *) group));
+# else
+    uint32_t mask = 0;
+    for (int i = 0; i < HTABLE_GROUP; i++)
+        mask |= (uint32_t) (group[i] >> 7) << i;
+    return mask;
+# endif
+}
+
+/**
+ * @brief Sets control byte of slot i, and its copy past the end so that groups can wrap around
+ */
+static void htable_setctrl (uint8_t *ctrl, uint64_t capacity, uint64_t i, uint8_t byte)
+{
+    ctrl[i] = byte;
+    if (i < HTABLE_GROUP - 1)
+        ctrl[capacity + i] = byte;
+}
+
+/**
+ * @brief Finds the first empty or deleted slot on the probe sequence of hash
+ *
+ * Groups start at the home slot and move by 1, 2, 3... groups, which
+ * visits every group as capacity is a power of 2. There's always a free
+ * slot as the number of entries is kept under capacity.
+ *
+ * @return uint64_t The slot
+ */
+static uint64_t htable_swissfree (uint8_t *ctrl, uint64_t capacity, uint64_t hash)
+{
+    uint64_t mask = capacity - 1;
+    uint64_t pos = (hash >> 7) & mask;
+    for (uint64_t step = HTABLE_GROUP; ; step += HTABLE_GROUP) {
+        uint32_t avail = htable_groupfree (ctrl + pos);
+        if (avail)
+            return (pos + __builtin_ctz (avail)) & mask;
+        pos = (pos + step) & mask;
+    }
+}
+
+/**
+ * @brief Finds slot of a key in a swiss htable
+ * @return uint64_t The slot, ht->capacity if key isn't found
+ */
+static uint64_t htable_swissfind (htable ht, int64_t key)
+{
+    uint64_t hash = htable_hash (ht, key);
+    uint64_t mask = ht->capacity - 1;
+    uint64_t pos = (hash >> 7) & mask;
+    for (uint64_t step = HTABLE_GROUP; ; step += HTABLE_GROUP) {
+        const uint8_t *group = ht->ctrl + pos;
+        for (uint32_t match = htable_groupmatch (group, hash & 0x7f); match; match &= match - 1) {
+            uint64_t i = (pos + __builtin_ctz (match)) & mask;
+            if (ht->slots[i].key == key)
+                return i;
+        }
+        // an insertion would have used the empty slot, so key isn't further along
+        if (htable_groupmatch (group, HTABLE_CTRL_EMPTY))
+            return ht->capacity;
+        pos = (pos + step) & mask;
+    }
+}
+
+/**
+ * @brief Sets value of a key in a swiss htable
+ * @return bool True if successful
+ */
+static bool htable_swissset (htable ht, int64_t key, int64_t value)
+{
+    struct _htable_slot *slot = htable_lookup (ht, key);
+    if (slot) {
+        slot->value = value;
+        return true;
+    }
+    uint64_t hash = htable_hash (ht, key);
+    uint64_t i = htable_swissfree (ht->ctrl, ht->capacity, hash);
+    // deleted slots count towards the load as probes don't stop at them
+    uint64_t total = htable_total (ht);
+    if (ht->ctrl[i] == HTABLE_CTRL_EMPTY && total + ht->deleted >= ht->threshold) {
+        // rehash in place if deleted slots take most of the room, grow otherwise
+        if (total < ht->threshold / 2)
+            return htable_resize (ht, ht->capacity) && htable_putnew (ht, key, value);
+        uint64_t capacity = htable_capacityfor (total + 1, ht->maxload, ht->capacity * 2);
+        return capacity && htable_grow (ht, capacity) && htable_putnew (ht, key, value);
+    }
+    if (ht->ctrl[i] == HTABLE_CTRL_DELETED)
+        ht->deleted--;
+    htable_setctrl (ht->ctrl, ht->capacity, i, hash & 0x7f);
+    ht->slots[i].key = key;
+    ht->slots[i].value = value;
+    ht->length++;
+    return true;
+}
+
+/**
+ * @brief Picks the two buckets of a hash for the cuckoo engine, from its low and high halves
+ *
+ * The 7 bit tag in the control byte comes from the top bits, so it stays
+ * independent of both buckets unless there are over 2^25 of them.
+ */
+static void htable_cuckoobuckets (uint64_t hash, uint64_t capacity, uint64_t *b1, uint64_t *b2)
+{
+    uint64_t mask = capacity / HTABLE_BUCKET - 1;
+    *b1 = hash & mask;
+    *b2 = (hash >> 32) & mask;
+    // the two buckets must differ, or an entry could never be evicted
+    if (*b2 == *b1)
+        *b2 = *b1 ^ 1;
+}
+
+/**
+ * @brief Finds slot of a key in a cuckoo htable, not looking in the stash
+ * @return uint64_t The slot, ht->capacity if key isn't in a bucket
+ */
+static uint64_t htable_cuckoofind (htable ht, int64_t key)
+{
+    uint64_t hash = htable_hash (ht, key);
+    uint8_t tag = hash >> 57;
+    uint64_t b[2];
+    htable_cuckoobuckets (hash, ht->capacity, &b[0], &b[1]);
+    for (int k = 0; k < 2; k++)
+        for (uint64_t i = b[k] * HTABLE_BUCKET; i < (b[k] + 1) * HTABLE_BUCKET; i++)
+            if (ht->ctrl[i] == tag && ht->slots[i].key == key)
+                return i;
+    return ht->capacity;
+}
+
+/**
+ * @brief Frees a slot in bucket b1 or b2 by moving entries to their other bucket
+ *
+ * Searches breadth first, so the fewest entries are moved, through at most
+ * HTABLE_CUCKOO_MAXNODES buckets and paths of HTABLE_CUCKOO_MAXMOVES moves.
+ * A path never visits a bucket twice. Entries are moved starting from the
+ * end of the path, so every entry is in one of its buckets at all times.
+ *
+ * @return uint64_t The free slot, t->capacity if no path is found and nothing is moved
+ */
+static uint64_t htable_cuckoopath (htable t, uint64_t b1, uint64_t b2)
+{
+    struct _htable_cuckoonode nodes[HTABLE_CUCKOO_MAXNODES];
+    nodes[0] = (struct _htable_cuckoonode) {b1, -1, 0, 0};
+    nodes[1] = (struct _htable_cuckoonode) {b2, -1, 0, 0};
+    int32_t tail = 2;
+    for (int32_t head = 0; head < tail; head++) {
+        uint64_t base = nodes[head].bucket * HTABLE_BUCKET;
+        for (uint64_t avail = base; avail < base + HTABLE_BUCKET; avail++) {
+            if (t->ctrl[avail] != HTABLE_CTRL_EMPTY)
+                continue;
+            for (int32_t n = head; nodes[n].parent >= 0; n = nodes[n].parent) {
+                uint64_t from = nodes[nodes[n].parent].bucket * HTABLE_BUCKET + nodes[n].slot;
+                t->slots[avail] = t->slots[from];
+                t->ctrl[avail] = t->ctrl[from];
+                avail = from;
+            }
+            t->ctrl[avail] = HTABLE_CTRL_EMPTY;
+            return avail;
+        }
+        if (nodes[head].depth == HTABLE_CUCKOO_MAXMOVES)
+            continue;
+        for (uint8_t slot = 0; slot < HTABLE_BUCKET && tail < HTABLE_CUCKOO_MAXNODES; slot++) {
+            uint64_t a, b;
+            htable_cuckoobuckets (htable_hash (t, t->slots[base + slot].key), t->capacity, &a, &b);
+            uint64_t other = a == nodes[head].bucket ? b : a;
+            int32_t n = head;
+            while (n >= 0 && nodes[n].bucket != other)
+                n = nodes[n].parent;
+            if (n < 0)
+                nodes[tail++] = (struct _htable_cuckoonode) {other, head, slot, nodes[head].depth + 1};
+        }
+    }
+    return t->capacity;
+}
+
+/**
+ * @brief Sets value of a key in a cuckoo htable
+ * @return bool True if successful
+ */
+static bool htable_cuckooset (htable ht, int64_t key, int64_t value)
+{
+    struct _htable_slot *slot = htable_lookup (ht, key);
+    if (slot) {
+        slot->value = value;
+        return true;
+    }
+    uint64_t total = htable_total (ht);
+    if (total < ht->threshold && htable_tryput (ht, key, value)) {
+        ht->length++;
+        return true;
+    }
+    uint64_t capacity = htable_capacityfor (total + 1, ht->maxload, ht->capacity * 2);
+    return capacity && htable_grow (ht, capacity) && htable_putnew (ht, key, value);
+}
+
+/**
+ * @brief Puts an entry whose key isn't in one table into it, without growing it or counting the entry
+ * @return bool False if the entry doesn't fit, within HTABLE_MAXDIST or the stash, nothing is changed then
+ */
+static bool htable_tryput (htable t, int64_t key, int64_t value)
+{
+    if (t->engine == HTABLE_ROBINHOOD)
+        return htable_place (t->slots, t->dists, t->capacity - 1, htable_hash (t, key), key, value);
+    uint64_t hash = htable_hash (t, key);
+    uint64_t i;
+    if (t->engine == HTABLE_SWISS) {
+        i = htable_swissfree (t->ctrl, t->capacity, hash);
+        if (t->ctrl[i] == HTABLE_CTRL_DELETED)
+            t->deleted--;
+        htable_setctrl (t->ctrl, t->capacity, i, hash & 0x7f);
+    } else {
+        uint64_t b1, b2;
+        htable_cuckoobuckets (hash, t->capacity, &b1, &b2);
+        i = htable_cuckoopath (t, b1, b2);
+        if (i == t->capacity) {
+            if (t->stashed == HTABLE_STASH)
+                return false;
+            t->stash[t->stashed].key = key;
+            t->stash[t->stashed++].value = value;
+            return true;
+        }
+        t->ctrl[i] = hash >> 57;
+    }
+    t->slots[i].key = key;
+    t->slots[i].value = value;
+    return true;
+}
+
+/**
+ * @brief Finds slot of a key in one table, whatever its engine
+ * @return uint64_t The slot, t->capacity if key isn't found
+ */
+static uint64_t htable_findslot (htable t, int64_t key)
+{
+    if (t->engine == HTABLE_SWISS)
+        return htable_swissfind (t, key);
+    if (t->engine == HTABLE_CUCKOO)
+        return htable_cuckoofind (t, key);
+    return htable_find (t, key);
+}
+
+/**
+ * @brief Finds slot of a key in one table, or its place in the stash
+ * @return struct _htable_slot* The slot, NULL if key isn't found
+ */
+static struct _htable_slot *htable_lookupin (htable t, int64_t key)
+{
+    uint64_t i = htable_findslot (t, key);
+    if (i != t->capacity)
+        return &t->slots[i];
+    for (uint64_t k = 0; k < t->stashed; k++)
+        if (t->stash[k].key == key)
+            return &t->stash[k];
+    return NULL;
+}
+
+/**
+ * @brief Finds slot of a key, in the old table too if the htable is growing
+ * @return struct _htable_slot* The slot, NULL if key isn't found
+ */
+static struct _htable_slot *htable_lookup (htable ht, int64_t key)
+{
+    struct _htable_slot *slot = htable_lookupin (ht, key);
+    if (slot || !ht->old)
+        return slot;
+    return htable_lookupin (ht->old, key);
+}
+
+/**
+ * @brief Removes entry at slot i of one table
+ */
+static void htable_removeat (htable t, uint64_t i)
+{
+    uint64_t mask = t->capacity - 1;
+    t->length--;
+    if (t->engine == HTABLE_SWISS) {
+        uint32_t after = htable_groupmatch (t->ctrl + i, HTABLE_CTRL_EMPTY);
+        uint32_t before = htable_groupmatch (t->ctrl + ((i - HTABLE_GROUP) & mask), HTABLE_CTRL_EMPTY);
+        // if less than a group of full slots surrounds i, no probe went past i without stopping
+        if (after && before && __builtin_ctz (after) + __builtin_clz (before) - (32 - HTABLE_GROUP) < HTABLE_GROUP)
+            htable_setctrl (t->ctrl, t->capacity, i, HTABLE_CTRL_EMPTY);
+        else {
+            htable_setctrl (t->ctrl, t->capacity, i, HTABLE_CTRL_DELETED);
+            t->deleted++;
+        }
+        return;
+    }
+    if (t->engine == HTABLE_CUCKOO) {
+        t->ctrl[i] = HTABLE_CTRL_EMPTY;
+        // give the slot to a stashed entry that may live in its bucket
+        uint64_t bucket = i / HTABLE_BUCKET;
+        for (uint64_t k = 0; k < t->stashed; k++) {
+            uint64_t hash = htable_hash (t, t->stash[k].key);
+            uint64_t b1, b2;
+            htable_cuckoobuckets (hash, t->capacity, &b1, &b2);
+            if (b1 == bucket || b2 == bucket) {
+                t->ctrl[i] = hash >> 57;
+                t->slots[i] = t->stash[k];
+                t->stash[k] = t->stash[--t->stashed];
+                break;
+            }
+        }
+        return;
+    }
+    // shift back the following entries until one is empty or already at its home
+    uint64_t j = (i + 1) & mask;
+    while (t->dists[j] > 1) {
+        t->slots[i] = t->slots[j];
+        t->dists[i] = t->dists[j] - 1;
+        i = j;
+        j = (j + 1) & mask;
+    }
+    t->dists[i] = 0;
+}
+
+/**
+ * @brief Removes a key from one table, looking in the stash too
+ * @return bool False if key isn't found
+ */
+static bool htable_removekey (htable t, int64_t key)
+{
+    uint64_t i = htable_findslot (t, key);
+    if (i != t->capacity) {
+        htable_removeat (t, i);
+        return true;
+    }
+    for (uint64_t k = 0; k < t->stashed; k++)
+        if (t->stash[k].key == key) {
+            t->stash[k] = t->stash[--t->stashed];
+            t->length--;
+            return true;
+        }
+    return false;
+}
+
+/**
+ * @brief Inserts an entry whose key is in neither table, growing this table at once if needed
+ * @return bool False if allocation fails
+ */
+static bool htable_putnew (htable t, int64_t key, int64_t value)
+{
+    while (!htable_tryput (t, key, value)) {
+        uint64_t capacity = htable_capacityfor (0, t->maxload, t->capacity * 2);
+        if (!capacity || !htable_resize (t, capacity))
+            return false;
+    }
+    t->length++;
+    return true;
+}
+
+/**
+ * @brief Number of entries in both tables
+ */
+static uint64_t htable_total (htable ht)
+{
+    return ht->old ? ht->length + ht->old->length : ht->length;
+}
+
+/**
+ * @brief Grows the htable, at once or incrementally depending on its mode
+ * @param capacity Number of slots, a power of 2
+ * @return bool False if allocation fails
+ */
+static bool htable_grow (htable ht, uint64_t capacity)
+{
+    if (!ht->incremental)
+        return htable_resize (ht, capacity);
+    // only one old table is kept, so finish the last growth
+    if (ht->old && !htable_migratestep (ht, UINT64_MAX))
+        return false;
+    return htable_startmigration (ht, capacity);
+}
+
+/**
+ * @brief Makes the current table the old one and starts with empty slots
+ *
+ * The old table is walked backwards from an empty slot. A robin hood entry
+ * is only moved once the slot after it is empty, that is when it's the last
+ * entry of its run, so taking it out doesn't break probes of the old table.
+ * Stashed cuckoo entries are moved before any slot.
+ *
+ * @param capacity Number of slots, a power of 2
+ * @return bool False if allocation fails, the htable is unchanged then
+ */
+static bool htable_startmigration (htable ht, uint64_t capacity)
+{
+    htable old = malloc (sizeof (struct _htable));
+    if (!old)
+        return false;
+    *old = *ht;
+    if (!htable_alloctable (ht, capacity)) {
+        free (old);
+        return false;
+    }
+    old->old = NULL;
+    old->incremental = false;
+    ht->length = 0;
+    ht->old = old;
+    uint64_t start = 0;
+    while (old->engine == HTABLE_ROBINHOOD && old->dists[start])
+        start++;
+    ht->cursor = (start - 1) & (old->capacity - 1);
+    return true;
+}
+
+/**
+ * @brief Moves the entries of count old slots to the current table, frees the old table once it's empty
+ * @param count Number of old slots to visit
+ * @return bool False if allocation fails
+ */
+static bool htable_migratestep (htable ht, uint64_t count)
+{
+    htable old = ht->old;
+    uint64_t mask = old->capacity - 1;
+    // removal refills slots from the stash, so empty it before the cursor passes any slot
+    for (; count && old->stashed; count--) {
+        struct _htable_slot *entry = &old->stash[old->stashed - 1];
+        if (!htable_putnew (ht, entry->key, entry->value))
+            return false;
+        old->stashed--;
+        old->length--;
+    }
+    for (; count && old->length; count--) {
+        uint64_t i = ht->cursor;
+        if (htable_isfull (old, i)) {
+            if (!htable_putnew (ht, old->slots[i].key, old->slots[i].value))
+                return false;
+            // the old table takes no more entries, so a deleted mark is never reused
+            if (old->engine == HTABLE_SWISS)
+                htable_setctrl (old->ctrl, old->capacity, i, HTABLE_CTRL_DELETED);
+            else if (old->engine == HTABLE_CUCKOO)
+                old->ctrl[i] = HTABLE_CTRL_EMPTY;
+            else
+                old->dists[i] = 0;
+            old->length--;
+        }
+        ht->cursor = (i - 1) & mask;
+    }
+    if (!old->length)
+        htable_delete (&ht->old);
+    return true;
+}
+
+/**
+ * @brief Number of probe steps a lookup of key takes in one table
+ * @param found Set to true if key is in the table
+ */
+static uint64_t htable_probelen (htable t, int64_t key, bool *found)
+{
+    uint64_t hash = htable_hash (t, key);
+    uint64_t mask = t->capacity - 1;
+    uint64_t steps = 1;
+    *found = true;
+    if (t->engine == HTABLE_SWISS) {
+        uint64_t pos = (hash >> 7) & mask;
+        for (uint64_t step = HTABLE_GROUP; ; step += HTABLE_GROUP, steps++) {
+            const uint8_t *group = t->ctrl + pos;
+            for (uint32_t match = htable_groupmatch (group, hash & 0x7f); match; match &= match - 1)
+                if (t->slots[(pos + __builtin_ctz (match)) & mask].key == key)
+                    return steps;
+            if (htable_groupmatch (group, HTABLE_CTRL_EMPTY))
+                break;
+            pos = (pos + step) & mask;
+        }
+    } else if (t->engine == HTABLE_CUCKOO) {
+        uint64_t b[2];
+        htable_cuckoobuckets (hash, t->capacity, &b[0], &b[1]);
+        for (int k = 0; k < 2; k++, steps++)
+            for (uint64_t i = b[k] * HTABLE_BUCKET; i < (b[k] + 1) * HTABLE_BUCKET; i++)
+                if (t->ctrl[i] == hash >> 57 && t->slots[i].key == key)
+                    return steps;
+        if (!t->stashed)
+            steps--;
+        for (uint64_t k = 0; k < t->stashed; k++)
+            if (t->stash[k].key == key)
+                return steps;
+    } else {
+        uint64_t i = hash & mask;
+        for (uint64_t dist = 1; t->dists[i] >= dist; dist++, steps++) {
+            if (t->dists[i] == dist && t->slots[i].key == key)
+                return steps;
+            i = (i + 1) & mask;
+        }
+    }
+    *found = false;
+    return steps;
+}
+
+/**
+ * @brief Calls callback for each entry of one table
+ */
+static void htable_foreachin (htable t, void (*callback)(int64_t key, int64_t *value))
+{
+    for (uint64_t i = 0; i < t->capacity; i++)
+        if (htable_isfull (t, i))
+            callback (t->slots[i].key, &t->slots[i].value);
+    for (uint64_t k = 0; k < t->stashed; k++)
+        callback (t->stash[k].key, &t->stash[k].value);
+}
+
+/**
+ * @brief Allocates a new htable in the heap
+ *
+ * Remember to free the htable using htable_delete (&ht);
+ *
+ * @return htable
+ */
+htable new_htable ()
+{
+    return new_htable_engine (HTABLE_ROBINHOOD);
+}
+
+/**
+ * @brief Allocates a new htable using an engine in the heap
+ *
+ * Remember to free the htable using htable_delete (&ht);
+ *
+ * @param engine HTABLE_ROBINHOOD, HTABLE_SWISS or HTABLE_CUCKOO
+ * @return htable Returns NULL if engine is unknown
+ */
+htable new_htable_engine (int engine)
+{
+    if (engine != HTABLE_ROBINHOOD && engine != HTABLE_SWISS && engine != HTABLE_CUCKOO)
+        return NULL;
+    htable ht = malloc (sizeof (struct _htable));
+    if (!ht)
+        return NULL;
+    ht->engine = engine;
+    ht->maxload = HTABLE_MAXLOAD;
+    ht->hash = NULL;
+    ht->seed = 0;
+    if (!htable_alloctable (ht, HTABLE_MINCAPACITY)) {
+        free (ht);
+        return NULL;
+    }
+    ht->length = 0;
+    ht->incremental = false;
+    ht->old = NULL;
+    ht->cursor = 0;
+    return ht;
+}
+
+/**
+ * @brief Sets value of a key, adding the key if it's not in the htable
+ * @param ht The htable
+ * @param key The key
+ * @param value The value
+ * @return bool True if successful
+ */
+bool htable_set (htable ht, int64_t key, int64_t value)
+{
+    if (!ht)
+        return false;
+    if (ht->old && !htable_migratestep (ht, HTABLE_MIGRATE_STEP))
+        return false;
+    if (ht->engine == HTABLE_SWISS)
+        return htable_swissset (ht, key, value);
+    if (ht->engine == HTABLE_CUCKOO)
+        return htable_cuckooset (ht, key, value);
+    uint64_t mask = ht->capacity - 1;
+    uint64_t i = htable_hash (ht, key) & mask;
+    uint64_t dist = 1;
+    while (ht->dists[i] >= dist) {
+        if (ht->dists[i] == dist && ht->slots[i].key == key) {
+            ht->slots[i].value = value;
+            return true;
+        }
+        i = (i + 1) & mask;
+        dist++;
+    }
+    if (ht->old) {
+        uint64_t j = htable_findslot (ht->old, key);
+        if (j != ht->old->capacity) {
+            ht->old->slots[j].value = value;
+            return true;
+        }
+    }
+    // the probe stopped where the new entry goes, unless the htable has to grow
+    uint64_t total = htable_total (ht);
+    if (total < ht->threshold && htable_insertat (ht->slots, ht->dists, mask, i, dist, key, value)) {
+        ht->length++;
+        return true;
+    }
+    uint64_t capacity = htable_capacityfor (total + 1, ht->maxload, ht->capacity * 2);
+    return capacity && htable_grow (ht, capacity) && htable_putnew (ht, key, value);
+}
+
+/**
+ * @brief Gets value of a key
+ *
+ * There's no way to be sure that HTABLE_ERROR value was returned as a
+ * result of error, or if that exact number had actually been stored.
+ * Use htable_has if that matters.
+ *
+ * @param ht The htable
+ * @param key The key
+ * @return int64_t Returns HTABLE_ERROR if key isn't found
+ */
+int64_t htable_get (htable ht, int64_t key)
+{
+    if (!ht)
+        return HTABLE_ERROR;
+    if (ht->old)
+        htable_migratestep (ht, HTABLE_MIGRATE_STEP);
+    struct _htable_slot *slot = htable_lookup (ht, key);
+    if (!slot)
+        return HTABLE_ERROR;
+    return slot->value;
+}
+
+/**
+ * @brief Checks if a key is in the htable
+ * @param ht The htable
+ * @param key The key
+ * @return bool
+ */
+bool htable_has (htable ht, int64_t key)
+{
+    if (!ht)
+        return false;
+    if (ht->old)
+        htable_migratestep (ht, HTABLE_MIGRATE_STEP);
+    return htable_lookup (ht, key) != NULL;
+}
+
+/**
+ * @brief Removes a key and its value
+ * @param ht The htable
+ * @param key The key
+ * @return bool False if key isn't found
+ */
+bool htable_remove (htable ht, int64_t key)
+{
+    if (!ht)
+        return false;
+    if (ht->old)
+        htable_migratestep (ht, HTABLE_MIGRATE_STEP);
+    if (htable_removekey (ht, key))
+        return true;
+    // shifting back only moves entries within their run, and the cursor has passed no slot of it
+    if (!ht->old || !htable_removekey (ht->old, key))
+        return false;
+    if (!ht->old->length)
+        htable_delete (&ht->old);
+    return true;
+}
+
+/**
+ * @brief Grows the htable so that count entries fit without growing again
+ *
+ * Never shrinks the htable. Moves all entries left in the old table of an
+ * incremental htable first.
+ *
+ * @param ht The htable
+ * @param count Number of entries
+ * @return bool True if successful
+ */
+bool htable_reserve (htable ht, uint64_t count)
+{
+    if (!ht)
+        return false;
+    if (ht->old && !htable_migratestep (ht, UINT64_MAX))
+        return false;
+    uint64_t capacity = htable_capacityfor (count, ht->maxload, ht->capacity);
+    if (!capacity)
+        return false;
+    if (capacity == ht->capacity)
+        return true;
+    return htable_resize (ht, capacity);
+}
+
+/**
+ * @brief Sets the max load factor, growing the htable if it's now above it
+ *
+ * Higher load factors save memory, lower ones make probes shorter.
+ *
+ * @param ht The htable
+ * @param maxload Max ratio of entries to slots, greater than 0 and less than 1
+ * @return bool True if successful
+ */
+bool htable_setmaxload (htable ht, double maxload)
+{
+    if (!ht || !(maxload > 0 && maxload < 1))
+        return false;
+    if (ht->old && !htable_migratestep (ht, UINT64_MAX))
+        return false;
+    uint64_t capacity = htable_capacityfor (ht->length, maxload, ht->capacity);
+    if (!capacity)
+        return false;
+    double oldmaxload = ht->maxload;
+    ht->maxload = maxload;
+    if (capacity != ht->capacity && !htable_resize (ht, capacity)) {
+        ht->maxload = oldmaxload;
+        return false;
+    }
+    ht->threshold = htable_thresholdof (ht->capacity, maxload);
+    return true;
+}
+
+/**
+ * @brief Sets the hash function of the htable, rehashing all entries
+ *
+ * The function has the signature of hash_intfn of the hash module, e.g.
+ * hash_mulxor for keys that are already spread out. A seed from
+ * hash_randomseed makes it hard to pick keys that collide, for keys that
+ * come from outside. Moves all entries left in the old table of an
+ * incremental htable first.
+ *
+ * @param ht The htable
+ * @param hash The hash function, NULL for the murmur3 finalizer
+ * @param seed Passed to the hash function, 0 for the same layout on every run
+ * @return bool True if successful, the htable keeps its hash function otherwise
+ */
+bool htable_sethash (htable ht, uint64_t (*hash) (uint64_t key, uint64_t seed), uint64_t seed)
+{
+    if (!ht)
+        return false;
+    if (ht->old && !htable_migratestep (ht, UINT64_MAX))
+        return false;
+    uint64_t (*oldhash) (uint64_t, uint64_t) = ht->hash;
+    uint64_t oldseed = ht->seed;
+    ht->hash = hash;
+    ht->seed = seed;
+    if (!htable_resize (ht, ht->capacity)) {
+        ht->hash = oldhash;
+        ht->seed = oldseed;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Gets number of entries
+ * @param ht The htable
+ * @return uint64_t
+ */
+uint64_t htable_getlen (htable ht)
+{
+    if (!ht)
+        return 0;
+    return htable_total (ht);
+}
+
+/**
+ * @brief Gets number of slots
+ * @param ht The htable
+ * @return uint64_t
+ */
+uint64_t htable_getcapacity (htable ht)
+{
+    if (!ht)
+        return 0;
+    return ht->capacity;
+}
+
+/**
+ * @brief Gets number of probe steps a lookup of key takes
+ *
+ * A step is one slot for the robin hood engine, and one group of
+ * HTABLE_GROUP control bytes for the swiss engine. The cuckoo engine takes
+ * one step per bucket, plus one for the stash if it holds any entry.
+ *
+ * @param ht The htable
+ * @param key The key, need not be in the htable
+ * @return uint64_t
+ */
+uint64_t htable_getprobelen (htable ht, int64_t key)
+{
+    if (!ht)
+        return 0;
+    bool found;
+    uint64_t steps = htable_probelen (ht, key, &found);
+    if (!found && ht->old)
+        steps += htable_probelen (ht->old, key, &found);
+    return steps;
+}
+
+/**
+ * @brief Sets growth mode of the htable
+ *
+ * Turning incremental growth off moves all entries left in the old table.
+ *
+ * @param ht The htable
+ * @param incremental If true, the htable moves entries to a grown table a few at a time
+ * @return bool True if successful
+ */
+bool htable_setincremental (htable ht, bool incremental)
+{
+    if (!ht)
+        return false;
+    if (!incremental && ht->old && !htable_migratestep (ht, UINT64_MAX))
+        return false;
+    ht->incremental = incremental;
+    return true;
+}
+
+/**
+ * @brief Gets number of entries not yet moved to the grown table
+ * @param ht The htable
+ * @return uint64_t 0 if the htable isn't growing
+ */
+uint64_t htable_getpending (htable ht)
+{
+    if (!ht || !ht->old)
+        return 0;
+    return ht->old->length;
+}
+
+/**
+ * @brief Moves entries of the old table to the grown table
+ * @param ht The htable
+ * @param count Number of old slots to visit, UINT64_MAX to move all entries
+ * @return bool True if successful
+ */
+bool htable_migrate (htable ht, uint64_t count)
+{
+    if (!ht)
+        return false;
+    if (!ht->old)
+        return true;
+    return htable_migratestep (ht, count);
+}
+
+/**
+ * @brief Loop through all entries and take action using a callback function
+ *
+ * Entries are visited in no particular order. The callback must not add
+ * or remove keys.
+ *
+ * @param ht The htable
+ * @param callback Function pointer to a function. The arguments of the function is a key and a pointer to its value.
+ * @return bool
+ */
+bool htable_foreach (htable ht, void (*callback)(int64_t key, int64_t *value))
+{
+    if (!ht || !callback)
+        return false;
+    htable_foreachin (ht, callback);
+    if (ht->old)
+        htable_foreachin (ht->old, callback);
+    return true;
+}
+
+/**
+ * @brief Removes all entries, keeping the slots allocated
+ * @param ht The htable
+ * @return bool
+ */
+bool htable_clear (htable ht)
+{
+    if (!ht)
+        return false;
+    if (ht->engine != HTABLE_ROBINHOOD)
+        memset (ht->ctrl, HTABLE_CTRL_EMPTY, ht->capacity + HTABLE_GROUP - 1);
+    else
+        memset (ht->dists, 0, ht->capacity * sizeof (uint8_t));
+    ht->length = 0;
+    ht->deleted = 0;
+    ht->stashed = 0;
+    htable_delete (&ht->old);
+    return true;
+}
+
+/**
+ * @brief Deletes an htable
+ *
+ * This function is basically a wrapper around free().
+ * Also sets htable pointer to NULL.
+ *
+ * This function is recommended over free as the programmer
+ * might forget to set htable pointer to NULL. As a result,
+ * another htable operation will cause some undefined behaviour.
+ * Additionally, this function is more convenient.
+ *
+ * @param htable* Reference to the htable, is set to NULL.
+ */
+void htable_delete (htable *ht)
+{
+    if (!ht || !*ht)
+        return;
+    htable_delete (&(*ht)->old);
+    htable_freetable (*ht);
+    free (*ht);
+    *ht = NULL;
+}
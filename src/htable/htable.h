@@ -0,0 +1,336 @@
+# ifndef HTABLE_H
+# define HTABLE_H 1
+
+# include <stdlib.h>
+# include <inttypes.h>
+# include <stdint.h>
+# include <stdbool.h>
+# include <string.h>
+
+# define HTABLE_ERROR 0x0123456789abcdeful
+// engines, see new_htable_engine
+# define HTABLE_ROBINHOOD 0
+# define HTABLE_SWISS 1
+# define HTABLE_CUCKOO 2
+// number of slots of a new htable, always a power of 2
+# define HTABLE_MINCAPACITY 16
+# define HTABLE_MAXLOAD 0.875
+// largest probe distance a slot can record, the htable grows before any entry goes further
+# define HTABLE_MAXDIST 255
+// number of control bytes matched at once by the swiss engine
+# define HTABLE_GROUP 16
+// control bytes of the swiss and cuckoo engines, full slots hold 7 bits of hash
+# define HTABLE_CTRL_EMPTY 0x80
+# define HTABLE_CTRL_DELETED 0xfe
+// number of slots of a bucket of the cuckoo engine, a bucket fills one 64 byte cache line
+# define HTABLE_BUCKET 4
+// number of entries the cuckoo engine keeps aside when no eviction path is found
+# define HTABLE_STASH 4
+// max number of entries moved by one cuckoo insertion, and of buckets it searches
+# define HTABLE_CUCKOO_MAXMOVES 5
+# define HTABLE_CUCKOO_MAXNODES 512
+// number of old slots visited by each operation while an incremental htable grows
+# define HTABLE_MIGRATE_STEP 8
+
+struct _htable_slot {
+    int64_t key;
+    int64_t value;
+};
+
+struct _htable {
+    struct _htable_slot *slots;
+    uint8_t *dists;             // robin hood engine, probe distance + 1 of entry in each slot, 0 if empty
+    uint8_t *ctrl;              // swiss and cuckoo engines, control byte of each slot, the first HTABLE_GROUP - 1 repeated at the end
+    int engine;
+    uint64_t capacity;          // number of slots, a power of 2
+    uint64_t length;            // number of entries
+    uint64_t deleted;           // swiss engine, number of deleted slots
+    uint64_t threshold;         // htable grows when length would exceed this
+    double maxload;
+    bool incremental;           // grow without moving all entries at once
+    struct _htable *old;        // table being moved into this one, NULL if none
+    uint64_t cursor;            // next slot of old table to move, moves backwards
+    struct _htable_slot stash[HTABLE_STASH]; // cuckoo engine, entries that found no slot
+    uint64_t stashed;           // cuckoo engine, number of entries in stash
+    uint64_t (*hash) (uint64_t key, uint64_t seed); // NULL for the murmur3 finalizer
+    uint64_t seed;              // passed to hash
+};
+
+// bucket reached by the breadth first search for a cuckoo eviction path
+struct _htable_cuckoonode {
+    uint64_t bucket;
+    int32_t parent;             // node whose entry moves into this bucket, -1 for the buckets of the new key
+    uint8_t slot;               // slot of that entry within the bucket of parent
+    uint8_t depth;              // number of entries moved to free a slot here
+};
+
+/**
+ * @brief The htable struct
+ *
+ * A hash table from int64_t keys to int64_t values, using open addressing
+ * with Robin Hood hashing. Entries are stored inline in one array of slots,
+ * so a lookup touches no memory other than the slots it probes.
+ *
+ * On insertion, an entry takes the slot of any entry that sits closer to
+ * its own home slot, which keeps probe distances short and even. A lookup
+ * stops as soon as it meets an entry closer to home than the key would be,
+ * so misses are about as cheap as hits. Removal shifts the following entries
+ * back by one slot instead of leaving tombstones.
+ *
+ * The htable doubles when the number of entries would exceed the max load
+ * factor, HTABLE_MAXLOAD by default.
+ *
+ * The swiss engine, picked with new_htable_engine, is built for lookup
+ * heavy workloads instead. Each slot has a control byte holding 7 bits of
+ * the hash of its key, or marking it empty or deleted. Lookups compare 16
+ * control bytes at once using SSE2 and only read the slots whose byte
+ * matches, and stop at the first group with an empty slot. Removal leaves
+ * a deleted mark when a probe may have passed the slot while its group
+ * was full, and the marks are cleared whenever the htable is rehashed.
+ *
+ * An incremental htable, set using htable_setincremental, doesn't move all
+ * entries when it grows. It keeps the old table and moves the entries of
+ * HTABLE_MIGRATE_STEP old slots on each set, get, has or remove, so no
+ * single operation pays for the whole rehash. Lookups check both tables
+ * meanwhile. htable_getpending tells how many entries are left in the old
+ * table, and htable_migrate moves them ahead of time, e.g. when idle.
+ *
+ * The cuckoo engine bounds lookups instead, for read heavy tables where
+ * the worst lookup matters more than insertion speed. Slots are grouped in
+ * buckets of HTABLE_BUCKET, and a key may only live in one of the two
+ * buckets picked by two halves of its hash, so a lookup reads at most two
+ * cache lines. When both are full, an insertion searches breadth first for
+ * the shortest chain of at most HTABLE_CUCKOO_MAXMOVES entries that can
+ * each move to their other bucket. If there's none, the entry goes to a
+ * small stash that lookups also check, and the htable grows once the stash
+ * is full too.
+ *
+ * // new htable
+ * htable ht = new_htable ();
+ * htable ht = new_htable_engine (HTABLE_SWISS);
+ * htable ht = new_htable_engine (HTABLE_CUCKOO);
+ *
+ * // functions
+ * bool htable_set (htable ht, int64_t key, int64_t value);
+ * int64_t htable_get (htable ht, int64_t key);
+ * bool htable_has (htable ht, int64_t key);
+ * bool htable_remove (htable ht, int64_t key);
+ * bool htable_reserve (htable ht, uint64_t count);
+ * bool htable_setmaxload (htable ht, double maxload);
+ * bool htable_sethash (htable ht, uint64_t (*hash) (uint64_t key, uint64_t seed), uint64_t seed);
+ * uint64_t htable_getlen (htable ht);
+ * uint64_t htable_getcapacity (htable ht);
+ * uint64_t htable_getprobelen (htable ht, int64_t key);
+ * bool htable_setincremental (htable ht, bool incremental);
+ * uint64_t htable_getpending (htable ht);
+ * bool htable_migrate (htable ht, uint64_t count);
+ * bool htable_foreach (htable ht, void (*callback)(int64_t key, int64_t *value));
+ * bool htable_clear (htable ht);
+ *
+ * // deleting htable
+ * void htable_delete (htable *ht);
+ *
+ * // avoid accessing following htable members
+ * ht->slots;       // htable keys and values
+ * ht->dists;       // htable probe distances
+ * ht->ctrl;        // htable control bytes
+ * ht->engine;      // htable engine
+ * ht->capacity;    // htable number of slots
+ * ht->length;      // htable number of entries
+ * ht->deleted;     // htable number of deleted slots
+ * ht->threshold;   // htable number of entries before growing
+ * ht->maxload;     // htable max load factor
+ * ht->incremental; // htable growth mode
+ * ht->old;         // htable table being moved
+ * ht->cursor;      // htable next slot to move
+ * ht->stash;       // htable stashed keys and values
+ * ht->stashed;     // htable number of stashed entries
+ * ht->hash;        // htable hash function
+ * ht->seed;        // htable hash seed
+ */
+typedef struct _htable *htable;
+
+/**
+ * @brief Allocates a new htable in the heap
+ *
+ * Remember to free the htable using htable_delete (&ht);
+ *
+ * @return htable
+ */
+htable new_htable ();
+
+/**
+ * @brief Allocates a new htable using an engine in the heap
+ *
+ * Remember to free the htable using htable_delete (&ht);
+ *
+ * @param engine HTABLE_ROBINHOOD, HTABLE_SWISS or HTABLE_CUCKOO
+ * @return htable Returns NULL if engine is unknown
+ */
+htable new_htable_engine (int engine);
+
+/**
+ * @brief Sets value of a key, adding the key if it's not in the htable
+ * @param ht The htable
+ * @param key The key
+ * @param value The value
+ * @return bool True if successful
+ */
+bool htable_set (htable ht, int64_t key, int64_t value);
+
+/**
+ * @brief Gets value of a key
+ *
+ * There's no way to be sure that HTABLE_ERROR value was returned as a
+ * result of error, or if that exact number had actually been stored.
+ * Use htable_has if that matters.
+ *
+ * @param ht The htable
+ * @param key The key
+ * @return int64_t Returns HTABLE_ERROR if key isn't found
+ */
+int64_t htable_get (htable ht, int64_t key);
+
+/**
+ * @brief Checks if a key is in the htable
+ * @param ht The htable
+ * @param key The key
+ * @return bool
+ */
+bool htable_has (htable ht, int64_t key);
+
+/**
+ * @brief Removes a key and its value
+ * @param ht The htable
+ * @param key The key
+ * @return bool False if key isn't found
+ */
+bool htable_remove (htable ht, int64_t key);
+
+/**
+ * @brief Grows the htable so that count entries fit without growing again
+ *
+ * Never shrinks the htable. Moves all entries left in the old table of an
+ * incremental htable first.
+ *
+ * @param ht The htable
+ * @param count Number of entries
+ * @return bool True if successful
+ */
+bool htable_reserve (htable ht, uint64_t count);
+
+/**
+ * @brief Sets the max load factor, growing the htable if it's now above it
+ *
+ * Higher load factors save memory, lower ones make probes shorter.
+ *
+ * @param ht The htable
+ * @param maxload Max ratio of entries to slots, greater than 0 and less than 1
+ * @return bool True if successful
+ */
+bool htable_setmaxload (htable ht, double maxload);
+
+/**
+ * @brief Sets the hash function of the htable, rehashing all entries
+ *
+ * The function has the signature of hash_intfn of the hash module, e.g.
+ * hash_mulxor for keys that are already spread out. A seed from
+ * hash_randomseed makes it hard to pick keys that collide, for keys that
+ * come from outside. Moves all entries left in the old table of an
+ * incremental htable first.
+ *
+ * @param ht The htable
+ * @param hash The hash function, NULL for the murmur3 finalizer
+ * @param seed Passed to the hash function, 0 for the same layout on every run
+ * @return bool True if successful, the htable keeps its hash function otherwise
+ */
+bool htable_sethash (htable ht, uint64_t (*hash) (uint64_t key, uint64_t seed), uint64_t seed);
+
+/**
+ * @brief Gets number of entries
+ * @param ht The htable
+ * @return uint64_t
+ */
+uint64_t htable_getlen (htable ht);
+
+/**
+ * @brief Gets number of slots
+ * @param ht The htable
+ * @return uint64_t
+ */
+uint64_t htable_getcapacity (htable ht);
+
+/**
+ * @brief Gets number of probe steps a lookup of key takes
+ *
+ * A step is one slot for the robin hood engine, and one group of
+ * HTABLE_GROUP control bytes for the swiss engine. The cuckoo engine takes
+ * one step per bucket, plus one for the stash if it holds any entry.
+ *
+ * @param ht The htable
+ * @param key The key, need not be in the htable
+ * @return uint64_t
+ */
+uint64_t htable_getprobelen (htable ht, int64_t key);
+
+/**
+ * @brief Sets growth mode of the htable
+ *
+ * Turning incremental growth off moves all entries left in the old table.
+ *
+ * @param ht The htable
+ * @param incremental If true, the htable moves entries to a grown table a few at a time
+ * @return bool True if successful
+ */
+bool htable_setincremental (htable ht, bool incremental);
+
+/**
+ * @brief Gets number of entries not yet moved to the grown table
+ * @param ht The htable
+ * @return uint64_t 0 if the htable isn't growing
+ */
+uint64_t htable_getpending (htable ht);
+
+/**
+ * @brief Moves entries of the old table to the grown table
+ * @param ht The htable
+ * @param count Number of old slots to visit, UINT64_MAX to move all entries
+ * @return bool True if successful
+ */
+bool htable_migrate (htable ht, uint64_t count);
+
+/**
+ * @brief Loop through all entries and take action using a callback function
+ *
+ * Entries are visited in no particular order. The callback must not add
+ * or remove keys.
+ *
+ * @param ht The htable
+ * @param callback Function pointer to a function. The arguments of the function is a key and a pointer to its value.
+ * @return bool
+ */
+bool htable_foreach (htable ht, void (*callback)(int64_t key, int64_t *value));
+
+/**
+ * @brief Removes all entries, keeping the slots allocated
+ * @param ht The htable
+ * @return bool
+ */
+bool htable_clear (htable ht);
+
+/**
+ * @brief Deletes an htable
+ *
+ * This function is basically a wrapper around free().
+ * Also sets htable pointer to NULL.
+ *
+ * This function is recommended over free as the programmer
+ * might forget to set htable pointer to NULL. As a result,
+ * another htable operation will cause some undefined behaviour.
+ * Additionally, this function is more convenient.
+ *
+ * @param htable* Reference to the htable, is set to NULL.
+ */
+void htable_delete (htable *ht);
+
+# endif
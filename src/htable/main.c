@@ -0,0 +1,118 @@
+# include <stdio.h>
+# include <time.h>
+# include "htable.h"
+
+// distinct keys spread over the whole int64_t range
+# define KEY(i) ((int64_t) ((uint64_t) (i) * 0x9e3779b97f4a7c15ull))
+
+// lookups add their results here, or the compiler would drop the timed loops
+volatile int64_t sink;
+
+void callback (int64_t key, int64_t *value)
+{
+    printf ("%ld: %ld\n", key, *value);
+}
+
+double now ()
+{
+    struct timespec ts;
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+void bench (uint64_t n, int engine)
+{
+    double start, insert, reserved, hit, miss, removal, probes = 0;
+    int64_t sum = 0;
+    htable ht = new_htable_engine (engine);
+
+    start = now ();
+    for (uint64_t i = 0; i < n; i++)
+        htable_set (ht, KEY (i), i);
+    insert = (now () - start) / n;
+
+    start = now ();
+    for (uint64_t i = 0; i < n; i++)
+        sum += htable_get (ht, KEY (i));
+    hit = (now () - start) / n;
+
+    start = now ();
+    for (uint64_t i = n; i < 2 * n; i++)
+        sum += htable_has (ht, KEY (i));
+    miss = (now () - start) / n;
+
+    for (uint64_t i = n; i < 2 * n; i++)
+        probes += htable_getprobelen (ht, KEY (i));
+
+    start = now ();
+    for (uint64_t i = 0; i < n; i++)
+        htable_remove (ht, KEY (i));
+    removal = (now () - start) / n;
+
+    // same inserts without growing on the way
+    htable_delete (&ht);
+    ht = new_htable_engine (engine);
+    htable_reserve (ht, n);
+    start = now ();
+    for (uint64_t i = 0; i < n; i++)
+        htable_set (ht, KEY (i), i);
+    reserved = (now () - start) / n;
+
+    const char *names[] = {"robinhood", "swiss", "cuckoo"};
+    printf ("%-10s %10lu %10.1f %10.1f %10.1f %10.1f %10.1f %12.2f\n", names[engine],
+        n, insert, reserved, hit, miss, removal, probes / n);
+    sink = sum;
+    htable_delete (&ht);
+}
+
+void latency (uint64_t n, bool incremental)
+{
+    double start, end, worst = 0, total = 0;
+    htable ht = new_htable ();
+    htable_setincremental (ht, incremental);
+    for (uint64_t i = 0; i < n; i++) {
+        start = now ();
+        htable_set (ht, KEY (i), i);
+        end = now ();
+        total += end - start;
+        if (end - start > worst)
+            worst = end - start;
+    }
+    printf ("%-12s %10lu %12.1f %12.3f %10lu\n", incremental ? "incremental" : "at once",
+        n, total / n, worst / 1e6, htable_getpending (ht));
+    // finish moving entries, e.g. when idle
+    htable_migrate (ht, UINT64_MAX);
+    htable_delete (&ht);
+}
+
+int main (int argc, char **argv)
+{
+    htable ht = new_htable ();
+
+    htable_set (ht, 45, 1);
+    htable_set (ht, 25, 2);
+    htable_set (ht, 19, 3);
+    htable_set (ht, 25, 4);
+    htable_remove (ht, 19);
+    printf ("Value of 25 = %ld, has 19 = %d, length = %lu\n", htable_get (ht, 25), htable_has (ht, 19), htable_getlen (ht));
+    htable_foreach (ht, callback);
+    htable_delete (&ht);
+
+    // benchmark from 10^3 up to 10^max entries, max given as first argument
+    int max = argc > 1 ? atoi (argv[1]) : 6;
+    // a robin hood probe step is a slot, a swiss one is a group of 16 control bytes, a cuckoo one a bucket
+    printf ("\n%-10s %10s %10s %10s %10s %10s %10s %12s   ns per operation\n",
+        "engine", "entries", "insert", "reserved", "hit", "miss", "delete", "miss probes");
+    uint64_t n = 1000;
+    for (int e = 3; e <= max; e++, n *= 10) {
+        bench (n, HTABLE_ROBINHOOD);
+        bench (n, HTABLE_SWISS);
+        bench (n, HTABLE_CUCKOO);
+    }
+
+    // growth stalls single inserts unless entries are moved a few at a time
+    printf ("\n%-12s %10s %12s %12s %10s\n", "growth", "entries", "avg ns", "worst ms", "pending");
+    latency (n / 10, false);
+    latency (n / 10, true);
+    return 0;
+}
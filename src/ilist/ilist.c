@@ -0,0 +1,225 @@
+# include "ilist.h"
+
+/**
+ * @brief Allocates a new ilist in the heap
+ *
+ * Remember to free the ilist using ilist_delete (&il);
+ *
+ * @return ilist The ilist
+ */
+ilist new_ilist ()
+{
+    ilist il = malloc (1 * sizeof (struct _ilist_metanode));
+    if (il == NULL)
+        return NULL;
+    il->start = NULL;
+    il->end = NULL;
+    il->length = 0;
+    return il;
+}
+
+/**
+ * @brief Get length of the ilist
+ *
+ * If ilist is NULL, returns 0
+ *
+ * @param il The ilist
+ * @return uint64_t The length
+ */
+uint64_t ilist_getlen (ilist il)
+{
+    if (il != NULL)
+        return il->length;
+    return 0;
+}
+
+/**
+ * @brief Links a link at the end of the ilist, O(1)
+ *
+ * @param ilist The ilist
+ * @param struct ilist_link* The link, must not be in any ilist
+ * @return bool -- true if successful
+ */
+bool ilist_append (ilist il, struct ilist_link *link)
+{
+    if (il == NULL || link == NULL)
+        return false;
+    if (il->end == NULL)
+        return ilist_prepend (il, link);
+    return ilist_insert_after (il, il->end, link);
+}
+
+/**
+ * @brief Links a link at the start of the ilist, O(1)
+ *
+ * @param ilist The ilist
+ * @param struct ilist_link* The link, must not be in any ilist
+ * @return bool -- true if successful
+ */
+bool ilist_prepend (ilist il, struct ilist_link *link)
+{
+    if (il == NULL || link == NULL)
+        return false;
+    if (il->start != NULL)
+        return ilist_insert_before (il, il->start, link);
+    link->prev = NULL;
+    link->next = NULL;
+    il->start = link;
+    il->end = link;
+    il->length = 1;
+    return true;
+}
+
+/**
+ * @brief Links a link right before pos, O(1)
+ *
+ * @param ilist The ilist
+ * @param struct ilist_link* pos A link in the ilist
+ * @param struct ilist_link* link The link, must not be in any ilist
+ * @return bool -- true if successful
+ */
+bool ilist_insert_before (ilist il, struct ilist_link *pos, struct ilist_link *link)
+{
+    if (ilist_isempty (il) || pos == NULL || link == NULL)
+        return false;
+    link->prev = pos->prev;
+    link->next = pos;
+    if (pos->prev == NULL)
+        il->start = link;
+    else
+        pos->prev->next = link;
+    pos->prev = link;
+    il->length++;
+    return true;
+}
+
+/**
+ * @brief Links a link right after pos, O(1)
+ *
+ * @param ilist The ilist
+ * @param struct ilist_link* pos A link in the ilist
+ * @param struct ilist_link* link The link, must not be in any ilist
+ * @return bool -- true if successful
+ */
+bool ilist_insert_after (ilist il, struct ilist_link *pos, struct ilist_link *link)
+{
+    if (ilist_isempty (il) || pos == NULL || link == NULL)
+        return false;
+    link->prev = pos;
+    link->next = pos->next;
+    if (pos->next == NULL)
+        il->end = link;
+    else
+        pos->next->prev = link;
+    pos->next = link;
+    il->length++;
+    return true;
+}
+
+/**
+ * @brief Unlinks a link from the ilist, O(1)
+ *
+ * The prev and next pointers of link are set to NULL.
+ *
+ * @param ilist The ilist
+ * @param struct ilist_link* A link in the ilist
+ * @return bool -- true if successful
+ */
+bool ilist_unlink (ilist il, struct ilist_link *link)
+{
+    if (ilist_isempty (il) || link == NULL)
+        return false;
+    if (link->prev == NULL)
+        il->start = link->next;
+    else
+        link->prev->next = link->next;
+    if (link->next == NULL)
+        il->end = link->prev;
+    else
+        link->next->prev = link->prev;
+    link->prev = NULL;
+    link->next = NULL;
+    il->length--;
+    return true;
+}
+
+/**
+ * @brief Unlinks the last link of the ilist and returns it, O(1)
+ *
+ * @param ilist The ilist
+ * @return struct ilist_link* -- The link, NULL if ilist is empty
+ */
+struct ilist_link *ilist_pop (ilist il)
+{
+    if (ilist_isempty (il))
+        return NULL;
+    struct ilist_link *link = il->end;
+    ilist_unlink (il, link);
+    return link;
+}
+
+/**
+ * @brief Returns the last link of the ilist without unlinking it
+ *
+ * @param ilist The ilist
+ * @return struct ilist_link* -- The link, NULL if ilist is empty
+ */
+struct ilist_link *ilist_peek (ilist il)
+{
+    if (ilist_isempty (il))
+        return NULL;
+    return il->end;
+}
+
+/**
+ * @brief Loop through ilist and take action using a callback function
+ *
+ * The callback may unlink the link it is given, but no other link.
+ *
+ * @param ilist The ilist
+ * @param callback Function pointer to a function. The arguments of the function is an index and the link.
+ * @return bool -- false if failed
+ */
+bool ilist_foreach (ilist il, void (*callback)(int64_t index, struct ilist_link *link))
+{
+    if (ilist_isempty (il))
+        return false;
+    struct ilist_link *next_link = il->start;
+    struct ilist_link *bkp_link;
+    for (uint64_t i = 0; next_link != NULL; i++) {
+        bkp_link = next_link->next;
+        callback (i, next_link);
+        next_link = bkp_link;
+    }
+    return true;
+}
+
+/**
+ * @brief True if empty
+ *
+ * @param ilist The ilist
+ * @return bool -- True if empty
+ */
+bool ilist_isempty (ilist il)
+{
+    return il == NULL || il->length == 0;
+}
+
+/**
+ * @brief Deletes an ilist
+ *
+ * This function is basically a wrapper around free().
+ * Also sets ilist pointer to NULL.
+ *
+ * Only the ilist itself is freed, the structs embedding the links
+ * belong to the user and are left as they are.
+ *
+ * @param ilist* Reference to the ilist, is set to NULL.
+ */
+void ilist_delete (ilist *il)
+{
+    if (il == NULL || *il == NULL)
+        return;
+    free (*il);
+    *il = NULL;
+}
@@ -0,0 +1,193 @@
+# ifndef ILIST_H
+# define ILIST_H 1
+
+# include <stdlib.h>
+# include <stddef.h>
+# include <inttypes.h>
+# include <stdint.h>
+# include <stdbool.h>
+
+/**
+ * @brief Link to be embedded in a user struct
+ *
+ * struct object {
+ *     int64_t id;
+ *     struct ilist_link link;
+ * };
+ */
+struct ilist_link {
+    struct ilist_link *prev;
+    struct ilist_link *next;
+};
+
+// first node of ilist, same bookkeeping as _llist_metanode
+typedef struct _ilist_metanode {
+    struct ilist_link *start;   // pointer to starting link
+    struct ilist_link *end;     // pointer to ending link
+    uint64_t length;            // number of links in ilist
+} *_ilist_metanode;
+
+/**
+ * @brief Gets pointer to the struct that embeds a link
+ *
+ * struct object *obj = ilist_entry (link, struct object, link);
+ *
+ * @param ptr Pointer to struct ilist_link, must not be NULL
+ * @param type Type of the embedding struct
+ * @param member Name of the struct ilist_link member in type
+ * @return type* -- Pointer to embedding struct
+ */
+# define ilist_entry(ptr, type, member) \
+    ((type *) ((char *) (ptr) - offsetof (type, member)))
+
+/**
+ * @brief The ilist struct
+ *
+ * An intrusive doubly linked list. Instead of allocating a node per
+ * element like llist does, the user embeds a struct ilist_link in their
+ * own struct and links that. Linking and unlinking are O(1) and never
+ * allocate. The ilist doesn't own the links, so deleting an ilist doesn't
+ * free the user structs.
+ *
+ * // new ilist
+ * ilist il = new_ilist ();
+ *
+ * // functions
+ * uint64_t ilist_getlen (ilist il);
+ * bool ilist_append (ilist il, struct ilist_link *link);
+ * bool ilist_prepend (ilist il, struct ilist_link *link);
+ * bool ilist_insert_before (ilist il, struct ilist_link *pos, struct ilist_link *link);
+ * bool ilist_insert_after (ilist il, struct ilist_link *pos, struct ilist_link *link);
+ * bool ilist_unlink (ilist il, struct ilist_link *link);
+ * struct ilist_link *ilist_pop (ilist il);
+ * struct ilist_link *ilist_peek (ilist il);
+ * bool ilist_foreach (ilist il, void (*callback)(int64_t index, struct ilist_link *link));
+ * bool ilist_isempty (ilist il);
+ *
+ * // deleting ilist
+ * void ilist_delete (ilist *il);
+ *
+ * // avoid accessing following ilist members
+ * il->start;       // ilist first link
+ * il->end;         // ilist last link
+ * il->length;      // ilist length
+ */
+typedef _ilist_metanode ilist;
+
+/**
+ * @brief Allocates a new ilist in the heap
+ *
+ * Remember to free the ilist using ilist_delete (&il);
+ *
+ * @return ilist The ilist
+ */
+ilist new_ilist ();
+
+/**
+ * @brief Get length of the ilist
+ *
+ * If ilist is NULL, returns 0
+ *
+ * @param il The ilist
+ * @return uint64_t The length
+ */
+uint64_t ilist_getlen (ilist il);
+
+/**
+ * @brief Links a link at the end of the ilist, O(1)
+ *
+ * @param ilist The ilist
+ * @param struct ilist_link* The link, must not be in any ilist
+ * @return bool -- true if successful
+ */
+bool ilist_append (ilist il, struct ilist_link *link);
+
+/**
+ * @brief Links a link at the start of the ilist, O(1)
+ *
+ * @param ilist The ilist
+ * @param struct ilist_link* The link, must not be in any ilist
+ * @return bool -- true if successful
+ */
+bool ilist_prepend (ilist il, struct ilist_link *link);
+
+/**
+ * @brief Links a link right before pos, O(1)
+ *
+ * @param ilist The ilist
+ * @param struct ilist_link* pos A link in the ilist
+ * @param struct ilist_link* link The link, must not be in any ilist
+ * @return bool -- true if successful
+ */
+bool ilist_insert_before (ilist il, struct ilist_link *pos, struct ilist_link *link);
+
+/**
+ * @brief Links a link right after pos, O(1)
+ *
+ * @param ilist The ilist
+ * @param struct ilist_link* pos A link in the ilist
+ * @param struct ilist_link* link The link, must not be in any ilist
+ * @return bool -- true if successful
+ */
+bool ilist_insert_after (ilist il, struct ilist_link *pos, struct ilist_link *link);
+
+/**
+ * @brief Unlinks a link from the ilist, O(1)
+ *
+ * The prev and next pointers of link are set to NULL.
+ *
+ * @param ilist The ilist
+ * @param struct ilist_link* A link in the ilist
+ * @return bool -- true if successful
+ */
+bool ilist_unlink (ilist il, struct ilist_link *link);
+
+/**
+ * @brief Unlinks the last link of the ilist and returns it, O(1)
+ *
+ * @param ilist The ilist
+ * @return struct ilist_link* -- The link, NULL if ilist is empty
+ */
+struct ilist_link *ilist_pop (ilist il);
+
+/**
+ * @brief Returns the last link of the ilist without unlinking it
+ *
+ * @param ilist The ilist
+ * @return struct ilist_link* -- The link, NULL if ilist is empty
+ */
+struct ilist_link *ilist_peek (ilist il);
+
+/**
+ * @brief Loop through ilist and take action using a callback function
+ *
+ * The callback may unlink the link it is given, but no other link.
+ *
+ * @param ilist The ilist
+ * @param callback Function pointer to a function. The arguments of the function is an index and the link.
+ * @return bool -- false if failed
+ */
+bool ilist_foreach (ilist il, void (*callback)(int64_t index, struct ilist_link *link));
+
+/**
+ * @brief True if empty
+ *
+ * @param ilist The ilist
+ * @return bool -- True if empty
+ */
+bool ilist_isempty (ilist il);
+
+/**
+ * @brief Deletes an ilist
+ *
+ * This function is basically a wrapper around free().
+ * Also sets ilist pointer to NULL.
+ *
+ * Only the ilist itself is freed, the structs embedding the links
+ * belong to the user and are left as they are.
+ *
+ * @param ilist* Reference to the ilist, is set to NULL.
+ */
+void ilist_delete (ilist *il);
+
+# endif
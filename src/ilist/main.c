@@ -0,0 +1,36 @@
+# include <stdio.h>
+# include "ilist.h"
+
+struct object {
+    int64_t id;
+    struct ilist_link link;
+};
+
+void callback (int64_t i, struct ilist_link *link)
+{
+    printf ("i = %ld: %ld\n", i, ilist_entry (link, struct object, link)->id);
+}
+
+int main ()
+{
+    ilist il = new_ilist ();
+    struct object objects[5] = { { 45 }, { 25 }, { 19 }, { 38 }, { 90 } };
+
+    // no allocation takes place, the links live inside objects
+    for (int i = 0; i < 4; i++)
+        ilist_append (il, &objects[i].link);
+    ilist_insert_after (il, &objects[1].link, &objects[4].link);
+
+    printf ("After linking:\n");
+    ilist_foreach (il, callback);
+
+    ilist_unlink (il, &objects[0].link);
+    struct object *last = ilist_entry (ilist_pop (il), struct object, link);
+    printf ("Popped %ld\n", last->id);
+
+    printf ("After unlinking:\n");
+    ilist_foreach (il, callback);
+
+    ilist_delete (&il);
+    return 0;
+}
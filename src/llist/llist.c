@@ -1,5 +1,11 @@
 # include "llist.h"
 
+static _llist_node llist_getnode (llist llst, uint64_t index);
+static int llist_compare (int64_t a, int64_t b);
+static _llist_node llist_cutrun (_llist_node node, uint64_t length);
+static _llist_node llist_mergeruns (_llist_node a, _llist_node b, int (*compare)(int64_t a, int64_t b), _llist_node *tail);
+static void llist_relink (llist llst, _llist_node head);
+
 /**
  * @brief Allocates a new llist in the heap
  *
@@ -254,6 +260,295 @@ bool llist_set (llist llst, uint64_t index, int64_t value)
     return true;
 }
 
+/**
+ * @brief Gets node at an index of llist, walks from the nearer end
+ *
+ * @param llist The llist, must not be NULL
+ * @param uint64_t index The index of the node
+ * @return _llist_node -- NULL if index is out of bounds
+ */
+static _llist_node llist_getnode (llist llst, uint64_t index)
+{
+    if (index >= llst->length)
+        return NULL;
+    _llist_node node;
+    if (index < llst->length / 2) {
+        node = llst->start;
+        for (uint64_t i = 0; i < index; i++)
+            node = node->next;
+    } else {
+        node = llst->end;
+        for (uint64_t i = llst->length - 1; i > index; i--)
+            node = node->prev;
+    }
+    return node;
+}
+
+/**
+ * @brief Moves all nodes of src to the end of dst
+ *
+ * Nodes are relinked, not copied, so this is O(1) and allocates nothing.
+ * src is left empty but is not deleted, use llist_delete (&src) for that.
+ *
+ * @param llist dst The llist to append to
+ * @param llist src The llist whose nodes are moved, must not be dst
+ * @return bool -- false if fails
+ */
+bool llist_concat (llist dst, llist src)
+{
+    if (dst == NULL || src == NULL || dst == src)
+        return false;
+    if (src->length == 0)
+        return true;
+    if (dst->length == 0)
+        dst->start = src->start;
+    else {
+        dst->end->next = src->start;
+        src->start->prev = dst->end;
+    }
+    dst->end = src->end;
+    dst->length += src->length;
+    src->start = NULL;
+    src->end = NULL;
+    src->length = 0;
+    return true;
+}
+
+/**
+ * @brief Moves nodes in index range [from, to) of src to index pos of dst
+ *
+ * Nodes are relinked, not copied, so no allocation takes place. Finding
+ * the range and pos walks the lists from the nearer end, the relinking
+ * itself is O(1).
+ *
+ * After the call, the first moved node is at index pos of dst.
+ *
+ * @param llist dst The llist to move nodes into
+ * @param uint64_t pos Index of dst where the range is to be inserted, 0 to dst->length
+ * @param llist src The llist to move nodes out of, must not be dst
+ * @param uint64_t from Index of first node to move
+ * @param uint64_t to Index after the last node to move
+ * @return bool -- false if fails
+ */
+bool llist_splice (llist dst, uint64_t pos, llist src, uint64_t from, uint64_t to)
+{
+    if (dst == NULL || src == NULL || dst == src)
+        return false;
+    if (from > to || to > src->length || pos > dst->length)
+        return false;
+    if (from == to)
+        return true;
+    _llist_node first = llist_getnode (src, from);
+    _llist_node last = llist_getnode (src, to - 1);
+    // unlink range from src
+    if (first->prev == NULL)
+        src->start = last->next;
+    else
+        first->prev->next = last->next;
+    if (last->next == NULL)
+        src->end = first->prev;
+    else
+        last->next->prev = first->prev;
+    src->length -= to - from;
+    // link range into dst, before the node at pos
+    _llist_node next_node = llist_getnode (dst, pos);
+    _llist_node prev_node = next_node == NULL ? dst->end : next_node->prev;
+    first->prev = prev_node;
+    last->next = next_node;
+    if (prev_node == NULL)
+        dst->start = first;
+    else
+        prev_node->next = first;
+    if (next_node == NULL)
+        dst->end = last;
+    else
+        next_node->prev = last;
+    dst->length += to - from;
+    return true;
+}
+
+/**
+ * @brief Splits llist at index, nodes from index onwards are moved to a new llist
+ *
+ * Only the new llist header is allocated, the nodes are relinked.
+ * Remember to free the new llist using llist_delete (&llst);
+ *
+ * @param llist The llist to split
+ * @param uint64_t index Index of first node of the new llist, 0 to llst->length
+ * @return llist -- The new llist, NULL if fails
+ */
+llist llist_split (llist llst, uint64_t index)
+{
+    if (llst == NULL || index > llst->length)
+        return NULL;
+    llist newlst = new_llist ();
+    if (newlst == NULL)
+        return NULL;
+    if (index == llst->length)
+        return newlst;
+    _llist_node first = llist_getnode (llst, index);
+    newlst->start = first;
+    newlst->end = llst->end;
+    newlst->length = llst->length - index;
+    llst->end = first->prev;
+    if (first->prev == NULL)
+        llst->start = NULL;
+    else
+        first->prev->next = NULL;
+    first->prev = NULL;
+    llst->length = index;
+    return newlst;
+}
+
+/**
+ * @brief Default comparison function, ascending order
+ */
+static int llist_compare (int64_t a, int64_t b)
+{
+    return (a > b) - (a < b);
+}
+
+/**
+ * @brief Cuts a next-linked run after length nodes
+ *
+ * @param _llist_node node First node of the run, may be NULL
+ * @param uint64_t length Number of nodes to keep in the run
+ * @return _llist_node -- First node after the run, NULL if none
+ */
+static _llist_node llist_cutrun (_llist_node node, uint64_t length)
+{
+    for (uint64_t i = 1; node != NULL && i < length; i++)
+        node = node->next;
+    if (node == NULL)
+        return NULL;
+    _llist_node rest = node->next;
+    node->next = NULL;
+    return rest;
+}
+
+/**
+ * @brief Stable merge of two NULL terminated next-linked runs
+ *
+ * Only next links are set, prev links are fixed later by llist_relink.
+ * On ties, nodes of a go first.
+ *
+ * @param _llist_node a First run
+ * @param _llist_node b Second run
+ * @param compare Comparison function
+ * @param _llist_node* tail Is set to last node of the merged run
+ * @return _llist_node -- First node of the merged run
+ */
+static _llist_node llist_mergeruns (_llist_node a, _llist_node b, int (*compare)(int64_t a, int64_t b), _llist_node *tail)
+{
+    struct _llist_node head;
+    _llist_node node = &head;
+    while (a != NULL && b != NULL) {
+        if (compare (b->element, a->element) < 0) {
+            node->next = b;
+            b = b->next;
+        } else {
+            node->next = a;
+            a = a->next;
+        }
+        node = node->next;
+    }
+    node->next = a != NULL ? a : b;
+    while (node->next != NULL)
+        node = node->next;
+    *tail = node;
+    return head.next;
+}
+
+/**
+ * @brief Restores prev links, start and end of llist from a next-linked chain
+ *
+ * @param llist The llist, length must already be set
+ * @param _llist_node head First node of the chain
+ */
+static void llist_relink (llist llst, _llist_node head)
+{
+    _llist_node prev_node = NULL;
+    for (_llist_node node = head; node != NULL; node = node->next) {
+        node->prev = prev_node;
+        prev_node = node;
+    }
+    llst->start = head;
+    llst->end = prev_node;
+}
+
+/**
+ * @brief Sorts llist in place using a stable bottom-up merge sort
+ *
+ * Only the prev and next links are changed, nodes stay where they are
+ * in memory. Runs in O(n log n) time with O(1) extra space.
+ *
+ * compare should return < 0 if a goes before b, > 0 if a goes after b
+ * and 0 if they're equal. Equal elements keep their relative order.
+ * If compare is NULL, elements are sorted in ascending order.
+ *
+ * @param llist The llist
+ * @param compare Function pointer to comparison function, may be NULL
+ * @return bool -- false if fails
+ */
+bool llist_sort (llist llst, int (*compare)(int64_t a, int64_t b))
+{
+    if (llst == NULL)
+        return false;
+    if (llst->length < 2)
+        return true;
+    if (compare == NULL)
+        compare = llist_compare;
+    _llist_node head = llst->start;
+    for (uint64_t width = 1; width < llst->length; width *= 2) {
+        _llist_node rest = head;
+        _llist_node tail = NULL;
+        while (rest != NULL) {
+            _llist_node left = rest;
+            _llist_node right = llist_cutrun (left, width);
+            rest = llist_cutrun (right, width);
+            _llist_node merged_tail;
+            _llist_node merged = llist_mergeruns (left, right, compare, &merged_tail);
+            if (tail == NULL)
+                head = merged;
+            else
+                tail->next = merged;
+            tail = merged_tail;
+        }
+    }
+    llist_relink (llst, head);
+    return true;
+}
+
+/**
+ * @brief Merges sorted src into sorted dst, without any allocation
+ *
+ * Both llists must already be sorted according to compare. On ties, nodes
+ * of dst go before nodes of src. src is left empty but is not deleted,
+ * use llist_delete (&src) for that.
+ *
+ * @param llist dst The llist to merge into
+ * @param llist src The llist whose nodes are moved, must not be dst
+ * @param compare Function pointer to comparison function, may be NULL
+ * @return bool -- false if fails
+ */
+bool llist_merge_sorted (llist dst, llist src, int (*compare)(int64_t a, int64_t b))
+{
+    if (dst == NULL || src == NULL || dst == src)
+        return false;
+    if (src->length == 0)
+        return true;
+    if (compare == NULL)
+        compare = llist_compare;
+    _llist_node tail;
+    _llist_node head = llist_mergeruns (dst->start, src->start, compare, &tail);
+    dst->length += src->length;
+    llist_relink (dst, head);
+    src->start = NULL;
+    src->end = NULL;
+    src->length = 0;
+    return true;
+}
+
 /**
  * @brief Loop through llist and take action using a callback function
  *
@@ -317,7 +612,7 @@ bool llist_isempty (llist llst)
  */
 void llist_delete (llist *llst)
 {
-    if (llist_isempty(*llst))
+    if (llst == NULL || *llst == NULL)
         return;
     _llist_node next_node = (*llst)->start;
     _llist_node bkp_node;
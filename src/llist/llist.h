@@ -37,6 +37,11 @@ typedef struct _llist_node {
  * int64_t llist_remove (llist llst, uint64_t index);
  * int64_t llist_get (llist llst, uint64_t index);
  * bool llist_set (llist llst, uint64_t index, int64_t value);
+ * bool llist_concat (llist dst, llist src);
+ * bool llist_splice (llist dst, uint64_t pos, llist src, uint64_t from, uint64_t to);
+ * llist llist_split (llist llst, uint64_t index);
+ * bool llist_sort (llist llst, int (*compare)(int64_t a, int64_t b));
+ * bool llist_merge_sorted (llist dst, llist src, int (*compare)(int64_t a, int64_t b));
  * bool llist_print (llist llst);
  * bool llist_isempty (llist llst);
  *
@@ -170,6 +175,78 @@ int64_t llist_get (llist llst, uint64_t index);
  */
 bool llist_set (llist llst, uint64_t index, int64_t value);
 
+/**
+ * @brief Moves all nodes of src to the end of dst
+ *
+ * Nodes are relinked, not copied, so this is O(1) and allocates nothing.
+ * src is left empty but is not deleted, use llist_delete (&src) for that.
+ *
+ * @param llist dst The llist to append to
+ * @param llist src The llist whose nodes are moved, must not be dst
+ * @return bool -- false if fails
+ */
+bool llist_concat (llist dst, llist src);
+
+/**
+ * @brief Moves nodes in index range [from, to) of src to index pos of dst
+ *
+ * Nodes are relinked, not copied, so no allocation takes place. Finding
+ * the range and pos walks the lists from the nearer end, the relinking
+ * itself is O(1).
+ *
+ * After the call, the first moved node is at index pos of dst.
+ *
+ * @param llist dst The llist to move nodes into
+ * @param uint64_t pos Index of dst where the range is to be inserted, 0 to dst->length
+ * @param llist src The llist to move nodes out of, must not be dst
+ * @param uint64_t from Index of first node to move
+ * @param uint64_t to Index after the last node to move
+ * @return bool -- false if fails
+ */
+bool llist_splice (llist dst, uint64_t pos, llist src, uint64_t from, uint64_t to);
+
+/**
+ * @brief Splits llist at index, nodes from index onwards are moved to a new llist
+ *
+ * Only the new llist header is allocated, the nodes are relinked.
+ * Remember to free the new llist using llist_delete (&llst);
+ *
+ * @param llist The llist to split
+ * @param uint64_t index Index of first node of the new llist, 0 to llst->length
+ * @return llist -- The new llist, NULL if fails
+ */
+llist llist_split (llist llst, uint64_t index);
+
+/**
+ * @brief Sorts llist in place using a stable bottom-up merge sort
+ *
+ * Only the prev and next links are changed, nodes stay where they are
+ * in memory. Runs in O(n log n) time with O(1) extra space.
+ *
+ * compare should return < 0 if a goes before b, > 0 if a goes after b
+ * and 0 if they're equal. Equal elements keep their relative order.
+ * If compare is NULL, elements are sorted in ascending order.
+ *
+ * @param llist The llist
+ * @param compare Function pointer to comparison function, may be NULL
+ * @return bool -- false if fails
+ */
+bool llist_sort (llist llst, int (*compare)(int64_t a, int64_t b));
+
+/**
+ * @brief Merges sorted src into sorted dst, without any allocation
+ *
+ * Both llists must already be sorted according to compare. On ties, nodes
+ * of dst go before nodes of src. src is left empty but is not deleted,
+ * use llist_delete (&src) for that.
+ *
+ * @param llist dst The llist to merge into
+ * @param llist src The llist whose nodes are moved, must not be dst
+ * @param compare Function pointer to comparison function, may be NULL
+ * @return bool -- false if fails
+ */
+bool llist_merge_sorted (llist dst, llist src, int (*compare)(int64_t a, int64_t b));
+
 /**
  * @brief Loop through llist and take action using a callback function
  *
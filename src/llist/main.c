@@ -28,6 +28,29 @@ int main ()
     printf ("After set:\n");
     llist_foreach (llst, callback);
 
+    // move last 3 nodes to a new llist and splice 2 of them back at the front
+    llist tail = llist_split (llst, 5);
+    llist_splice (llst, 0, tail, 1, 3);
+    llist_concat (llst, tail);
+
+    printf ("After split, splice and concat:\n");
+    llist_foreach (llst, callback);
+
+    llist_delete (&tail);
+
+    // sort and merge in another sorted llist
+    llist_sort (llst, NULL);
+    llist other = new_llist ();
+    llist_append (other, 20);
+    llist_append (other, 40);
+    llist_append (other, 500);
+    llist_merge_sorted (llst, other, NULL);
+
+    printf ("After sort and merge:\n");
+    llist_foreach (llst, callback);
+
+    llist_delete (&other);
+
     llist_delete (&llst);
     return 0;
 }
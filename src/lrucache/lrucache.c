@@ -0,0 +1,384 @@
+# include "lrucache.h"
+
+static uint64_t lrucache_hash (int64_t key);
+static uint32_t lrucache_lookup (lrucache lc, int64_t key);
+static void lrucache_move (lrucache lc, uint32_t from, uint32_t to);
+static void lrucache_unlink (lrucache lc, uint32_t i);
+static void lrucache_pushfront (lrucache lc, uint32_t i);
+static void lrucache_touch (lrucache lc, uint32_t i);
+static void lrucache_removeat (lrucache lc, uint32_t i);
+static void lrucache_evict (lrucache lc);
+static void lrucache_insert (lrucache lc, int64_t key, int64_t value);
+
+/**
+ * @brief Hashes a key using the murmur3 finalizer, so that low bits depend on all bits of key
+ */
+static uint64_t lrucache_hash (int64_t key)
+{
+    uint64_t x = key;
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdull;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ull;
+    x ^= x >> 33;
+    return x;
+}
+
+/**
+ * @brief Finds slot of a key
+ * @return uint32_t The slot, LRUCACHE_NONE if key isn't found
+ */
+static uint32_t lrucache_lookup (lrucache lc, int64_t key)
+{
+    uint32_t i = lrucache_hash (key) & lc->mask;
+    // entries of key's probe sequence are never closer to their home than key would be
+    for (uint32_t dist = 1; lc->slots[i].dist >= dist; dist++) {
+        if (lc->slots[i].key == key)
+            return i;
+        i = (i + 1) & lc->mask;
+    }
+    return LRUCACHE_NONE;
+}
+
+/**
+ * @brief Moves the entry of slot from to slot to, pointing its neighbours in the recency list to it
+ *
+ * Slot from keeps a stale copy, which the caller overwrites or empties.
+ */
+static void lrucache_move (lrucache lc, uint32_t from, uint32_t to)
+{
+    struct _lrucache_slot *slot = &lc->slots[to];
+    *slot = lc->slots[from];
+    if (slot->prev != LRUCACHE_NONE)
+        lc->slots[slot->prev].next = to;
+    else
+        lc->head = to;
+    if (slot->next != LRUCACHE_NONE)
+        lc->slots[slot->next].prev = to;
+    else
+        lc->tail = to;
+}
+
+/**
+ * @brief Takes the entry of slot i out of the recency list
+ */
+static void lrucache_unlink (lrucache lc, uint32_t i)
+{
+    struct _lrucache_slot *slot = &lc->slots[i];
+    if (slot->prev != LRUCACHE_NONE)
+        lc->slots[slot->prev].next = slot->next;
+    else
+        lc->head = slot->next;
+    if (slot->next != LRUCACHE_NONE)
+        lc->slots[slot->next].prev = slot->prev;
+    else
+        lc->tail = slot->prev;
+}
+
+/**
+ * @brief Puts the entry of slot i at the front of the recency list
+ */
+static void lrucache_pushfront (lrucache lc, uint32_t i)
+{
+    struct _lrucache_slot *slot = &lc->slots[i];
+    slot->prev = LRUCACHE_NONE;
+    slot->next = lc->head;
+    if (lc->head != LRUCACHE_NONE)
+        lc->slots[lc->head].prev = i;
+    else
+        lc->tail = i;
+    lc->head = i;
+}
+
+/**
+ * @brief Marks the entry of slot i as used
+ */
+static void lrucache_touch (lrucache lc, uint32_t i)
+{
+    if (lc->policy == LRUCACHE_CLOCK)
+        lc->slots[i].referenced = true;
+    else if (lc->head != i) {
+        lrucache_unlink (lc, i);
+        lrucache_pushfront (lc, i);
+    }
+}
+
+/**
+ * @brief Removes the entry of slot i
+ */
+static void lrucache_removeat (lrucache lc, uint32_t i)
+{
+    lrucache_unlink (lc, i);
+    // shift back the following entries until one is empty or already at its home
+    uint32_t j = (i + 1) & lc->mask;
+    while (lc->slots[j].dist > 1) {
+        lrucache_move (lc, j, i);
+        lc->slots[i].dist--;
+        i = j;
+        j = (j + 1) & lc->mask;
+    }
+    lc->slots[i].dist = 0;
+    lc->length--;
+}
+
+/**
+ * @brief Removes the least recently used entry, or with the clock policy the first one not used since its last chance
+ */
+static void lrucache_evict (lrucache lc)
+{
+    // each pass clears one bit, so the hand stops within one lap
+    while (lc->policy == LRUCACHE_CLOCK && lc->slots[lc->tail].referenced) {
+        uint32_t i = lc->tail;
+        lc->slots[i].referenced = false;
+        lrucache_unlink (lc, i);
+        lrucache_pushfront (lc, i);
+    }
+    lrucache_removeat (lc, lc->tail);
+}
+
+/**
+ * @brief Inserts an entry whose key isn't in the lrucache at the front of the recency list
+ *
+ * The entry takes the first slot of its probe sequence whose entry is
+ * closer to its home, and the entries from there to the next empty slot
+ * are shifted forward by one.
+ */
+static void lrucache_insert (lrucache lc, int64_t key, int64_t value)
+{
+    uint32_t i = lrucache_hash (key) & lc->mask;
+    uint32_t dist = 1;
+    while (lc->slots[i].dist >= dist) {
+        i = (i + 1) & lc->mask;
+        dist++;
+    }
+    uint32_t j = i;
+    while (lc->slots[j].dist)
+        j = (j + 1) & lc->mask;
+    while (j != i) {
+        uint32_t k = (j - 1) & lc->mask;
+        lrucache_move (lc, k, j);
+        lc->slots[j].dist++;
+        j = k;
+    }
+    struct _lrucache_slot *slot = &lc->slots[i];
+    slot->key = key;
+    slot->value = value;
+    slot->dist = dist;
+    slot->referenced = false;
+    lrucache_pushfront (lc, i);
+    lc->length++;
+}
+
+/**
+ * @brief Allocates a new lrucache in the heap
+ *
+ * Remember to free the lrucache using lrucache_delete (&lc);
+ *
+ * @param capacity Max number of entries, from 1 to LRUCACHE_MAXCAPACITY
+ * @param policy LRUCACHE_LRU or LRUCACHE_CLOCK
+ * @return lrucache Returns NULL if capacity or policy is invalid
+ */
+lrucache new_lrucache (uint32_t capacity, int policy)
+{
+    if (!capacity || capacity > LRUCACHE_MAXCAPACITY)
+        return NULL;
+    if (policy != LRUCACHE_LRU && policy != LRUCACHE_CLOCK)
+        return NULL;
+    // a full lrucache keeps at most 7 / 8 of its slots full, and one always empty
+    uint64_t slots = 8;
+    while (slots / 8 * 7 < capacity || slots == capacity)
+        slots *= 2;
+    lrucache lc = malloc (sizeof (struct _lrucache));
+    if (!lc)
+        return NULL;
+    lc->slots = calloc (slots, sizeof (struct _lrucache_slot));
+    if (!lc->slots) {
+        free (lc);
+        return NULL;
+    }
+    lc->mask = slots - 1;
+    lc->capacity = capacity;
+    lc->length = 0;
+    lc->head = LRUCACHE_NONE;
+    lc->tail = LRUCACHE_NONE;
+    lc->policy = policy;
+    return lc;
+}
+
+/**
+ * @brief Sets value of a key, adding the key if it's not in the lrucache
+ *
+ * Evicts the least recently used entry if the lrucache is full. The key
+ * becomes the most recently used one.
+ *
+ * @param lc The lrucache
+ * @param key The key
+ * @param value The value
+ * @return bool True if successful
+ */
+bool lrucache_put (lrucache lc, int64_t key, int64_t value)
+{
+    if (!lc)
+        return false;
+    uint32_t i = lrucache_lookup (lc, key);
+    if (i != LRUCACHE_NONE) {
+        lc->slots[i].value = value;
+        lrucache_touch (lc, i);
+        return true;
+    }
+    if (lc->length == lc->capacity)
+        lrucache_evict (lc);
+    lrucache_insert (lc, key, value);
+    return true;
+}
+
+/**
+ * @brief Gets value of a key, marking it as used
+ *
+ * There's no way to be sure that LRUCACHE_ERROR value was returned as a
+ * result of error, or if that exact number had actually been stored.
+ * Use lrucache_find if that matters.
+ *
+ * @param lc The lrucache
+ * @param key The key
+ * @return int64_t Returns LRUCACHE_ERROR if key isn't found
+ */
+int64_t lrucache_get (lrucache lc, int64_t key)
+{
+    int64_t value;
+    if (!lrucache_find (lc, key, &value))
+        return LRUCACHE_ERROR;
+    return value;
+}
+
+/**
+ * @brief Finds value of a key, marking it as used
+ * @param lc The lrucache
+ * @param key The key
+ * @param value Set to value of key if it's found, may be NULL
+ * @return bool True if key is found
+ */
+bool lrucache_find (lrucache lc, int64_t key, int64_t *value)
+{
+    if (!lc)
+        return false;
+    uint32_t i = lrucache_lookup (lc, key);
+    if (i == LRUCACHE_NONE)
+        return false;
+    if (value)
+        *value = lc->slots[i].value;
+    lrucache_touch (lc, i);
+    return true;
+}
+
+/**
+ * @brief Checks if a key is in the lrucache, without marking it as used
+ * @param lc The lrucache
+ * @param key The key
+ * @return bool
+ */
+bool lrucache_has (lrucache lc, int64_t key)
+{
+    if (!lc)
+        return false;
+    return lrucache_lookup (lc, key) != LRUCACHE_NONE;
+}
+
+/**
+ * @brief Removes a key and its value
+ * @param lc The lrucache
+ * @param key The key
+ * @return bool False if key isn't found
+ */
+bool lrucache_remove (lrucache lc, int64_t key)
+{
+    if (!lc)
+        return false;
+    uint32_t i = lrucache_lookup (lc, key);
+    if (i == LRUCACHE_NONE)
+        return false;
+    lrucache_removeat (lc, i);
+    return true;
+}
+
+/**
+ * @brief Gets number of entries
+ * @param lc The lrucache
+ * @return uint64_t
+ */
+uint64_t lrucache_getlen (lrucache lc)
+{
+    if (!lc)
+        return 0;
+    return lc->length;
+}
+
+/**
+ * @brief Gets max number of entries
+ * @param lc The lrucache
+ * @return uint64_t
+ */
+uint64_t lrucache_getcapacity (lrucache lc)
+{
+    if (!lc)
+        return 0;
+    return lc->capacity;
+}
+
+/**
+ * @brief Loop through all entries, from the next one to be evicted to the most recent one
+ *
+ * With LRUCACHE_CLOCK the order is that of insertion, entries whose
+ * reference bit is set are evicted later than it shows. The callback must
+ * not add or remove keys.
+ *
+ * @param lc The lrucache
+ * @param callback Function pointer to a function. The arguments of the function is a key and a pointer to its value.
+ * @return bool
+ */
+bool lrucache_foreach (lrucache lc, void (*callback)(int64_t key, int64_t *value))
+{
+    if (!lc || !callback)
+        return false;
+    for (uint32_t i = lc->tail; i != LRUCACHE_NONE; i = lc->slots[i].prev)
+        callback (lc->slots[i].key, &lc->slots[i].value);
+    return true;
+}
+
+/**
+ * @brief Removes all entries
+ * @param lc The lrucache
+ * @return bool
+ */
+bool lrucache_clear (lrucache lc)
+{
+    if (!lc)
+        return false;
+    memset (lc->slots, 0, ((uint64_t) lc->mask + 1) * sizeof (struct _lrucache_slot));
+    lc->length = 0;
+    lc->head = LRUCACHE_NONE;
+    lc->tail = LRUCACHE_NONE;
+    return true;
+}
+
+/**
+ * @brief Deletes an lrucache
+ *
+ * This function is basically a wrapper around free().
+ * Also sets lrucache pointer to NULL.
+ *
+ * This function is recommended over free as the programmer
+ * might forget to set lrucache pointer to NULL. As a result,
+ * another lrucache operation will cause some undefined behaviour.
+ * Additionally, this function is more convenient.
+ *
+ * @param lrucache* Reference to the lrucache, is set to NULL.
+ */
+void lrucache_delete (lrucache *lc)
+{
+    if (!lc || !*lc)
+        return;
+    free ((*lc)->slots);
+    free (*lc);
+    *lc = NULL;
+}
@@ -0,0 +1,198 @@
+# ifndef LRUCACHE_H
+# define LRUCACHE_H 1
+
+# include <stdlib.h>
+# include <inttypes.h>
+# include <stdint.h>
+# include <stdbool.h>
+# include <string.h>
+
+# define LRUCACHE_ERROR 0x0123456789abcdeful
+// eviction policies, see new_lrucache
+# define LRUCACHE_LRU 0
+# define LRUCACHE_CLOCK 1
+// largest capacity of an lrucache
+# define LRUCACHE_MAXCAPACITY 0x40000000u
+// slot index that ends the recency list
+# define LRUCACHE_NONE 0xffffffffu
+
+struct _lrucache_slot {
+    int64_t key;
+    int64_t value;
+    uint32_t prev;              // slot of the next more recent entry, LRUCACHE_NONE if none
+    uint32_t next;              // slot of the next less recent entry, LRUCACHE_NONE if none
+    uint32_t dist;              // probe distance + 1, 0 if slot is empty
+    bool referenced;            // clock policy, entry was hit since the hand last passed it
+};
+
+struct _lrucache {
+    struct _lrucache_slot *slots;
+    uint32_t mask;              // number of slots - 1, a power of 2
+    uint32_t capacity;          // max number of entries
+    uint32_t length;            // number of entries
+    uint32_t head;              // slot of most recent entry, LRUCACHE_NONE if empty
+    uint32_t tail;              // slot of least recent entry, LRUCACHE_NONE if empty
+    int policy;
+};
+
+/**
+ * @brief The lrucache struct
+ *
+ * A cache from int64_t keys to int64_t values holding at most a fixed
+ * number of entries. Putting a new key into a full lrucache evicts the
+ * entry that was used least recently. Get, put and eviction take O(1)
+ * time, and all memory is allocated by new_lrucache.
+ *
+ * Entries live in the slots of an open addressing hash table with Robin
+ * Hood hashing, and each slot also holds the links of a doubly linked
+ * recency list, so there's no separate list node to allocate or chase.
+ * When insertion or removal shifts an entry to another slot, its two
+ * neighbours in the list are pointed to the new slot.
+ *
+ * With LRUCACHE_LRU, every hit moves its entry to the front of the list.
+ * With LRUCACHE_CLOCK, a hit only sets a reference bit, so hits write no
+ * memory other than the slot they read. The list then keeps insertion
+ * order, and eviction gives entries whose bit is set a second chance by
+ * clearing it and moving them to the front, like the hand of a clock.
+ * Its hit ratio is close to LRU.
+ *
+ * // new lrucache
+ * lrucache lc = new_lrucache (1024, LRUCACHE_LRU);
+ *
+ * // functions
+ * bool lrucache_put (lrucache lc, int64_t key, int64_t value);
+ * int64_t lrucache_get (lrucache lc, int64_t key);
+ * bool lrucache_find (lrucache lc, int64_t key, int64_t *value);
+ * bool lrucache_has (lrucache lc, int64_t key);
+ * bool lrucache_remove (lrucache lc, int64_t key);
+ * uint64_t lrucache_getlen (lrucache lc);
+ * uint64_t lrucache_getcapacity (lrucache lc);
+ * bool lrucache_foreach (lrucache lc, void (*callback)(int64_t key, int64_t *value));
+ * bool lrucache_clear (lrucache lc);
+ *
+ * // deleting lrucache
+ * void lrucache_delete (lrucache *lc);
+ *
+ * // avoid accessing following lrucache members
+ * lc->slots;       // lrucache entries and links
+ * lc->mask;        // lrucache number of slots - 1
+ * lc->capacity;    // lrucache max number of entries
+ * lc->length;      // lrucache number of entries
+ * lc->head;        // lrucache most recent entry
+ * lc->tail;        // lrucache least recent entry
+ * lc->policy;      // lrucache eviction policy
+ */
+typedef struct _lrucache *lrucache;
+
+/**
+ * @brief Allocates a new lrucache in the heap
+ *
+ * Remember to free the lrucache using lrucache_delete (&lc);
+ *
+ * @param capacity Max number of entries, from 1 to LRUCACHE_MAXCAPACITY
+ * @param policy LRUCACHE_LRU or LRUCACHE_CLOCK
+ * @return lrucache Returns NULL if capacity or policy is invalid
+ */
+lrucache new_lrucache (uint32_t capacity, int policy);
+
+/**
+ * @brief Sets value of a key, adding the key if it's not in the lrucache
+ *
+ * Evicts the least recently used entry if the lrucache is full. The key
+ * becomes the most recently used one.
+ *
+ * @param lc The lrucache
+ * @param key The key
+ * @param value The value
+ * @return bool True if successful
+ */
+bool lrucache_put (lrucache lc, int64_t key, int64_t value);
+
+/**
+ * @brief Gets value of a key, marking it as used
+ *
+ * There's no way to be sure that LRUCACHE_ERROR value was returned as a
+ * result of error, or if that exact number had actually been stored.
+ * Use lrucache_find if that matters.
+ *
+ * @param lc The lrucache
+ * @param key The key
+ * @return int64_t Returns LRUCACHE_ERROR if key isn't found
+ */
+int64_t lrucache_get (lrucache lc, int64_t key);
+
+/**
+ * @brief Finds value of a key, marking it as used
+ * @param lc The lrucache
+ * @param key The key
+ * @param value Set to value of key if it's found, may be NULL
+ * @return bool True if key is found
+ */
+bool lrucache_find (lrucache lc, int64_t key, int64_t *value);
+
+/**
+ * @brief Checks if a key is in the lrucache, without marking it as used
+ * @param lc The lrucache
+ * @param key The key
+ * @return bool
+ */
+bool lrucache_has (lrucache lc, int64_t key);
+
+/**
+ * @brief Removes a key and its value
+ * @param lc The lrucache
+ * @param key The key
+ * @return bool False if key isn't found
+ */
+bool lrucache_remove (lrucache lc, int64_t key);
+
+/**
+ * @brief Gets number of entries
+ * @param lc The lrucache
+ * @return uint64_t
+ */
+uint64_t lrucache_getlen (lrucache lc);
+
+/**
+ * @brief Gets max number of entries
+ * @param lc The lrucache
+ * @return uint64_t
+ */
+uint64_t lrucache_getcapacity (lrucache lc);
+
+/**
+ * @brief Loop through all entries, from the next one to be evicted to the most recent one
+ *
+ * With LRUCACHE_CLOCK the order is that of insertion, entries whose
+ * reference bit is set are evicted later than it shows. The callback must
+ * not add or remove keys.
+ *
+ * @param lc The lrucache
+ * @param callback Function pointer to a function. The arguments of the function is a key and a pointer to its value.
+ * @return bool
+ */
+bool lrucache_foreach (lrucache lc, void (*callback)(int64_t key, int64_t *value));
+
+/**
+ * @brief Removes all entries
+ * @param lc The lrucache
+ * @return bool
+ */
+bool lrucache_clear (lrucache lc);
+
+/**
+ * @brief Deletes an lrucache
+ *
+ * This function is basically a wrapper around free().
+ * Also sets lrucache pointer to NULL.
+ *
+ * This function is recommended over free as the programmer
+ * might forget to set lrucache pointer to NULL. As a result,
+ * another lrucache operation will cause some undefined behaviour.
+ * Additionally, this function is more convenient.
+ *
+ * @param lrucache* Reference to the lrucache, is set to NULL.
+ */
+void lrucache_delete (lrucache *lc);
+
+# endif
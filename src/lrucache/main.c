@@ -0,0 +1,72 @@
+# include <stdio.h>
+# include <time.h>
+# include "lrucache.h"
+
+void callback (int64_t key, int64_t *value)
+{
+    printf ("%ld: %ld\n", key, *value);
+}
+
+double now ()
+{
+    struct timespec ts;
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/**
+ * @brief Skewed key from a universe of n keys, small keys are much more frequent
+ */
+int64_t skewed (uint64_t *state, uint64_t n)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    double u = (*state >> 11) * 0x1.0p-53;
+    return (int64_t) (u * u * u * n);
+}
+
+void bench (uint32_t capacity, uint64_t universe, int policy)
+{
+    uint64_t n = 10000000, hits = 0, state = 88172645463325252ull;
+    lrucache lc = new_lrucache (capacity, policy);
+
+    // look a key up, and load it into the cache on a miss
+    double start = now ();
+    for (uint64_t i = 0; i < n; i++) {
+        int64_t key = skewed (&state, universe);
+        if (lrucache_find (lc, key, NULL))
+            hits++;
+        else
+            lrucache_put (lc, key, key);
+    }
+    double elapsed = (now () - start) / n;
+
+    printf ("%-6s %10u %10lu %10.1f %10.2f\n", policy == LRUCACHE_CLOCK ? "clock" : "lru",
+        capacity, universe, elapsed, 100.0 * hits / n);
+    lrucache_delete (&lc);
+}
+
+int main (int argc, char **argv)
+{
+    lrucache lc = new_lrucache (3, LRUCACHE_LRU);
+
+    lrucache_put (lc, 1, 10);
+    lrucache_put (lc, 2, 20);
+    lrucache_put (lc, 3, 30);
+    lrucache_get (lc, 1);
+    lrucache_put (lc, 4, 40);
+    printf ("Value of 1 = %ld, has 2 = %d, length = %lu\n", lrucache_get (lc, 1), lrucache_has (lc, 2), lrucache_getlen (lc));
+    lrucache_foreach (lc, callback);
+    lrucache_delete (&lc);
+
+    // hit ratio and time of a cache-aside loop over skewed keys, max capacity given as first argument
+    uint32_t max = argc > 1 ? atoi (argv[1]) : 1000000;
+    printf ("\n%-6s %10s %10s %10s %10s\n", "policy", "capacity", "keys", "ns per op", "hit %");
+    for (uint32_t capacity = 1000; capacity <= max; capacity *= 10) {
+        bench (capacity, capacity * 10ull, LRUCACHE_LRU);
+        bench (capacity, capacity * 10ull, LRUCACHE_CLOCK);
+    }
+
+    return 0;
+}
@@ -0,0 +1,28 @@
+# include <stdio.h>
+# include "radix.h"
+
+int main ()
+{
+    radix rd = new_radix ();
+
+    const char *lat = "/svc/a/metrics/http/latency";
+    const char *err = "/svc/a/metrics/http/errors";
+    const char *cpu = "/svc/b/metrics/cpu";
+
+    // single child chains collapse into one edge
+    radix_setdata (rd, lat, strlen (lat), 45);
+    radix_setdata (rd, err, strlen (err), 25);
+    radix_setdata (rd, cpu, strlen (cpu), 19);
+    printf ("%lu nodes for 3 paths\n", radix_getnodecount (rd));
+
+    printf ("%s = %ld\n", lat, radix_getdata (rd, lat, strlen (lat)));
+    // prefixes of set paths exist with value 0, as in tree
+    printf ("/svc/a = %ld\n", radix_getdata (rd, "/svc/a", 6));
+
+    // removes /svc/a and everything below it
+    radix_rmnode (rd, "/svc/a", 6);
+    printf ("%lu nodes after removing /svc/a\n", radix_getnodecount (rd));
+
+    radix_delete (&rd);
+    return 0;
+}
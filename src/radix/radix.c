@@ -0,0 +1,448 @@
+# include "radix.h"
+
+// paths up to this long are made canonical on the stack, longer ones on the heap
+# define RADIX_STACKKEY 256
+
+static char *radix_canon (const char *path, uint64_t len, char *stackkey, uint64_t *keylen);
+static _radix_node radix_newnode (const char *label, uint64_t labellen);
+static bool radix_findchild (_radix_node node, char byte, uint32_t *pos);
+static bool radix_addchild (_radix_node node, _radix_node child, uint32_t pos);
+static void radix_removechild (_radix_node node, uint32_t pos);
+static uint64_t radix_common (_radix_node node, const char *key, uint64_t keylen);
+static _radix_node radix_merge (radix rd, _radix_node node);
+static bool radix_tidy (radix rd, _radix_node node, _radix_node parent, uint32_t pos);
+static void radix_freesubtree (radix rd, _radix_node node);
+static _radix_node radix_insert (radix rd, char *key, uint64_t keylen);
+
+/**
+ * @brief Makes canonical key of a path: "/seg1/seg2", root path is ""
+ *
+ * @param path The path
+ * @param len Length of path
+ * @param stackkey Buffer of RADIX_STACKKEY bytes, used if key fits in it
+ * @param keylen Set to length of key
+ * @return char* The key, stackkey or a heap buffer to be freed, NULL if allocation failed
+ */
+static char *radix_canon (const char *path, uint64_t len, char *stackkey, uint64_t *keylen)
+{
+    // key is at most one byte longer than path, for the leading '/'
+    char *key = len + 1 <= RADIX_STACKKEY ? stackkey : malloc (len + 1);
+    if (!key)
+        return NULL;
+    uint64_t n = 0, i = 0;
+    while (i < len) {
+        while (i < len && path[i] == '/')
+            i++;
+        if (i == len)
+            break;
+        key[n++] = '/';
+        while (i < len && path[i] != '/')
+            key[n++] = path[i++];
+    }
+    *keylen = n;
+    return key;
+}
+
+/**
+ * @brief Allocates a node without children or value
+ * @return _radix_node NULL if allocation failed
+ */
+static _radix_node radix_newnode (const char *label, uint64_t labellen)
+{
+    _radix_node node = malloc (sizeof (struct _radix_node) + labellen);
+    if (!node)
+        return NULL;
+    node->hasvalue = false;
+    node->value = 0;
+    node->childcount = 0;
+    node->childcap = 0;
+    node->children = NULL;
+    node->labellen = labellen;
+    memcpy (node->label, label, labellen);
+    return node;
+}
+
+/**
+ * @brief Binary searches children of node for one whose label starts with byte
+ * @param pos Set to index of child, or index where such a child would go
+ * @return bool True if found
+ */
+static bool radix_findchild (_radix_node node, char byte, uint32_t *pos)
+{
+    uint32_t lo = 0, hi = node->childcount;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        unsigned char first = node->children[mid]->label[0];
+        if (first == (unsigned char) byte) {
+            *pos = mid;
+            return true;
+        }
+        if (first < (unsigned char) byte)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    *pos = lo;
+    return false;
+}
+
+/**
+ * @brief Inserts child at index pos of children of node
+ * @return bool False if allocation failed
+ */
+static bool radix_addchild (_radix_node node, _radix_node child, uint32_t pos)
+{
+    if (node->childcount == node->childcap) {
+        uint32_t childcap = node->childcap ? 2 * node->childcap : 2;
+        _radix_node *children = realloc (node->children, childcap * sizeof (_radix_node));
+        if (!children)
+            return false;
+        node->children = children;
+        node->childcap = childcap;
+    }
+    memmove (&node->children[pos + 1], &node->children[pos], (node->childcount - pos) * sizeof (_radix_node));
+    node->children[pos] = child;
+    node->childcount++;
+    return true;
+}
+
+/**
+ * @brief Removes child at index pos from children of node, the child isn't freed
+ */
+static void radix_removechild (_radix_node node, uint32_t pos)
+{
+    node->childcount--;
+    memmove (&node->children[pos], &node->children[pos + 1], (node->childcount - pos) * sizeof (_radix_node));
+}
+
+/**
+ * @brief Length of common prefix of label of node and key
+ */
+static uint64_t radix_common (_radix_node node, const char *key, uint64_t keylen)
+{
+    uint64_t max = node->labellen < keylen ? node->labellen : keylen;
+    uint64_t i = 0;
+    while (i < max && node->label[i] == key[i])
+        i++;
+    return i;
+}
+
+/**
+ * @brief Merges a node that has no value and one child with that child
+ *
+ * If allocation fails, nothing is merged, which is still correct.
+ *
+ * @return _radix_node The merged node, to take the place of node in its parent
+ */
+static _radix_node radix_merge (radix rd, _radix_node node)
+{
+    _radix_node child = node->children[0];
+    _radix_node merged = malloc (sizeof (struct _radix_node) + node->labellen + child->labellen);
+    if (!merged)
+        return node;
+    memcpy (merged->label, node->label, node->labellen);
+    memcpy (merged->label + node->labellen, child->label, child->labellen);
+    merged->labellen = node->labellen + child->labellen;
+    merged->hasvalue = child->hasvalue;
+    merged->value = child->value;
+    merged->childcount = child->childcount;
+    merged->childcap = child->childcap;
+    merged->children = child->children;
+    free (node->children);
+    free (node);
+    free (child);
+    rd->nodecount--;
+    return merged;
+}
+
+/**
+ * @brief Restores compactness of a node after removal of its value or a child
+ *
+ * A node other than the root without a value is removed if it has no
+ * children, and merged with its child if it has one.
+ *
+ * @param rd The radix
+ * @param node The node
+ * @param parent Parent of node, NULL if node is the root
+ * @param pos Index of node in children of parent
+ * @return bool True if node was removed from parent
+ */
+static bool radix_tidy (radix rd, _radix_node node, _radix_node parent, uint32_t pos)
+{
+    if (!parent || node->hasvalue)
+        return false;
+    if (node->childcount == 0) {
+        radix_removechild (parent, pos);
+        free (node->children);
+        free (node);
+        rd->nodecount--;
+        return true;
+    }
+    if (node->childcount == 1)
+        parent->children[pos] = radix_merge (rd, node);
+    return false;
+}
+
+/**
+ * @brief Frees node and every node below it, without recursion or allocation
+ */
+static void radix_freesubtree (radix rd, _radix_node node)
+{
+    // the value of a node being freed is no longer needed, so it holds the parent to return to
+    node->value = (int64_t) (uintptr_t) NULL;
+    while (node) {
+        if (node->childcount > 0) {
+            _radix_node child = node->children[--node->childcount];
+            child->value = (int64_t) (uintptr_t) node;
+            node = child;
+            continue;
+        }
+        _radix_node parent = (_radix_node) (uintptr_t) node->value;
+        free (node->children);
+        free (node);
+        rd->nodecount--;
+        node = parent;
+    }
+}
+
+/**
+ * @brief Finds node of a canonical key, creating and splitting nodes as needed
+ * @return _radix_node The node, NULL if allocation failed
+ */
+static _radix_node radix_insert (radix rd, char *key, uint64_t keylen)
+{
+    _radix_node node = rd->root;
+    uint64_t i = 0;
+    while (i < keylen) {
+        uint32_t pos;
+        if (!radix_findchild (node, key[i], &pos)) {
+            _radix_node leaf = radix_newnode (key + i, keylen - i);
+            if (!leaf)
+                return NULL;
+            if (!radix_addchild (node, leaf, pos)) {
+                free (leaf);
+                return NULL;
+            }
+            rd->nodecount++;
+            return leaf;
+        }
+        _radix_node child = node->children[pos];
+        uint64_t common = radix_common (child, key + i, keylen - i);
+        if (common < child->labellen) {
+            // split edge of child, the common part goes to a new node in its place
+            _radix_node mid = radix_newnode (child->label, common);
+            if (!mid)
+                return NULL;
+            if (!radix_addchild (mid, child, 0)) {
+                free (mid);
+                return NULL;
+            }
+            child->labellen -= common;
+            memmove (child->label, child->label + common, child->labellen);
+            node->children[pos] = mid;
+            rd->nodecount++;
+            child = mid;
+        }
+        node = child;
+        i += common;
+    }
+    return node;
+}
+
+/**
+ * @brief Allocates a new radix in the heap
+ *
+ * Remember to free the radix using radix_delete (&rd);
+ *
+ * @return radix The radix
+ */
+radix new_radix ()
+{
+    radix rd = malloc (1 * sizeof (struct _radix));
+    if (!rd)
+        return NULL;
+    rd->root = radix_newnode ("", 0);
+    if (!rd->root) {
+        free (rd);
+        return NULL;
+    }
+    rd->nodecount = 1;
+    return rd;
+}
+
+/**
+ * @brief Sets data of a path
+ * @param rd The radix
+ * @param path The path, need not be null terminated
+ * @param len Length of path
+ * @param val Value to be set at path
+ * @return bool True if successful
+ */
+bool radix_setdata (radix rd, const char *path, uint64_t len, int64_t val)
+{
+    char stackkey[RADIX_STACKKEY];
+    uint64_t keylen;
+    char *key = radix_canon (path, len, stackkey, &keylen);
+    if (!key)
+        return false;
+    _radix_node node = radix_insert (rd, key, keylen);
+    if (node) {
+        node->hasvalue = true;
+        node->value = val;
+    }
+    if (key != stackkey)
+        free (key);
+    return node != NULL;
+}
+
+/**
+ * @brief Gets data of a path
+ * @param rd The radix
+ * @param path The path, need not be null terminated
+ * @param len Length of path
+ * @return int64_t Returns RADIX_ERROR on error
+ */
+int64_t radix_getdata (radix rd, const char *path, uint64_t len)
+{
+    char stackkey[RADIX_STACKKEY];
+    uint64_t keylen;
+    char *key = radix_canon (path, len, stackkey, &keylen);
+    if (!key)
+        return RADIX_ERROR;
+    int64_t value = RADIX_ERROR;
+    _radix_node node = rd->root;
+    uint64_t i = 0;
+    while (i < keylen) {
+        uint32_t pos;
+        if (!radix_findchild (node, key[i], &pos))
+            goto done;
+        _radix_node child = node->children[pos];
+        uint64_t common = radix_common (child, key + i, keylen - i);
+        if (common < child->labellen) {
+            // path ends inside an edge, it exists if a segment of a longer path ends there
+            if (i + common == keylen && child->label[common] == '/')
+                value = 0;
+            goto done;
+        }
+        node = child;
+        i += common;
+    }
+    uint32_t pos;
+    if (node->hasvalue)
+        value = node->value;
+    else if (keylen == 0 || radix_findchild (node, '/', &pos))
+        value = 0;
+done:
+    if (key != stackkey)
+        free (key);
+    return value;
+}
+
+/**
+ * @brief Removes a path and every path below it
+ *
+ * The root path can't be removed, use radix_delete instead.
+ *
+ * @param rd The radix
+ * @param path The path, need not be null terminated
+ * @param len Length of path
+ * @return bool True if successful
+ */
+bool radix_rmnode (radix rd, const char *path, uint64_t len)
+{
+    char stackkey[RADIX_STACKKEY];
+    uint64_t keylen;
+    char *key = radix_canon (path, len, stackkey, &keylen);
+    if (!key)
+        return false;
+    bool success = false;
+    _radix_node node = rd->root, parent = NULL, grand = NULL;
+    uint32_t nodepos = 0, parentpos = 0;
+    uint64_t i = 0;
+    if (keylen == 0)
+        goto done;
+    while (i < keylen) {
+        uint32_t pos;
+        if (!radix_findchild (node, key[i], &pos))
+            goto done;
+        _radix_node child = node->children[pos];
+        uint64_t common = radix_common (child, key + i, keylen - i);
+        if (common < child->labellen) {
+            // path ends inside edge of child, so all of child is below the path
+            if (i + common != keylen || child->label[common] != '/')
+                goto done;
+            radix_removechild (node, pos);
+            radix_freesubtree (rd, child);
+            if (radix_tidy (rd, node, parent, nodepos))
+                radix_tidy (rd, parent, grand, parentpos);
+            success = true;
+            goto keepparent;
+        }
+        grand = parent;
+        parentpos = nodepos;
+        parent = node;
+        nodepos = pos;
+        node = child;
+        i += common;
+    }
+    uint32_t pos;
+    success = node->hasvalue;
+    if (radix_findchild (node, '/', &pos)) {
+        _radix_node below = node->children[pos];
+        radix_removechild (node, pos);
+        radix_freesubtree (rd, below);
+        success = true;
+    }
+    if (!success)
+        goto done;
+    node->hasvalue = false;
+    if (radix_tidy (rd, node, parent, nodepos))
+        radix_tidy (rd, parent, grand, parentpos);
+keepparent:
+    // the parent path existed before, as in tree it still exists after
+    while (keylen > 0 && key[--keylen] != '/');
+    if (keylen > 0) {
+        _radix_node above = radix_insert (rd, key, keylen);
+        if (above && !above->hasvalue) {
+            above->hasvalue = true;
+            above->value = 0;
+        }
+    }
+done:
+    if (key != stackkey)
+        free (key);
+    return success;
+}
+
+/**
+ * @brief Gets number of nodes in the radix, root included
+ * @param rd The radix
+ * @return uint64_t The number of nodes
+ */
+uint64_t radix_getnodecount (radix rd)
+{
+    if (!rd)
+        return 0;
+    return rd->nodecount;
+}
+
+/**
+ * @brief Deletes a radix
+ *
+ * This function is basically a wrapper around free().
+ * Also sets radix pointer to NULL.
+ *
+ * This function is recommended over free as the programmer
+ * might forget to set radix pointer to NULL. As a result,
+ * another radix operation will cause some undefined behaviour.
+ *
+ * @param radix* Reference to the radix, is set to NULL.
+ */
+void radix_delete (radix *rd)
+{
+    if (!rd || !*rd)
+        return;
+    radix_freesubtree (*rd, (*rd)->root);
+    free (*rd);
+    *rd = NULL;
+}
@@ -0,0 +1,119 @@
+# ifndef RADIX_H
+# define RADIX_H 1
+
+# include <stdlib.h>
+# include <inttypes.h>
+# include <stdint.h>
+# include <stdbool.h>
+# include <string.h>
+
+# define RADIX_ERROR 0x0123456789abcdeful
+
+typedef struct _radix_node {
+    bool hasvalue;                  // true if a path ends at this node
+    int64_t value;
+    uint32_t childcount;
+    uint32_t childcap;
+    struct _radix_node **children;  // sorted by first byte of label
+    uint32_t labellen;
+    char label[];                   // bytes of path on the edge leading to this node
+} *_radix_node;
+
+struct _radix {
+    _radix_node root;
+    uint64_t nodecount;
+};
+
+/**
+ * @brief The radix struct
+ *
+ * A compressed radix (Patricia) trie keyed on whole path strings, with the
+ * same path semantics as tree. Each edge holds a run of path bytes, so
+ * chains of single children collapse into one node, instead of taking
+ * one tree node per segment.
+ *
+ * Paths are split into segments at '/', empty segments are ignored, so
+ * "/a//b/" is the same as "a/b". Setting a path makes all its prefixes
+ * exist with value 0, as tree_setdata does, and removing a path removes
+ * everything below it, as tree_rmnode does.
+ *
+ * // new radix
+ * radix rd = new_radix ();
+ *
+ * // functions
+ * bool radix_setdata (radix rd, const char *path, uint64_t len, int64_t val);
+ * int64_t radix_getdata (radix rd, const char *path, uint64_t len);
+ * bool radix_rmnode (radix rd, const char *path, uint64_t len);
+ * uint64_t radix_getnodecount (radix rd);
+ *
+ * // deleting radix
+ * void radix_delete (radix *rd);
+ *
+ * // avoid accessing following radix members
+ * rd->root;        // radix root node
+ * rd->nodecount;   // radix number of nodes
+ */
+typedef struct _radix *radix;
+
+/**
+ * @brief Allocates a new radix in the heap
+ *
+ * Remember to free the radix using radix_delete (&rd);
+ *
+ * @return radix The radix
+ */
+radix new_radix ();
+
+/**
+ * @brief Sets data of a path
+ * @param rd The radix
+ * @param path The path, need not be null terminated
+ * @param len Length of path
+ * @param val Value to be set at path
+ * @return bool True if successful
+ */
+bool radix_setdata (radix rd, const char *path, uint64_t len, int64_t val);
+
+/**
+ * @brief Gets data of a path
+ * @param rd The radix
+ * @param path The path, need not be null terminated
+ * @param len Length of path
+ * @return int64_t Returns RADIX_ERROR on error
+ */
+int64_t radix_getdata (radix rd, const char *path, uint64_t len);
+
+/**
+ * @brief Removes a path and every path below it
+ *
+ * The root path can't be removed, use radix_delete instead.
+ *
+ * @param rd The radix
+ * @param path The path, need not be null terminated
+ * @param len Length of path
+ * @return bool True if successful
+ */
+bool radix_rmnode (radix rd, const char *path, uint64_t len);
+
+/**
+ * @brief Gets number of nodes in the radix, root included
+ * @param rd The radix
+ * @return uint64_t The number of nodes
+ */
+uint64_t radix_getnodecount (radix rd);
+
+/**
+ * @brief Deletes a radix
+ *
+ * This function is basically a wrapper around free().
+ * Also sets radix pointer to NULL.
+ *
+ * This function is recommended over free as the programmer
+ * might forget to set radix pointer to NULL. As a result,
+ * another radix operation will cause some undefined behaviour.
+ *
+ * @param radix* Reference to the radix, is set to NULL.
+ */
+void radix_delete (radix *rd);
+
+# endif
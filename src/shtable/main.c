@@ -0,0 +1,88 @@
+# include <stdio.h>
+# include <time.h>
+# include "shtable.h"
+
+// lookups add their results here, or the compiler would drop the timed loops
+volatile int64_t sink;
+
+void callback (const char *key, uint64_t len, int64_t *value)
+{
+    printf ("%s (%lu): %ld\n", key, len, *value);
+}
+
+double now ()
+{
+    struct timespec ts;
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+void bench (uint64_t n, const char *format)
+{
+    double start, insert, hit, miss, removal;
+    int64_t sum = 0;
+    char key[64];
+    uint64_t len;
+    shtable st = new_shtable ();
+
+    start = now ();
+    for (uint64_t i = 0; i < n; i++) {
+        len = sprintf (key, format, i);
+        shtable_set (st, key, len, i);
+    }
+    insert = (now () - start) / n;
+
+    start = now ();
+    for (uint64_t i = 0; i < n; i++) {
+        len = sprintf (key, format, i);
+        sum += shtable_get (st, key, len);
+    }
+    hit = (now () - start) / n;
+
+    start = now ();
+    for (uint64_t i = n; i < 2 * n; i++) {
+        len = sprintf (key, format, i);
+        sum += shtable_has (st, key, len);
+    }
+    miss = (now () - start) / n;
+
+    uint64_t arena = shtable_getarenasize (st);
+    start = now ();
+    for (uint64_t i = 0; i < n; i++) {
+        len = sprintf (key, format, i);
+        shtable_remove (st, key, len);
+    }
+    removal = (now () - start) / n;
+
+    printf ("%-34s %10lu %10.1f %10.1f %10.1f %10.1f %12lu\n", format,
+        n, insert, hit, miss, removal, arena);
+    sink = sum;
+    shtable_delete (&st);
+}
+
+int main (int argc, char **argv)
+{
+    shtable st = new_shtable ();
+
+    shtable_set (st, "usr", 3, 1);
+    shtable_set (st, "local", 5, 2);
+    shtable_set (st, "share/applications", 18, 3);
+    shtable_set (st, "usr", 3, 4);
+    shtable_remove (st, "local", 5);
+    printf ("Value of usr = %ld, has local = %d, length = %lu\n", shtable_get (st, "usr", 3), shtable_has (st, "local", 5), shtable_getlen (st));
+    shtable_foreach (st, callback);
+    shtable_delete (&st);
+
+    // benchmark from 10^3 up to 10^max entries, max given as first argument
+    int max = argc > 1 ? atoi (argv[1]) : 6;
+    // times include formatting the key, short keys are stored inline, long ones in the arena
+    printf ("\n%-34s %10s %10s %10s %10s %10s %12s   ns per operation\n",
+        "keys", "entries", "insert", "hit", "miss", "delete", "arena bytes");
+    uint64_t n = 1000;
+    for (int e = 3; e <= max; e++, n *= 10) {
+        bench (n, "name%lu");
+        bench (n, "/usr/share/doc/package%lu/README");
+    }
+
+    return 0;
+}
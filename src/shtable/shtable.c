@@ -0,0 +1,396 @@
+# include "shtable.h"
+
+static uint64_t shtable_hash (const char *key, uint64_t len);
+static uint64_t shtable_thresholdof (uint64_t capacity);
+static uint64_t shtable_capacityfor (uint64_t count, uint64_t capacity);
+static const char *shtable_keyof (const struct _shtable_slot *slot);
+static uint64_t shtable_find (shtable st, const char *key, uint64_t len, uint64_t hash);
+static void shtable_place (struct _shtable_slot *slots, uint64_t mask, struct _shtable_slot entry);
+static bool shtable_resize (shtable st, uint64_t capacity);
+static char *shtable_arenaalloc (shtable st, uint64_t size);
+static void shtable_freearena (shtable st);
+
+/**
+ * @brief Hashes a key 8 bytes at a time, finishing with the murmur3 finalizer so that low bits depend on all bytes
+ */
+static uint64_t shtable_hash (const char *key, uint64_t len)
+{
+    uint64_t hash = len * 0x9e3779b97f4a7c15ull;
+    uint64_t word;
+    for (; len >= 8; key += 8, len -= 8) {
+        memcpy (&word, key, 8);
+        hash = (hash ^ word) * 0xff51afd7ed558ccdull;
+        hash ^= hash >> 32;
+    }
+    word = 0;
+    memcpy (&word, key, len);
+    hash ^= word;
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdull;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ull;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+/**
+ * @brief Max number of entries for a capacity, at least one slot is always left empty
+ */
+static uint64_t shtable_thresholdof (uint64_t capacity)
+{
+    uint64_t threshold = capacity * SHTABLE_MAXLOAD;
+    return threshold < capacity ? threshold : capacity - 1;
+}
+
+/**
+ * @brief Smallest power of 2, not less than capacity, that fits count entries
+ * @return uint64_t The capacity, 0 if it's too large
+ */
+static uint64_t shtable_capacityfor (uint64_t count, uint64_t capacity)
+{
+    while (shtable_thresholdof (capacity) < count) {
+        if (capacity > UINT64_MAX / 2 / sizeof (struct _shtable_slot))
+            return 0;
+        capacity *= 2;
+    }
+    return capacity;
+}
+
+/**
+ * @brief Bytes of the key of a full slot, inline or in the arena
+ */
+static const char *shtable_keyof (const struct _shtable_slot *slot)
+{
+    return slot->len <= SHTABLE_INLINE ? slot->key.str : slot->key.ptr;
+}
+
+/**
+ * @brief Finds slot of a key
+ * @return uint64_t The slot, st->capacity if key isn't found
+ */
+static uint64_t shtable_find (shtable st, const char *key, uint64_t len, uint64_t hash)
+{
+    uint64_t mask = st->capacity - 1;
+    uint64_t i = hash & mask;
+    // entries of key's probe sequence are never closer to their home than key would be
+    for (uint32_t dist = 1; st->slots[i].dist >= dist; dist++) {
+        struct _shtable_slot *slot = &st->slots[i];
+        if (slot->hash == hash && slot->len == len && !memcmp (shtable_keyof (slot), key, len))
+            return i;
+        i = (i + 1) & mask;
+    }
+    return st->capacity;
+}
+
+/**
+ * @brief Inserts an entry whose key isn't in the slots, taking the slot of any entry closer to its home
+ */
+static void shtable_place (struct _shtable_slot *slots, uint64_t mask, struct _shtable_slot entry)
+{
+    uint64_t i = entry.hash & mask;
+    for (entry.dist = 1; slots[i].dist; entry.dist++) {
+        if (slots[i].dist < entry.dist) {
+            struct _shtable_slot tmp = slots[i];
+            slots[i] = entry;
+            entry = tmp;
+        }
+        i = (i + 1) & mask;
+    }
+    slots[i] = entry;
+}
+
+/**
+ * @brief Moves all entries to a new array of slots, keys in the arena stay where they are
+ * @param capacity Number of slots, a power of 2
+ * @return bool False if allocation fails, the shtable is unchanged then
+ */
+static bool shtable_resize (shtable st, uint64_t capacity)
+{
+    struct _shtable_slot *slots = calloc (capacity, sizeof (struct _shtable_slot));
+    if (!slots)
+        return false;
+    for (uint64_t i = 0; i < st->capacity; i++)
+        if (st->slots[i].dist)
+            shtable_place (slots, capacity - 1, st->slots[i]);
+    free (st->slots);
+    st->slots = slots;
+    st->capacity = capacity;
+    st->threshold = shtable_thresholdof (capacity);
+    return true;
+}
+
+/**
+ * @brief Allocates bytes for a key from the arena, memory is freed with the arena only
+ * @return char* NULL if allocation failed
+ */
+static char *shtable_arenaalloc (shtable st, uint64_t size)
+{
+    if (!st->arena || st->arenaused + size > st->arenacap) {
+        // blocks are never moved, so slots can point into them
+        uint64_t arenacap = size > SHTABLE_ARENA_BLOCK ? size : SHTABLE_ARENA_BLOCK;
+        char *block = malloc (sizeof (char *) + arenacap);
+        if (!block)
+            return NULL;
+        *(char **) block = st->arena;
+        st->arena = block;
+        st->arenaused = 0;
+        st->arenacap = arenacap;
+    }
+    char *ptr = st->arena + sizeof (char *) + st->arenaused;
+    st->arenaused += size;
+    st->arenasize += size;
+    return ptr;
+}
+
+/**
+ * @brief Frees all blocks of the arena
+ */
+static void shtable_freearena (shtable st)
+{
+    char *block = st->arena;
+    while (block) {
+        char *prev = *(char **) block;
+        free (block);
+        block = prev;
+    }
+    st->arena = NULL;
+    st->arenaused = 0;
+    st->arenacap = 0;
+    st->arenasize = 0;
+}
+
+/**
+ * @brief Allocates a new shtable in the heap
+ *
+ * Remember to free the shtable using shtable_delete (&st);
+ *
+ * @return shtable
+ */
+shtable new_shtable ()
+{
+    shtable st = malloc (sizeof (struct _shtable));
+    if (!st)
+        return NULL;
+    st->slots = calloc (SHTABLE_MINCAPACITY, sizeof (struct _shtable_slot));
+    if (!st->slots) {
+        free (st);
+        return NULL;
+    }
+    st->capacity = SHTABLE_MINCAPACITY;
+    st->length = 0;
+    st->threshold = shtable_thresholdof (st->capacity);
+    st->arena = NULL;
+    st->arenaused = 0;
+    st->arenacap = 0;
+    st->arenasize = 0;
+    return st;
+}
+
+/**
+ * @brief Sets value of a key, adding a copy of the key if it's not in the shtable
+ * @param st The shtable
+ * @param key The key, need not be null terminated
+ * @param len Length of key, at most UINT32_MAX
+ * @param value The value
+ * @return bool True if successful
+ */
+bool shtable_set (shtable st, const char *key, uint64_t len, int64_t value)
+{
+    if (!st || !key || len > UINT32_MAX)
+        return false;
+    uint64_t hash = shtable_hash (key, len);
+    uint64_t i = shtable_find (st, key, len, hash);
+    if (i != st->capacity) {
+        st->slots[i].value = value;
+        return true;
+    }
+    if (st->length >= st->threshold) {
+        uint64_t capacity = shtable_capacityfor (st->length + 1, st->capacity * 2);
+        if (!capacity || !shtable_resize (st, capacity))
+            return false;
+    }
+    struct _shtable_slot entry = {.hash = hash, .len = len, .value = value};
+    if (len <= SHTABLE_INLINE)
+        memcpy (entry.key.str, key, len);
+    else {
+        char *copy = shtable_arenaalloc (st, len + 1);
+        if (!copy)
+            return false;
+        memcpy (copy, key, len);
+        copy[len] = '\0';
+        entry.key.ptr = copy;
+    }
+    shtable_place (st->slots, st->capacity - 1, entry);
+    st->length++;
+    return true;
+}
+
+/**
+ * @brief Gets value of a key
+ *
+ * There's no way to be sure that SHTABLE_ERROR value was returned as a
+ * result of error, or if that exact number had actually been stored.
+ * Use shtable_has if that matters.
+ *
+ * @param st The shtable
+ * @param key The key, need not be null terminated
+ * @param len Length of key
+ * @return int64_t Returns SHTABLE_ERROR if key isn't found
+ */
+int64_t shtable_get (shtable st, const char *key, uint64_t len)
+{
+    if (!st || !key)
+        return SHTABLE_ERROR;
+    uint64_t i = shtable_find (st, key, len, shtable_hash (key, len));
+    if (i == st->capacity)
+        return SHTABLE_ERROR;
+    return st->slots[i].value;
+}
+
+/**
+ * @brief Checks if a key is in the shtable
+ * @param st The shtable
+ * @param key The key, need not be null terminated
+ * @param len Length of key
+ * @return bool
+ */
+bool shtable_has (shtable st, const char *key, uint64_t len)
+{
+    if (!st || !key)
+        return false;
+    return shtable_find (st, key, len, shtable_hash (key, len)) != st->capacity;
+}
+
+/**
+ * @brief Removes a key and its value
+ *
+ * A key longer than SHTABLE_INLINE stays in the arena.
+ *
+ * @param st The shtable
+ * @param key The key, need not be null terminated
+ * @param len Length of key
+ * @return bool False if key isn't found
+ */
+bool shtable_remove (shtable st, const char *key, uint64_t len)
+{
+    if (!st || !key)
+        return false;
+    uint64_t i = shtable_find (st, key, len, shtable_hash (key, len));
+    if (i == st->capacity)
+        return false;
+    // shift back the following entries until one is empty or already at its home
+    uint64_t mask = st->capacity - 1;
+    uint64_t j = (i + 1) & mask;
+    while (st->slots[j].dist > 1) {
+        st->slots[i] = st->slots[j];
+        st->slots[i].dist--;
+        i = j;
+        j = (j + 1) & mask;
+    }
+    st->slots[i].dist = 0;
+    st->length--;
+    return true;
+}
+
+/**
+ * @brief Grows the shtable so that count entries fit without growing again
+ *
+ * Never shrinks the shtable.
+ *
+ * @param st The shtable
+ * @param count Number of entries
+ * @return bool True if successful
+ */
+bool shtable_reserve (shtable st, uint64_t count)
+{
+    if (!st)
+        return false;
+    uint64_t capacity = shtable_capacityfor (count, st->capacity);
+    if (!capacity)
+        return false;
+    if (capacity == st->capacity)
+        return true;
+    return shtable_resize (st, capacity);
+}
+
+/**
+ * @brief Gets number of entries
+ * @param st The shtable
+ * @return uint64_t
+ */
+uint64_t shtable_getlen (shtable st)
+{
+    if (!st)
+        return 0;
+    return st->length;
+}
+
+/**
+ * @brief Gets number of bytes of keys copied into the arena, removed keys included
+ * @param st The shtable
+ * @return uint64_t
+ */
+uint64_t shtable_getarenasize (shtable st)
+{
+    if (!st)
+        return 0;
+    return st->arenasize;
+}
+
+/**
+ * @brief Loop through all entries and take action using a callback function
+ *
+ * Entries are visited in no particular order. The callback must not add
+ * or remove keys. Keys passed to it are null terminated.
+ *
+ * @param st The shtable
+ * @param callback Function pointer to a function. The arguments of the function is a key, its length and a pointer to its value.
+ * @return bool
+ */
+bool shtable_foreach (shtable st, void (*callback)(const char *key, uint64_t len, int64_t *value))
+{
+    if (!st || !callback)
+        return false;
+    for (uint64_t i = 0; i < st->capacity; i++)
+        if (st->slots[i].dist)
+            callback (shtable_keyof (&st->slots[i]), st->slots[i].len, &st->slots[i].value);
+    return true;
+}
+
+/**
+ * @brief Removes all entries and frees the arena, keeping the slots allocated
+ * @param st The shtable
+ * @return bool
+ */
+bool shtable_clear (shtable st)
+{
+    if (!st)
+        return false;
+    memset (st->slots, 0, st->capacity * sizeof (struct _shtable_slot));
+    st->length = 0;
+    shtable_freearena (st);
+    return true;
+}
+
+/**
+ * @brief Deletes an shtable
+ *
+ * This function is basically a wrapper around free().
+ * Also sets shtable pointer to NULL.
+ *
+ * This function is recommended over free as the programmer
+ * might forget to set shtable pointer to NULL. As a result,
+ * another shtable operation will cause some undefined behaviour.
+ * Additionally, this function is more convenient.
+ *
+ * @param shtable* Reference to the shtable, is set to NULL.
+ */
+void shtable_delete (shtable *st)
+{
+    if (!st || !*st)
+        return;
+    shtable_freearena (*st);
+    free ((*st)->slots);
+    free (*st);
+    *st = NULL;
+}
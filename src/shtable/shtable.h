@@ -0,0 +1,201 @@
+# ifndef SHTABLE_H
+# define SHTABLE_H 1
+
+# include <stdlib.h>
+# include <inttypes.h>
+# include <stdint.h>
+# include <stdbool.h>
+# include <string.h>
+
+# define SHTABLE_ERROR 0x0123456789abcdeful
+// number of slots of a new shtable, always a power of 2
+# define SHTABLE_MINCAPACITY 16
+# define SHTABLE_MAXLOAD 0.875
+// keys up to this many bytes are stored in their slot, longer ones in the arena
+# define SHTABLE_INLINE 15
+// size of each block of the key arena
+# define SHTABLE_ARENA_BLOCK 65536
+
+struct _shtable_slot {
+    uint64_t hash;              // full hash of key
+    uint32_t len;               // length of key
+    uint32_t dist;              // probe distance + 1, 0 if slot is empty
+    union {
+        char str[SHTABLE_INLINE + 1];   // key of up to SHTABLE_INLINE bytes, null terminated
+        const char *ptr;                // longer key, null terminated, inside the arena
+    } key;
+    int64_t value;
+};
+
+struct _shtable {
+    struct _shtable_slot *slots;
+    uint64_t capacity;          // number of slots, a power of 2
+    uint64_t length;            // number of entries
+    uint64_t threshold;         // shtable grows when length would exceed this
+    char *arena;                // current arena block, starts with pointer to previous block
+    uint64_t arenaused;         // bytes used in current arena block
+    uint64_t arenacap;          // bytes available in current arena block
+    uint64_t arenasize;         // bytes of keys in all arena blocks
+};
+
+/**
+ * @brief The shtable struct
+ *
+ * A hash table from string keys to int64_t values, using open addressing
+ * with Robin Hood hashing like htable. Keys are arrays of bytes with a
+ * length, need not be null terminated and may hold zero bytes. The shtable
+ * keeps its own copy of each key, so the caller's buffer may be reused.
+ *
+ * Each slot stores the full 64 bit hash of its key next to it. A probe
+ * compares hashes first and only compares the bytes of keys whose hash
+ * and length match, so a mismatch almost never costs a memcmp.
+ *
+ * Keys of up to SHTABLE_INLINE bytes are stored inside their slot, so
+ * short names are found without following any pointer. Longer keys are
+ * copied into an append-only arena of SHTABLE_ARENA_BLOCK byte blocks,
+ * which never move, so the slot only holds a pointer to them. The bytes
+ * of removed keys stay in the arena until shtable_clear or shtable_delete.
+ *
+ * // new shtable
+ * shtable st = new_shtable ();
+ *
+ * // functions
+ * bool shtable_set (shtable st, const char *key, uint64_t len, int64_t value);
+ * int64_t shtable_get (shtable st, const char *key, uint64_t len);
+ * bool shtable_has (shtable st, const char *key, uint64_t len);
+ * bool shtable_remove (shtable st, const char *key, uint64_t len);
+ * bool shtable_reserve (shtable st, uint64_t count);
+ * uint64_t shtable_getlen (shtable st);
+ * uint64_t shtable_getarenasize (shtable st);
+ * bool shtable_foreach (shtable st, void (*callback)(const char *key, uint64_t len, int64_t *value));
+ * bool shtable_clear (shtable st);
+ *
+ * // deleting shtable
+ * void shtable_delete (shtable *st);
+ *
+ * // avoid accessing following shtable members
+ * st->slots;       // shtable keys, hashes and values
+ * st->capacity;    // shtable number of slots
+ * st->length;      // shtable number of entries
+ * st->threshold;   // shtable number of entries before growing
+ * st->arena;       // shtable current arena block
+ * st->arenaused;   // shtable bytes used in arena block
+ * st->arenacap;    // shtable bytes available in arena block
+ * st->arenasize;   // shtable bytes of keys in arena
+ */
+typedef struct _shtable *shtable;
+
+/**
+ * @brief Allocates a new shtable in the heap
+ *
+ * Remember to free the shtable using shtable_delete (&st);
+ *
+ * @return shtable
+ */
+shtable new_shtable ();
+
+/**
+ * @brief Sets value of a key, adding a copy of the key if it's not in the shtable
+ * @param st The shtable
+ * @param key The key, need not be null terminated
+ * @param len Length of key, at most UINT32_MAX
+ * @param value The value
+ * @return bool True if successful
+ */
+bool shtable_set (shtable st, const char *key, uint64_t len, int64_t value);
+
+/**
+ * @brief Gets value of a key
+ *
+ * There's no way to be sure that SHTABLE_ERROR value was returned as a
+ * result of error, or if that exact number had actually been stored.
+ * Use shtable_has if that matters.
+ *
+ * @param st The shtable
+ * @param key The key, need not be null terminated
+ * @param len Length of key
+ * @return int64_t Returns SHTABLE_ERROR if key isn't found
+ */
+int64_t shtable_get (shtable st, const char *key, uint64_t len);
+
+/**
+ * @brief Checks if a key is in the shtable
+ * @param st The shtable
+ * @param key The key, need not be null terminated
+ * @param len Length of key
+ * @return bool
+ */
+bool shtable_has (shtable st, const char *key, uint64_t len);
+
+/**
+ * @brief Removes a key and its value
+ *
+ * A key longer than SHTABLE_INLINE stays in the arena.
+ *
+ * @param st The shtable
+ * @param key The key, need not be null terminated
+ * @param len Length of key
+ * @return bool False if key isn't found
+ */
+bool shtable_remove (shtable st, const char *key, uint64_t len);
+
+/**
+ * @brief Grows the shtable so that count entries fit without growing again
+ *
+ * Never shrinks the shtable.
+ *
+ * @param st The shtable
+ * @param count Number of entries
+ * @return bool True if successful
+ */
+bool shtable_reserve (shtable st, uint64_t count);
+
+/**
+ * @brief Gets number of entries
+ * @param st The shtable
+ * @return uint64_t
+ */
+uint64_t shtable_getlen (shtable st);
+
+/**
+ * @brief Gets number of bytes of keys copied into the arena, removed keys included
+ * @param st The shtable
+ * @return uint64_t
+ */
+uint64_t shtable_getarenasize (shtable st);
+
+/**
+ * @brief Loop through all entries and take action using a callback function
+ *
+ * Entries are visited in no particular order. The callback must not add
+ * or remove keys. Keys passed to it are null terminated.
+ *
+ * @param st The shtable
+ * @param callback Function pointer to a function. The arguments of the function is a key, its length and a pointer to its value.
+ * @return bool
+ */
+bool shtable_foreach (shtable st, void (*callback)(const char *key, uint64_t len, int64_t *value));
+
+/**
+ * @brief Removes all entries and frees the arena, keeping the slots allocated
+ * @param st The shtable
+ * @return bool
+ */
+bool shtable_clear (shtable st);
+
+/**
+ * @brief Deletes an shtable
+ *
+ * This function is basically a wrapper around free().
+ * Also sets shtable pointer to NULL.
+ *
+ * This function is recommended over free as the programmer
+ * might forget to set shtable pointer to NULL. As a result,
+ * another shtable operation will cause some undefined behaviour.
+ * Additionally, this function is more convenient.
+ *
+ * @param shtable* Reference to the shtable, is set to NULL.
+ */
+void shtable_delete (shtable *st);
+
+# endif
@@ -0,0 +1,44 @@
+# include <stdio.h>
+# include "skiplist.h"
+
+void callback (int64_t i, int64_t e)
+{
+    printf ("i = %ld: %ld\n", i, e);
+}
+
+int main ()
+{
+    skiplist sl = new_skiplist (false);
+
+    skiplist_append (sl, 45);
+    skiplist_append (sl, 25);
+    skiplist_append (sl, 19);
+    skiplist_insert (sl, 1, 38);
+    skiplist_insert (sl, 0, 90);
+
+    printf ("Positional: ");
+    skiplist_print (sl);
+    printf ("Value at i2 = %ld\n", skiplist_get (sl, 2));
+    printf ("Removed i3 = %ld\n", skiplist_remove (sl, 3));
+
+    skiplist set = new_skiplist (true);
+
+    skiplist_add (set, 45);
+    skiplist_add (set, 25);
+    skiplist_add (set, 19);
+    skiplist_add (set, 38);
+    skiplist_add (set, 90);
+    skiplist_add (set, 13);
+
+    printf ("Ordered: ");
+    skiplist_print (set);
+    printf ("Index of 38 = %lu\n", skiplist_find (set, 38));
+    printf ("Lower bound of 30 = %lu\n", skiplist_lower_bound (set, 30));
+
+    printf ("Values in [20, 50):\n");
+    skiplist_range (set, 20, 50, callback);
+
+    skiplist_delete (&sl);
+    skiplist_delete (&set);
+    return 0;
+}
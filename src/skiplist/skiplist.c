@@ -0,0 +1,547 @@
+# include <stdio.h>
+# include "skiplist.h"
+
+static _skiplist_node skiplist_mknode (uint32_t level, int64_t element);
+static uint32_t skiplist_randlevel (skiplist sl);
+static void skiplist_seekindex (skiplist sl, uint64_t index, _skiplist_node *update, uint64_t *rank);
+static bool skiplist_seekvalue (skiplist sl, int64_t element, _skiplist_node *update, uint64_t *rank);
+static bool skiplist_link (skiplist sl, _skiplist_node *update, uint64_t *rank, int64_t element);
+static int64_t skiplist_unlink (skiplist sl, _skiplist_node *update);
+static _skiplist_node skiplist_getnode (skiplist sl, uint64_t index);
+
+/**
+ * @brief Allocates a node with level links
+ *
+ * @param uint32_t level Number of links
+ * @param int64_t element Value of the node
+ * @return _skiplist_node -- The node, NULL if fails
+ */
+static _skiplist_node skiplist_mknode (uint32_t level, int64_t element)
+{
+    _skiplist_node node = malloc (sizeof (struct _skiplist_node) + level * sizeof (struct _skiplist_link));
+    if (node == NULL)
+        return NULL;
+    node->element = element;
+    node->level = level;
+    for (uint32_t i = 0; i < level; i++) {
+        node->link[i].next = NULL;
+        node->link[i].span = 0;
+    }
+    return node;
+}
+
+/**
+ * @brief Random level for a new node, each level is 4 times rarer than the last
+ *
+ * Uses xorshift64 so that the skiplist keeps no global state.
+ *
+ * @param skiplist The skiplist
+ * @return uint32_t -- Level between 1 and SKIPLIST_MAXLEVEL
+ */
+static uint32_t skiplist_randlevel (skiplist sl)
+{
+    uint64_t x = sl->seed;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    sl->seed = x;
+    uint32_t level = 1;
+    while ((x & 3) == 0 && level < SKIPLIST_MAXLEVEL) {
+        level++;
+        x >>= 2;
+    }
+    return level;
+}
+
+/**
+ * @brief Finds the last node before index on each level
+ *
+ * @param skiplist The skiplist
+ * @param uint64_t index Index being seeked, 0 to sl->length
+ * @param _skiplist_node* update Is filled with the last node before index on each level
+ * @param uint64_t* rank Is filled with the rank of each node in update, header has rank 0
+ */
+static void skiplist_seekindex (skiplist sl, uint64_t index, _skiplist_node *update, uint64_t *rank)
+{
+    _skiplist_node node = sl->head;
+    uint64_t traversed = 0;
+    for (int64_t i = sl->level - 1; i >= 0; i--) {
+        while (node->link[i].next != NULL && traversed + node->link[i].span <= index) {
+            traversed += node->link[i].span;
+            node = node->link[i].next;
+        }
+        update[i] = node;
+        rank[i] = traversed;
+    }
+}
+
+/**
+ * @brief Finds the last node with a value less than element on each level
+ *
+ * @param skiplist The skiplist
+ * @param int64_t element Value being seeked
+ * @param _skiplist_node* update Is filled with the last node before element on each level
+ * @param uint64_t* rank Is filled with the rank of each node in update, header has rank 0
+ * @return bool -- true if element is present
+ */
+static bool skiplist_seekvalue (skiplist sl, int64_t element, _skiplist_node *update, uint64_t *rank)
+{
+    _skiplist_node node = sl->head;
+    uint64_t traversed = 0;
+    for (int64_t i = sl->level - 1; i >= 0; i--) {
+        while (node->link[i].next != NULL && node->link[i].next->element < element) {
+            traversed += node->link[i].span;
+            node = node->link[i].next;
+        }
+        update[i] = node;
+        rank[i] = traversed;
+    }
+    _skiplist_node next = node->link[0].next;
+    return next != NULL && next->element == element;
+}
+
+/**
+ * @brief Links a new node after the nodes found by a seek
+ *
+ * @param skiplist The skiplist
+ * @param _skiplist_node* update Last node before the new node on each level
+ * @param uint64_t* rank Rank of each node in update
+ * @param int64_t element Value of the new node
+ * @return bool -- false if allocation fails
+ */
+static bool skiplist_link (skiplist sl, _skiplist_node *update, uint64_t *rank, int64_t element)
+{
+    uint32_t level = skiplist_randlevel (sl);
+    _skiplist_node newnode = skiplist_mknode (level, element);
+    if (newnode == NULL)
+        return false;
+    if (level > sl->level) {
+        for (uint32_t i = sl->level; i < level; i++) {
+            update[i] = sl->head;
+            rank[i] = 0;
+            sl->head->link[i].span = sl->length;
+        }
+        sl->level = level;
+    }
+    for (uint32_t i = 0; i < level; i++) {
+        newnode->link[i].next = update[i]->link[i].next;
+        update[i]->link[i].next = newnode;
+        // update[0] is the node right before newnode
+        newnode->link[i].span = update[i]->link[i].span - (rank[0] - rank[i]);
+        update[i]->link[i].span = rank[0] - rank[i] + 1;
+    }
+    for (uint32_t i = level; i < sl->level; i++)
+        update[i]->link[i].span++;
+    sl->length++;
+    return true;
+}
+
+/**
+ * @brief Unlinks and frees the node right after the nodes found by a seek
+ *
+ * @param skiplist The skiplist
+ * @param _skiplist_node* update Last node before the node to unlink on each level
+ * @return int64_t -- Value of the unlinked node
+ */
+static int64_t skiplist_unlink (skiplist sl, _skiplist_node *update)
+{
+    _skiplist_node node = update[0]->link[0].next;
+    for (uint32_t i = 0; i < sl->level; i++) {
+        if (update[i]->link[i].next == node) {
+            update[i]->link[i].span += node->link[i].span - 1;
+            update[i]->link[i].next = node->link[i].next;
+        } else {
+            update[i]->link[i].span--;
+        }
+    }
+    while (sl->level > 1 && sl->head->link[sl->level - 1].next == NULL)
+        sl->level--;
+    sl->length--;
+    int64_t return_val = node->element;
+    free (node);
+    return return_val;
+}
+
+/**
+ * @brief Gets node at an index of skiplist
+ *
+ * @param skiplist The skiplist
+ * @param uint64_t index The index of the node, must be less than sl->length
+ * @return _skiplist_node -- The node
+ */
+static _skiplist_node skiplist_getnode (skiplist sl, uint64_t index)
+{
+    _skiplist_node node = sl->head;
+    uint64_t traversed = 0;
+    // header has rank 0, so node at index has rank index + 1
+    for (int64_t i = sl->level - 1; i >= 0; i--) {
+        while (node->link[i].next != NULL && traversed + node->link[i].span <= index + 1) {
+            traversed += node->link[i].span;
+            node = node->link[i].next;
+        }
+        if (traversed == index + 1)
+            break;
+    }
+    return node;
+}
+
+/**
+ * @brief Allocates a new skiplist in the heap
+ *
+ * Remember to free the skiplist using skiplist_delete (&sl);
+ *
+ * @param bool ordered If true, elements are kept sorted and unique
+ * @return skiplist The skiplist
+ */
+skiplist new_skiplist (bool ordered)
+{
+    skiplist sl = malloc (1 * sizeof (struct _skiplist));
+    if (sl == NULL)
+        return NULL;
+    sl->head = skiplist_mknode (SKIPLIST_MAXLEVEL, 0);
+    if (sl->head == NULL) {
+        free (sl);
+        return NULL;
+    }
+    sl->length = 0;
+    sl->level = 1;
+    sl->ordered = ordered;
+    sl->seed = 0x9e3779b97f4a7c15ul ^ (uint64_t) (uintptr_t) sl;
+    return sl;
+}
+
+/**
+ * @brief Get length of the skiplist
+ *
+ * If skiplist is NULL, returns 0
+ *
+ * @param sl The skiplist
+ * @return uint64_t The length
+ */
+uint64_t skiplist_getlen (skiplist sl)
+{
+    if (sl != NULL)
+        return sl->length;
+    return 0;
+}
+
+/**
+ * @brief Appends a value to the skiplist and returns true.
+ *
+ * Fails on an ordered skiplist, use skiplist_add instead.
+ *
+ * @param skiplist The skiplist
+ * @param int64_t Value to append
+ * @return bool -- true if successful
+ */
+bool skiplist_append (skiplist sl, int64_t element)
+{
+    if (sl == NULL)
+        return false;
+    return skiplist_insert (sl, sl->length, element);
+}
+
+/**
+ * @brief Pops the last value from skiplist and returns it.
+ *
+ * If pop fails, SKIPLIST_UNDERFLOW value is returned.
+ *
+ * There's no way to be sure that SKIPLIST_UNDERFLOW value was returned as a
+ * result of error, or if that exact number had actually been popped from
+ * the skiplist.
+ *
+ * Thus, you should know: SKIPLIST_UNDERFLOW = 0x0123456789abcdeful
+ *
+ * @param skiplist The skiplist
+ * @return int64_t -- Popped value, if failed, SKIPLIST_UNDERFLOW is returned
+ */
+int64_t skiplist_pop (skiplist sl)
+{
+    if (skiplist_isempty (sl))
+        return SKIPLIST_UNDERFLOW;
+    return skiplist_remove (sl, sl->length - 1);
+}
+
+/**
+ * @brief Peeks to the last value in skiplist and returns it
+ *
+ * There's no way to be sure that SKIPLIST_UNDERFLOW value was returned as a
+ * result of error, or if that exact number had actually been peeked to
+ * from the skiplist.
+ *
+ * Thus, you should know: SKIPLIST_UNDERFLOW = 0x0123456789abcdeful
+ *
+ * @param skiplist The skiplist
+ * @return int64_t -- Peeked value, if failed, SKIPLIST_UNDERFLOW is returned
+ */
+int64_t skiplist_peek (skiplist sl)
+{
+    if (skiplist_isempty (sl))
+        return SKIPLIST_UNDERFLOW;
+    return skiplist_getnode (sl, sl->length - 1)->element;
+}
+
+/**
+ * @brief Inserts a value to the skiplist index and returns true, O(log n).
+ *
+ * Fails on an ordered skiplist, use skiplist_add instead.
+ *
+ * @param skiplist The skiplist
+ * @param uint64_t Index to where value is to be inserted
+ * @param int64_t Value to insert
+ * @return bool -- true if successful
+ */
+bool skiplist_insert (skiplist sl, uint64_t index, int64_t element)
+{
+    if (sl == NULL || sl->ordered)
+        return false;
+    if (index > sl->length)
+        return false;
+    _skiplist_node update[SKIPLIST_MAXLEVEL];
+    uint64_t rank[SKIPLIST_MAXLEVEL];
+    skiplist_seekindex (sl, index, update, rank);
+    return skiplist_link (sl, update, rank, element);
+}
+
+/**
+ * @brief Removes a value from skiplist index and returns it, O(log n).
+ *
+ * If skiplist_isempty (), returns SKIPLIST_UNDERFLOW = 0x0123456789abcdeful
+ * if index >= sl->length, returns SKIPLIST_OUTOFBOUNDS = 0xfedcba9876543210ul
+ *
+ * There's no way to be sure if any those error values were returned as a
+ * result of error, or if that exact number had actually been removed from
+ * the skiplist.
+ *
+ * @param skiplist The skiplist
+ * @param uint64_t Index from where element is to be removed
+ * @return int64_t -- Removed value, if failed, an error value is returned
+ */
+int64_t skiplist_remove (skiplist sl, uint64_t index)
+{
+    if (skiplist_isempty (sl))
+        return SKIPLIST_UNDERFLOW;
+    if (index >= sl->length)
+        return SKIPLIST_OUTOFBOUNDS;
+    _skiplist_node update[SKIPLIST_MAXLEVEL];
+    uint64_t rank[SKIPLIST_MAXLEVEL];
+    skiplist_seekindex (sl, index, update, rank);
+    return skiplist_unlink (sl, update);
+}
+
+/**
+ * @brief Gets value from an index of skiplist, O(log n)
+ *
+ * If skiplist_isempty (), returns SKIPLIST_UNDERFLOW = 0x0123456789abcdeful
+ * if index >= sl->length, returns SKIPLIST_OUTOFBOUNDS = 0xfedcba9876543210ul
+ *
+ * There's no way to be sure if any those error values were returned as a
+ * result of error, or if that exact number had actually been present in
+ * the skiplist.
+ *
+ * @param skiplist The skiplist
+ * @param uint64_t index The index from where value is to be returned
+ * @return int64_t -- The value
+ */
+int64_t skiplist_get (skiplist sl, uint64_t index)
+{
+    if (skiplist_isempty (sl))
+        return SKIPLIST_UNDERFLOW;
+    if (index >= sl->length)
+        return SKIPLIST_OUTOFBOUNDS;
+    return skiplist_getnode (sl, index)->element;
+}
+
+/**
+ * @brief Sets value to an index of skiplist, O(log n)
+ *
+ * Fails on an ordered skiplist.
+ *
+ * @param skiplist The skiplist
+ * @param uint64_t index The index to where value is to be set
+ * @param int64_t value The value to be set at the index
+ * @return bool -- false if fails
+ */
+bool skiplist_set (skiplist sl, uint64_t index, int64_t value)
+{
+    if (skiplist_isempty (sl) || sl->ordered)
+        return false;
+    if (index >= sl->length)
+        return false;
+    skiplist_getnode (sl, index)->element = value;
+    return true;
+}
+
+/**
+ * @brief Adds a value to an ordered skiplist, O(log n)
+ *
+ * @param skiplist The skiplist
+ * @param int64_t Value to add
+ * @return bool -- false if value already exists or skiplist isn't ordered
+ */
+bool skiplist_add (skiplist sl, int64_t element)
+{
+    if (sl == NULL || !sl->ordered)
+        return false;
+    _skiplist_node update[SKIPLIST_MAXLEVEL];
+    uint64_t rank[SKIPLIST_MAXLEVEL];
+    if (skiplist_seekvalue (sl, element, update, rank))
+        return false;
+    return skiplist_link (sl, update, rank, element);
+}
+
+/**
+ * @brief Removes a value from an ordered skiplist, O(log n)
+ *
+ * @param skiplist The skiplist
+ * @param int64_t Value to remove
+ * @return bool -- false if value doesn't exist or skiplist isn't ordered
+ */
+bool skiplist_discard (skiplist sl, int64_t element)
+{
+    if (skiplist_isempty (sl) || !sl->ordered)
+        return false;
+    _skiplist_node update[SKIPLIST_MAXLEVEL];
+    uint64_t rank[SKIPLIST_MAXLEVEL];
+    if (!skiplist_seekvalue (sl, element, update, rank))
+        return false;
+    skiplist_unlink (sl, update);
+    return true;
+}
+
+/**
+ * @brief Finds index of a value in an ordered skiplist, O(log n)
+ *
+ * @param skiplist The skiplist
+ * @param int64_t Value to find
+ * @return uint64_t -- Index of value, SKIPLIST_NOTFOUND if not present
+ */
+uint64_t skiplist_find (skiplist sl, int64_t element)
+{
+    if (skiplist_isempty (sl) || !sl->ordered)
+        return SKIPLIST_NOTFOUND;
+    _skiplist_node update[SKIPLIST_MAXLEVEL];
+    uint64_t rank[SKIPLIST_MAXLEVEL];
+    if (!skiplist_seekvalue (sl, element, update, rank))
+        return SKIPLIST_NOTFOUND;
+    return rank[0];
+}
+
+/**
+ * @brief Finds index of first value not less than element in an ordered skiplist, O(log n)
+ *
+ * @param skiplist The skiplist
+ * @param int64_t Value to compare with
+ * @return uint64_t -- The index, sl->length if all values are less, SKIPLIST_NOTFOUND if skiplist isn't ordered
+ */
+uint64_t skiplist_lower_bound (skiplist sl, int64_t element)
+{
+    if (sl == NULL || !sl->ordered)
+        return SKIPLIST_NOTFOUND;
+    _skiplist_node update[SKIPLIST_MAXLEVEL];
+    uint64_t rank[SKIPLIST_MAXLEVEL];
+    skiplist_seekvalue (sl, element, update, rank);
+    return rank[0];
+}
+
+/**
+ * @brief Loop through values in [from, to) of an ordered skiplist
+ *
+ * Finding from is O(log n), each following value is O(1).
+ *
+ * @param skiplist The skiplist
+ * @param int64_t from Smallest value to visit
+ * @param int64_t to Value at which to stop, is not visited
+ * @param callback Function pointer to a function. The arguments of the function is an index and the element.
+ * @return bool -- false if failed
+ */
+bool skiplist_range (skiplist sl, int64_t from, int64_t to, void (*callback)(int64_t index, int64_t element))
+{
+    if (skiplist_isempty (sl) || !sl->ordered)
+        return false;
+    _skiplist_node update[SKIPLIST_MAXLEVEL];
+    uint64_t rank[SKIPLIST_MAXLEVEL];
+    skiplist_seekvalue (sl, from, update, rank);
+    uint64_t i = rank[0];
+    for (_skiplist_node node = update[0]->link[0].next; node != NULL && node->element < to; node = node->link[0].next)
+        callback (i++, node->element);
+    return true;
+}
+
+/**
+ * @brief Loop through skiplist and take action using a callback function
+ *
+ * Modifying elements of an ordered skiplist may break its order.
+ *
+ * @param skiplist The skiplist
+ * @param callback Function pointer to a function. The arguments of the function is an index and a pointer to the element.
+ * @return bool -- false if failed
+ */
+bool skiplist_foreach (skiplist sl, void (*callback)(int64_t index, int64_t *element))
+{
+    if (skiplist_isempty (sl))
+        return false;
+    _skiplist_node next_node = sl->head->link[0].next;
+    for (uint64_t i = 0; next_node != NULL; i++) {
+        callback (i, &(next_node->element));
+        next_node = next_node->link[0].next;
+    }
+    return true;
+}
+
+/**
+ * @brief Prints skiplist content
+ *
+ * @param skiplist The skiplist
+ * @return bool -- false if print failed
+ */
+bool skiplist_print (skiplist sl)
+{
+    if (skiplist_isempty (sl))
+        return false;
+    _skiplist_node next_node = sl->head->link[0].next;
+    while (next_node != NULL) {
+        printf ("%" PRId64 " ", next_node->element);
+        next_node = next_node->link[0].next;
+    }
+    printf ("\n");
+    return true;
+}
+
+/**
+ * @brief True if empty
+ *
+ * @param skiplist The skiplist
+ * @return bool -- True if empty
+ */
+bool skiplist_isempty (skiplist sl)
+{
+    return sl == NULL || sl->length == 0;
+}
+
+/**
+ * @brief Deletes a skiplist
+ *
+ * This function is basically a wrapper around free().
+ * Also sets skiplist pointer to NULL.
+ *
+ * This function is recommended over free as the programmer
+ * might forget to set skiplist pointer to NULL. As a result,
+ * another skiplist operation will cause some undefined behaviour.
+ *
+ * @param skiplist* Reference to the skiplist, is set to NULL.
+ */
+void skiplist_delete (skiplist *sl)
+{
+    if (sl == NULL || *sl == NULL)
+        return;
+    _skiplist_node next_node = (*sl)->head;
+    _skiplist_node bkp_node;
+    while (next_node != NULL) {
+        bkp_node = next_node->link[0].next;
+        free (next_node);
+        next_node = bkp_node;
+    }
+    free (*sl);
+    *sl = NULL;
+}
@@ -0,0 +1,284 @@
+# ifndef SKIPLIST_H
+# define SKIPLIST_H 1
+
+# include <stdlib.h>
+# include <inttypes.h>
+# include <stdint.h>
+# include <stdbool.h>
+
+# define SKIPLIST_UNDERFLOW 0x0123456789abcdeful
+# define SKIPLIST_OUTOFBOUNDS 0xfedcba9876543210ul
+# define SKIPLIST_NOTFOUND 0xfffffffffffffffful
+# define SKIPLIST_MAXLEVEL 32
+
+typedef struct _skiplist_node {
+    int64_t element;
+    uint32_t level;                     // number of links of this node
+    struct _skiplist_link {
+        struct _skiplist_node *next;
+        uint64_t span;                  // number of positions moved by following next
+    } link[];
+} *_skiplist_node;
+
+struct _skiplist {
+    _skiplist_node head;    // header node, has SKIPLIST_MAXLEVEL links and no element
+    uint64_t length;
+    uint32_t level;         // number of levels in use
+    bool ordered;           // true if elements are kept sorted and unique
+    uint64_t seed;          // state of level generator
+};
+
+/**
+ * @brief The skiplist struct
+ *
+ * An indexable skip list. Each link stores how many positions it skips,
+ * so positional operations run in O(log n) instead of O(n) for llist.
+ *
+ * In ordered mode, elements are kept sorted and unique, and the list can
+ * be used as an ordered set. Positional get and remove still work on an
+ * ordered skiplist, but append, insert and set fail as they may break the
+ * order.
+ *
+ * // new skiplist
+ * skiplist sl = new_skiplist (false);
+ *
+ * // functions
+ * uint64_t skiplist_getlen (skiplist sl);
+ * bool skiplist_append (skiplist sl, int64_t element);
+ * int64_t skiplist_pop (skiplist sl);
+ * int64_t skiplist_peek (skiplist sl);
+ * bool skiplist_insert (skiplist sl, uint64_t index, int64_t element);
+ * int64_t skiplist_remove (skiplist sl, uint64_t index);
+ * int64_t skiplist_get (skiplist sl, uint64_t index);
+ * bool skiplist_set (skiplist sl, uint64_t index, int64_t value);
+ * bool skiplist_foreach (skiplist sl, void (*callback)(int64_t index, int64_t *element));
+ * bool skiplist_print (skiplist sl);
+ * bool skiplist_isempty (skiplist sl);
+ *
+ * // ordered mode functions
+ * bool skiplist_add (skiplist sl, int64_t element);
+ * bool skiplist_discard (skiplist sl, int64_t element);
+ * uint64_t skiplist_find (skiplist sl, int64_t element);
+ * uint64_t skiplist_lower_bound (skiplist sl, int64_t element);
+ * bool skiplist_range (skiplist sl, int64_t from, int64_t to, void (*callback)(int64_t index, int64_t element));
+ *
+ * // deleting skiplist
+ * void skiplist_delete (skiplist *sl);
+ *
+ * // avoid accessing following skiplist members
+ * sl->head;        // skiplist header node
+ * sl->length;      // skiplist length
+ * sl->level;       // skiplist levels in use
+ * sl->ordered;     // skiplist mode
+ * sl->seed;        // skiplist level generator state
+ */
+typedef struct _skiplist *skiplist;
+
+/**
+ * @brief Allocates a new skiplist in the heap
+ *
+ * Remember to free the skiplist using skiplist_delete (&sl);
+ *
+ * @param bool ordered If true, elements are kept sorted and unique
+ * @return skiplist The skiplist
+ */
+skiplist new_skiplist (bool ordered);
+
+/**
+ * @brief Get length of the skiplist
+ *
+ * If skiplist is NULL, returns 0
+ *
+ * @param sl The skiplist
+ * @return uint64_t The length
+ */
+uint64_t skiplist_getlen (skiplist sl);
+
+/**
+ * @brief Appends a value to the skiplist and returns true.
+ *
+ * Fails on an ordered skiplist, use skiplist_add instead.
+ *
+ * @param skiplist The skiplist
+ * @param int64_t Value to append
+ * @return bool -- true if successful
+ */
+bool skiplist_append (skiplist sl, int64_t element);
+
+/**
+ * @brief Pops the last value from skiplist and returns it.
+ *
+ * If pop fails, SKIPLIST_UNDERFLOW value is returned.
+ *
+ * There's no way to be sure that SKIPLIST_UNDERFLOW value was returned as a
+ * result of error, or if that exact number had actually been popped from
+ * the skiplist.
+ *
+ * Thus, you should know: SKIPLIST_UNDERFLOW = 0x0123456789abcdeful
+ *
+ * @param skiplist The skiplist
+ * @return int64_t -- Popped value, if failed, SKIPLIST_UNDERFLOW is returned
+ */
+int64_t skiplist_pop (skiplist sl);
+
+/**
+ * @brief Peeks to the last value in skiplist and returns it
+ *
+ * There's no way to be sure that SKIPLIST_UNDERFLOW value was returned as a
+ * result of error, or if that exact number had actually been peeked to
+ * from the skiplist.
+ *
+ * Thus, you should know: SKIPLIST_UNDERFLOW = 0x0123456789abcdeful
+ *
+ * @param skiplist The skiplist
+ * @return int64_t -- Peeked value, if failed, SKIPLIST_UNDERFLOW is returned
+ */
+int64_t skiplist_peek (skiplist sl);
+
+/**
+ * @brief Inserts a value to the skiplist index and returns true, O(log n).
+ *
+ * Fails on an ordered skiplist, use skiplist_add instead.
+ *
+ * @param skiplist The skiplist
+ * @param uint64_t Index to where value is to be inserted
+ * @param int64_t Value to insert
+ * @return bool -- true if successful
+ */
+bool skiplist_insert (skiplist sl, uint64_t index, int64_t element);
+
+/**
+ * @brief Removes a value from skiplist index and returns it, O(log n).
+ *
+ * If skiplist_isempty (), returns SKIPLIST_UNDERFLOW = 0x0123456789abcdeful
+ * if index >= sl->length, returns SKIPLIST_OUTOFBOUNDS = 0xfedcba9876543210ul
+ *
+ * There's no way to be sure if any those error values were returned as a
+ * result of error, or if that exact number had actually been removed from
+ * the skiplist.
+ *
+ * @param skiplist The skiplist
+ * @param uint64_t Index from where element is to be removed
+ * @return int64_t -- Removed value, if failed, an error value is returned
+ */
+int64_t skiplist_remove (skiplist sl, uint64_t index);
+
+/**
+ * @brief Gets value from an index of skiplist, O(log n)
+ *
+ * If skiplist_isempty (), returns SKIPLIST_UNDERFLOW = 0x0123456789abcdeful
+ * if index >= sl->length, returns SKIPLIST_OUTOFBOUNDS = 0xfedcba9876543210ul
+ *
+ * There's no way to be sure if any those error values were returned as a
+ * result of error, or if that exact number had actually been present in
+ * the skiplist.
+ *
+ * @param skiplist The skiplist
+ * @param uint64_t index The index from where value is to be returned
+ * @return int64_t -- The value
+ */
+int64_t skiplist_get (skiplist sl, uint64_t index);
+
+/**
+ * @brief Sets value to an index of skiplist, O(log n)
+ *
+ * Fails on an ordered skiplist.
+ *
+ * @param skiplist The skiplist
+ * @param uint64_t index The index to where value is to be set
+ * @param int64_t value The value to be set at the index
+ * @return bool -- false if fails
+ */
+bool skiplist_set (skiplist sl, uint64_t index, int64_t value);
+
+/**
+ * @brief Adds a value to an ordered skiplist, O(log n)
+ *
+ * @param skiplist The skiplist
+ * @param int64_t Value to add
+ * @return bool -- false if value already exists or skiplist isn't ordered
+ */
+bool skiplist_add (skiplist sl, int64_t element);
+
+/**
+ * @brief Removes a value from an ordered skiplist, O(log n)
+ *
+ * @param skiplist The skiplist
+ * @param int64_t Value to remove
+ * @return bool -- false if value doesn't exist or skiplist isn't ordered
+ */
+bool skiplist_discard (skiplist sl, int64_t element);
+
+/**
+ * @brief Finds index of a value in an ordered skiplist, O(log n)
+ *
+ * @param skiplist The skiplist
+ * @param int64_t Value to find
+ * @return uint64_t -- Index of value, SKIPLIST_NOTFOUND if not present
+ */
+uint64_t skiplist_find (skiplist sl, int64_t element);
+
+/**
+ * @brief Finds index of first value not less than element in an ordered skiplist, O(log n)
+ *
+ * @param skiplist The skiplist
+ * @param int64_t Value to compare with
+ * @return uint64_t -- The index, sl->length if all values are less, SKIPLIST_NOTFOUND if skiplist isn't ordered
+ */
+uint64_t skiplist_lower_bound (skiplist sl, int64_t element);
+
+/**
+ * @brief Loop through values in [from, to) of an ordered skiplist
+ *
+ * Finding from is O(log n), each following value is O(1).
+ *
+ * @param skiplist The skiplist
+ * @param int64_t from Smallest value to visit
+ * @param int64_t to Value at which to stop, is not visited
+ * @param callback Function pointer to a function. The arguments of the function is an index and the element.
+ * @return bool -- false if failed
+ */
+bool skiplist_range (skiplist sl, int64_t from, int64_t to, void (*callback)(int64_t index, int64_t element));
+
+/**
+ * @brief Loop through skiplist and take action using a callback function
+ *
+ * Modifying elements of an ordered skiplist may break its order.
+ *
+ * @param skiplist The skiplist
+ * @param callback Function pointer to a function. The arguments of the function is an index and a pointer to the element.
+ * @return bool -- false if failed
+ */
+bool skiplist_foreach (skiplist sl, void (*callback)(int64_t index, int64_t *element));
+
+/**
+ * @brief Prints skiplist content
+ *
+ * @param skiplist The skiplist
+ * @return bool -- false if print failed
+ */
+bool skiplist_print (skiplist sl);
+
+/**
+ * @brief True if empty
+ *
+ * @param skiplist The skiplist
+ * @return bool -- True if empty
+ */
+bool skiplist_isempty (skiplist sl);
+
+/**
+ * @brief Deletes a skiplist
+ *
+ * This function is basically a wrapper around free().
+ * Also sets skiplist pointer to NULL.
+ *
+ * This function is recommended over free as the programmer
+ * might forget to set skiplist pointer to NULL. As a result,
+ * another skiplist operation will cause some undefined behaviour.
+ *
+ * @param skiplist* Reference to the skiplist, is set to NULL.
+ */
+void skiplist_delete (skiplist *sl);
+
+# endif
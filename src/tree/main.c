@@ -1,35 +1,93 @@
 # include <stdio.h>
+# include <fcntl.h>
+# include <unistd.h>
 # include "tree.h"
 
-typedef char charr[1025];
+// prints name and value of a node
+bool print_match (tree node, void *ctx)
+{
+    printf ("match %s = %ld\n", tree_getname (node), node->value);
+    return true;
+}
+
+// prints a node indented by its depth
+bool print_node (tree node, uint64_t depth, void *ctx)
+{
+    printf ("%*s%s = %ld\n", (int) (2 * depth), "", tree_getname (node), node->value);
+    return true;
+}
 
 int main ()
 {
     tree tr = new_tree();
     tree tr2 = new_tree();
 
-    charr n1_n2_n3 = "/node1/node2/node3";
-    charr n1_n2_n4 = "/node1/node2/node4";
-    charr n1_n2 = "/node1/node2";
-    charr n1 = "/node2-";
+    // repeated lookups of the same paths from the root cost one hash probe
+    tree_setcache (tr, 1024);
 
-    // auto creates a named node
-    tree_setdata (tr, n1_n2_n3, 45);
-    tree_setdata (tr, n1_n2_n4, 25);
-    tree_setdata (tr, n1_n2, 19);
+    const char *n1_n2_n3 = "/node1/node2/node3";
+    const char *n1_n2_n4 = "/node1/node2/node4";
+    const char *n1_n2 = "/node1/node2";
+    const char *n1 = "/node1";
 
-    // will replace the subtree at node1 with tr2
-    tree_setnode (tr, n1, tr2);
+    // auto creates a named node
+    tree_setdata (tr, n1_n2_n3, strlen (n1_n2_n3), 45);
+    tree_setdata (tr, n1_n2_n4, strlen (n1_n2_n4), 25);
+    tree_setdata (tr, n1_n2, strlen (n1_n2), 19);
+    tree_setdata (tr2, "/a/b", 4, 64);
 
     // returns data
-    int64_t value = tree_getdata (tr, n1_n2);
+    int64_t value = tree_getdata (tr, n1_n2, strlen (n1_n2));
+    printf ("%s = %ld\n", n1_n2, value);
 
     // returns a subtree
-    tree subtree = tree_getnode (tr, n1_n2);
-    subtree->value = value;
+    tree subtree = tree_getnode (tr, n1_n2, strlen (n1_n2));
+    printf ("%s has %lu children\n", tree_getname (subtree), subtree->childcount);
+
+    // deletes the node n1_n2
+    tree_rmnode (tr, n1_n2, strlen (n1_n2));
+
+    // will replace the subtree at node1 with a copy of tr2
+    tree_setnode (tr, n1, strlen (n1), tr2);
+    printf ("/node1/a/b = %ld\n", tree_getdata (tr, "/node1/a/b", 10));
+
+    // walks the tree depth first without recursion
+    tree_walk (tr, TREE_DFS, print_node, NULL, NULL);
+
+    // sets many paths, walking their common parent once
+    const char *metrics[] = { "/svc/a/metrics/cpu", "/svc/a/metrics/mem", "/svc/a/metrics/disk" };
+    uint64_t lens[] = { 18, 18, 19 };
+    int64_t vals[] = { 90, 70, 40 };
+    bool ok[3];
+    tree_setdata_batch (tr, metrics, lens, vals, 3, ok);
+    int64_t got[3];
+    tree_getdata_batch (tr, metrics, lens, 3, got, ok);
+    printf ("%s = %ld\n", metrics[2], got[2]);
+
+    // every node under any service named metrics/...
+    const char *pattern = "/svc/*/metrics/**";
+    tree_query (tr, pattern, strlen (pattern), print_match, NULL);
+
+    // keeps sum, count, min and max of every subtree up to date
+    tree_setaggregate (tr, true);
+    tree_setdata (tr, "/node1/c", 8, 10);
+    struct _tree_aggregate agg;
+    tree_aggregate (tr, n1, strlen (n1), &agg);
+    printf ("%s: sum %ld, count %lu, min %ld, max %ld\n", n1, agg.sum, agg.count, agg.min, agg.max);
+
+    // saves an image of the tree, mapping it back is instant
+    int fd = open ("tree.img", O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    tree_save (tr, fd);
+    close (fd);
+    tree mapped = tree_map ("tree.img");
+    printf ("mapped /node1/a/b = %ld\n", tree_getdata (mapped, "/node1/a/b", 10));
+    tree_delete (&mapped);
+    remove ("tree.img");
 
-    // deletes the node b
-    tree_rmnode (tr, n1_n2);
+    // nodes of an arena tree are all freed at once
+    tree tr3 = new_tree_arena();
+    tree_setdata (tr3, "/x/y/z", 6, 7);
+    tree_delete (&tr3);
 
     tree_delete (&tr);
     tree_delete (&tr2);
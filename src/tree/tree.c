@@ -1,7 +1,940 @@
+# include <fcntl.h>
+# include <unistd.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
 # include "tree.h"
 
-tree tree_glvnip (tree node, const string path, uint64_t *index);
-tree tree_mknode (tree tr, const string path);
+tree tree_glvnip (tree node, const char *path, uint64_t len, uint64_t *pos);
+tree tree_mknode (tree tr, const char *path, uint64_t len);
+
+static uint64_t tree_hash (const char *name, uint64_t len);
+static bool tree_nextseg (const char *path, uint64_t len, uint64_t *pos, const char **seg, uint64_t *seglen);
+static struct _tree_meta *tree_newmeta (bool arenanodes);
+static void tree_freemeta (struct _tree_meta *meta);
+static void *tree_arenaalloc (struct _tree_meta *meta, uint64_t size, uint64_t align);
+static void *tree_alloc (struct _tree_meta *meta, uint64_t size);
+static void *tree_calloc (struct _tree_meta *meta, uint64_t size);
+static void *tree_realloc (struct _tree_meta *meta, void *ptr, uint64_t oldsize, uint64_t size);
+static void tree_free (struct _tree_meta *meta, void *ptr);
+static void tree_freenode (tree node);
+static tree tree_newtree (bool arenanodes);
+static bool tree_writeall (int fd, const void *buf, uint64_t len);
+static bool tree_countnode (tree node, uint64_t depth, void *ctx);
+static int64_t tree_imagegetdata (struct _tree_meta *meta, const char *path, uint64_t len);
+static uint32_t tree_findname (struct _tree_meta *meta, const char *name, uint64_t len, uint32_t hash);
+static uint32_t tree_intern (struct _tree_meta *meta, const char *name, uint64_t len, uint32_t hash);
+static tree tree_newnode (struct _tree_meta *meta, uint32_t nameid, tree parent);
+static struct _tree_aggregate tree_aggsingle (int64_t value);
+static void tree_aggcompute (tree node);
+static void tree_aggchange (tree node, struct _tree_aggregate old, struct _tree_aggregate new);
+static bool tree_aggnode (tree node, uint64_t depth, void *ctx);
+static bool tree_aggadd (tree node, uint64_t depth, void *ctx);
+static void tree_setvalue (tree node, int64_t val);
+static tree tree_segchild (tree node, const char *seg, uint64_t seglen);
+static tree tree_mkchild (tree node, const char *seg, uint64_t seglen);
+static bool tree_samepath (const char *path1, uint64_t len1, const char *path2, uint64_t len2);
+static bool tree_globmatch (const char *glob, uint64_t globlen, const char *name, uint64_t namelen);
+static uint64_t tree_queryclose (const struct _tree_queryseg *segs, uint64_t states);
+static uint64_t tree_querystep (const struct _tree_queryseg *segs, uint64_t count, uint64_t states, tree child);
+static bool tree_batch (tree tr, const char **paths, const uint64_t *lens, uint64_t count,
+    const int64_t *setvals, int64_t *getvals, bool *success);
+static int tree_cmpname (uint32_t hash, uint32_t nameid, tree node);
+static int tree_cmpchild (const void *a, const void *b);
+static tree tree_findchild (tree node, uint32_t nameid, uint32_t hash, uint64_t *index);
+static uint64_t tree_findslot (tree node, uint32_t hash, uint64_t index);
+static bool tree_buildindex (tree node, uint64_t indexcap);
+static void tree_dropindex (tree node);
+static bool tree_addchild (tree node, tree child);
+static void tree_removechild (tree node, uint64_t index);
+static tree tree_copy (tree node, tree parent, struct _tree_meta *meta);
+static void tree_freecache (struct _tree_cache *cache);
+static struct _tree_cacheentry *tree_cachefind (struct _tree_cache *cache, const char *path, uint64_t len, uint64_t hash);
+static void tree_cacheput (struct _tree_meta *meta, const char *path, uint64_t len, uint64_t hash, tree node);
+static void tree_cacheunindex (struct _tree_cache *cache, uint64_t entry);
+
+/**
+ * @brief FNV-1a hash of a node name
+ */
+static uint64_t tree_hash (const char *name, uint64_t len)
+{
+    uint64_t hash = 0xcbf29ce484222325ul;
+    for (uint64_t i = 0; i < len; i++) {
+        hash ^= (unsigned char) name[i];
+        hash *= 0x100000001b3ul;
+    }
+    return hash;
+}
+
+/**
+ * @brief Gets next segment of a path, segments are separated by one or more '/'
+ *
+ * The path isn't modified and no state is kept outside of pos, so this
+ * is safe to use from many threads at once.
+ *
+ * @param path The path, need not be null terminated
+ * @param len Length of path
+ * @param pos Offset from where to look for segment, is set to offset right after it
+ * @param seg Set to start of segment
+ * @param seglen Set to length of segment
+ * @return bool False if there are no more segments
+ */
+static bool tree_nextseg (const char *path, uint64_t len, uint64_t *pos, const char **seg, uint64_t *seglen)
+{
+    uint64_t i = *pos;
+    while (i < len && path[i] == '/')
+        i++;
+    if (i == len) {
+        *pos = len;
+        return false;
+    }
+    uint64_t start = i;
+    while (i < len && path[i] != '/')
+        i++;
+    *seg = path + start;
+    *seglen = i - start;
+    *pos = i;
+    return true;
+}
+
+/**
+ * @brief Allocates the state shared by nodes of a new tree
+ * @return struct _tree_meta* NULL if allocation failed
+ */
+static struct _tree_meta *tree_newmeta (bool arenanodes)
+{
+    struct _tree_meta *meta = malloc (1 * sizeof (struct _tree_meta));
+    if (!meta)
+        return NULL;
+    meta->root = NULL;
+    meta->generation = 0;
+    meta->cache = NULL;
+    meta->arena = NULL;
+    meta->arenaused = 0;
+    meta->arenacap = 0;
+    meta->arenanodes = arenanodes;
+    meta->aggregates = false;
+    meta->names = NULL;
+    meta->namecount = 0;
+    meta->namecap = 0;
+    meta->nameindex = NULL;
+    meta->nameindexcap = 0;
+    meta->image = NULL;
+    meta->imagesize = 0;
+    return meta;
+}
+
+/**
+ * @brief Frees the state shared by nodes of a tree, along with all interned names
+ */
+static void tree_freemeta (struct _tree_meta *meta)
+{
+    char *block = meta->arena;
+    while (block) {
+        char *prev = *(char **) block;
+        free (block);
+        block = prev;
+    }
+    free (meta->names);
+    free (meta->nameindex);
+    tree_freecache (meta->cache);
+    if (meta->image)
+        munmap ((void *) meta->image, meta->imagesize);
+    free (meta);
+}
+
+/**
+ * @brief Allocates from the arena of a tree, memory is freed with the tree only
+ * @param meta State of the tree
+ * @param size Number of bytes
+ * @param align Alignment, a power of 2 not more than that of a pointer
+ * @return void* NULL if allocation failed
+ */
+static void *tree_arenaalloc (struct _tree_meta *meta, uint64_t size, uint64_t align)
+{
+    uint64_t used = (meta->arenaused + align - 1) & ~(align - 1);
+    if (!meta->arena || used + size > meta->arenacap) {
+        // blocks are never moved, so whatever is in them stays where it is
+        uint64_t arenacap = size > TREE_ARENA_BLOCK ? size : TREE_ARENA_BLOCK;
+        char *block = malloc (sizeof (char *) + arenacap);
+        if (!block)
+            return NULL;
+        *(char **) block = meta->arena;
+        meta->arena = block;
+        meta->arenacap = arenacap;
+        used = 0;
+    }
+    meta->arenaused = used + size;
+    return meta->arena + sizeof (char *) + used;
+}
+
+/**
+ * @brief Allocates memory for nodes and child arrays of a tree
+ *
+ * Trees made by new_tree_arena take it from the arena, others from malloc.
+ */
+static void *tree_alloc (struct _tree_meta *meta, uint64_t size)
+{
+    if (meta->arenanodes)
+        return tree_arenaalloc (meta, size, sizeof (void *));
+    return malloc (size);
+}
+
+/**
+ * @brief Same as tree_alloc, but memory is zeroed
+ */
+static void *tree_calloc (struct _tree_meta *meta, uint64_t size)
+{
+    if (meta->arenanodes) {
+        void *ptr = tree_arenaalloc (meta, size, sizeof (void *));
+        if (ptr)
+            memset (ptr, 0, size);
+        return ptr;
+    }
+    return calloc (1, size);
+}
+
+/**
+ * @brief Resizes memory from tree_alloc, old memory of an arena tree is left in the arena
+ */
+static void *tree_realloc (struct _tree_meta *meta, void *ptr, uint64_t oldsize, uint64_t size)
+{
+    if (meta->arenanodes) {
+        void *newptr = tree_arenaalloc (meta, size, sizeof (void *));
+        if (newptr && ptr)
+            memcpy (newptr, ptr, oldsize < size ? oldsize : size);
+        return newptr;
+    }
+    return realloc (ptr, size);
+}
+
+/**
+ * @brief Frees memory from tree_alloc, does nothing for an arena tree
+ */
+static void tree_free (struct _tree_meta *meta, void *ptr)
+{
+    if (!meta->arenanodes)
+        free (ptr);
+}
+
+/**
+ * @brief Frees a node along with its child arrays, but not its children
+ */
+static void tree_freenode (tree node)
+{
+    struct _tree_meta *meta = node->meta;
+    tree_free (meta, node->children);
+    tree_free (meta, node->childindex);
+    tree_free (meta, node);
+}
+
+/**
+ * @brief Finds id of an interned name
+ * @param meta State of the tree
+ * @param name The name, need not be null terminated
+ * @param len Length of name
+ * @param hash Hash of name
+ * @return uint32_t The name id, TREE_NONAME if name isn't interned
+ */
+static uint32_t tree_findname (struct _tree_meta *meta, const char *name, uint64_t len, uint32_t hash)
+{
+    if (!meta->nameindex)
+        return TREE_NONAME;
+    uint64_t mask = meta->nameindexcap - 1;
+    for (uint64_t i = hash & mask; meta->nameindex[i]; i = (i + 1) & mask) {
+        struct _tree_name *entry = &meta->names[meta->nameindex[i] - 1];
+        if (entry->hash == hash && entry->len == len && !memcmp (entry->str, name, len))
+            return meta->nameindex[i] - 1;
+    }
+    return TREE_NONAME;
+}
+
+/**
+ * @brief Interns a name, copying it into the name arena if it's new
+ * @param meta State of the tree
+ * @param name The name, need not be null terminated
+ * @param len Length of name
+ * @param hash Hash of name
+ * @return uint32_t The name id, TREE_NONAME if allocation failed
+ */
+static uint32_t tree_intern (struct _tree_meta *meta, const char *name, uint64_t len, uint32_t hash)
+{
+    uint32_t nameid = tree_findname (meta, name, len, hash);
+    if (nameid != TREE_NONAME)
+        return nameid;
+    if (len >= TREE_NONAME || meta->namecount == TREE_NONAME - 1)
+        return TREE_NONAME;
+    // keep load factor of name index under 1/2
+    if (2 * (meta->namecount + 1) > meta->nameindexcap) {
+        uint64_t indexcap = meta->nameindexcap ? 2 * meta->nameindexcap : 64;
+        uint32_t *nameindex = calloc (indexcap, sizeof (uint32_t));
+        if (!nameindex)
+            return TREE_NONAME;
+        for (uint32_t id = 0; id < meta->namecount; id++) {
+            uint64_t i = meta->names[id].hash & (indexcap - 1);
+            while (nameindex[i])
+                i = (i + 1) & (indexcap - 1);
+            nameindex[i] = id + 1;
+        }
+        free (meta->nameindex);
+        meta->nameindex = nameindex;
+        meta->nameindexcap = indexcap;
+    }
+    if (meta->namecount == meta->namecap) {
+        uint32_t namecap = meta->namecap ? 2 * meta->namecap : 64;
+        if (namecap < meta->namecap)
+            namecap = TREE_NONAME;
+        struct _tree_name *names = realloc (meta->names, namecap * sizeof (struct _tree_name));
+        if (!names)
+            return TREE_NONAME;
+        meta->names = names;
+        meta->namecap = namecap;
+    }
+    char *str = tree_arenaalloc (meta, len + 1, 1);
+    if (!str)
+        return TREE_NONAME;
+    memcpy (str, name, len);
+    str[len] = '\0';
+    nameid = meta->namecount++;
+    meta->names[nameid].str = str;
+    meta->names[nameid].len = len;
+    meta->names[nameid].hash = hash;
+    uint64_t mask = meta->nameindexcap - 1;
+    uint64_t i = hash & mask;
+    while (meta->nameindex[i])
+        i = (i + 1) & mask;
+    meta->nameindex[i] = nameid + 1;
+    return nameid;
+}
+
+/**
+ * @brief Allocates a node without children
+ * @param meta State of the tree the node belongs to
+ * @param nameid Id of name of the node
+ * @param parent Parent of the node
+ * @return tree NULL if allocation failed
+ */
+static tree tree_newnode (struct _tree_meta *meta, uint32_t nameid, tree parent)
+{
+    tree node = tree_alloc (meta, 1 * sizeof (struct _tree_node));
+    if (!node)
+        return NULL;
+    node->nameid = nameid;
+    node->hash = meta->names[nameid].hash;
+    node->value = 0;
+    node->parent = parent;
+    node->meta = meta;
+    node->children = NULL;
+    node->childcount = 0;
+    node->childcap = 0;
+    node->childindex = NULL;
+    node->indexcap = 0;
+    node->agg = tree_aggsingle (0);
+    return node;
+}
+
+/**
+ * @brief Aggregates of a single value
+ */
+static struct _tree_aggregate tree_aggsingle (int64_t value)
+{
+    struct _tree_aggregate agg = { value, 1, value, value };
+    return agg;
+}
+
+/**
+ * @brief Computes aggregates of node from its value and the aggregates of its children
+ */
+static void tree_aggcompute (tree node)
+{
+    struct _tree_aggregate agg = tree_aggsingle (node->value);
+    for (uint64_t i = 0; i < node->childcount; i++) {
+        struct _tree_aggregate *child = &node->children[i]->agg;
+        agg.sum = (int64_t) ((uint64_t) agg.sum + (uint64_t) child->sum);
+        agg.count += child->count;
+        if (child->min < agg.min)
+            agg.min = child->min;
+        if (child->max > agg.max)
+            agg.max = child->max;
+    }
+    node->agg = agg;
+}
+
+/**
+ * @brief Updates aggregates of node and its ancestors after a part of its subtree changed
+ *
+ * The part is either the value of node or the subtree of a child, old and
+ * new are its aggregates before and after. An empty part, as that of a
+ * child being added or removed, has count 0, min INT64_MAX and max INT64_MIN.
+ * Stops at the first ancestor whose aggregates don't change.
+ *
+ * @param node The node whose subtree changed
+ * @param old Aggregates of the changed part before
+ * @param new Aggregates of the changed part after
+ */
+static void tree_aggchange (tree node, struct _tree_aggregate old, struct _tree_aggregate new)
+{
+    while (node) {
+        struct _tree_aggregate before = node->agg;
+        struct _tree_aggregate *agg = &node->agg;
+        agg->sum = (int64_t) ((uint64_t) agg->sum + (uint64_t) new.sum - (uint64_t) old.sum);
+        agg->count += new.count - old.count;
+        bool rescan = false;
+        if (new.min <= agg->min)
+            agg->min = new.min;
+        else if (old.min == agg->min)
+            rescan = true;
+        if (new.max >= agg->max)
+            agg->max = new.max;
+        else if (old.max == agg->max)
+            rescan = true;
+        // the old min or max may have been the only one, look at what's left
+        if (rescan)
+            tree_aggcompute (node);
+        if (!memcmp (&before, agg, sizeof (before)))
+            return;
+        old = before;
+        new = *agg;
+        node = node->parent;
+    }
+}
+
+/**
+ * @brief Sets value of node, keeping aggregates up to date
+ */
+static void tree_setvalue (tree node, int64_t val)
+{
+    int64_t old = node->value;
+    node->value = val;
+    if (node->meta->aggregates && old != val)
+        tree_aggchange (node, tree_aggsingle (old), tree_aggsingle (val));
+}
+
+/**
+ * @brief Compares a name hash and id to those of a node, hash goes first
+ *
+ * This is the order of children of a node in sorted mode.
+ */
+static int tree_cmpname (uint32_t hash, uint32_t nameid, tree node)
+{
+    if (hash != node->hash)
+        return hash < node->hash ? -1 : 1;
+    return (nameid > node->nameid) - (nameid < node->nameid);
+}
+
+/**
+ * @brief qsort comparison function for children
+ */
+static int tree_cmpchild (const void *a, const void *b)
+{
+    tree node = *(tree *) a;
+    return tree_cmpname (node->hash, node->nameid, *(tree *) b);
+}
+
+/**
+ * @brief Finds a child of node by name id
+ *
+ * Uses linear search, binary search or the hash index depending on
+ * the number of children of node. Names are compared by id only.
+ *
+ * @param node The parent node
+ * @param nameid Id of name of the child
+ * @param hash Hash of name
+ * @param index Set to index of child in children array, may be NULL
+ * @return tree The child, NULL if not found
+ */
+static tree tree_findchild (tree node, uint32_t nameid, uint32_t hash, uint64_t *index)
+{
+    if (node->childindex) {
+        uint64_t mask = node->indexcap - 1;
+        for (uint64_t i = hash & mask; node->childindex[i]; i = (i + 1) & mask) {
+            tree child = node->children[node->childindex[i] - 1];
+            if (child->nameid == nameid) {
+                if (index)
+                    *index = node->childindex[i] - 1;
+                return child;
+            }
+        }
+        return NULL;
+    }
+    if (node->childcount <= TREE_LINEAR_MAX) {
+        for (uint64_t i = 0; i < node->childcount; i++) {
+            if (node->children[i]->nameid == nameid) {
+                if (index)
+                    *index = i;
+                return node->children[i];
+            }
+        }
+        return NULL;
+    }
+    uint64_t lo = 0, hi = node->childcount;
+    while (lo < hi) {
+        uint64_t mid = lo + (hi - lo) / 2;
+        int cmp = tree_cmpname (hash, nameid, node->children[mid]);
+        if (cmp == 0) {
+            if (index)
+                *index = mid;
+            return node->children[mid];
+        }
+        if (cmp < 0)
+            hi = mid;
+        else
+            lo = mid + 1;
+    }
+    return NULL;
+}
+
+/**
+ * @brief Finds slot of hash index that refers to child at index
+ */
+static uint64_t tree_findslot (tree node, uint32_t hash, uint64_t index)
+{
+    uint64_t mask = node->indexcap - 1;
+    uint64_t i = hash & mask;
+    while (node->childindex[i] != index + 1)
+        i = (i + 1) & mask;
+    return i;
+}
+
+/**
+ * @brief (Re)builds hash index of children of node
+ *
+ * The hash index is an open addressing table with linear probing. Each
+ * slot holds index + 1 of a child in the children array, 0 if empty.
+ *
+ * @param node The node
+ * @param indexcap Number of slots, must be a power of 2 greater than childcount
+ * @return bool False if allocation failed, node is unchanged then
+ */
+static bool tree_buildindex (tree node, uint64_t indexcap)
+{
+    uint32_t *childindex = tree_calloc (node->meta, indexcap * sizeof (uint32_t));
+    if (!childindex)
+        return false;
+    uint64_t mask = indexcap - 1;
+    for (uint64_t c = 0; c < node->childcount; c++) {
+        uint64_t i = node->children[c]->hash & mask;
+        while (childindex[i])
+            i = (i + 1) & mask;
+        childindex[i] = c + 1;
+    }
+    tree_free (node->meta, node->childindex);
+    node->childindex = childindex;
+    node->indexcap = indexcap;
+    return true;
+}
+
+/**
+ * @brief Drops hash index of node, children are sorted again
+ */
+static void tree_dropindex (tree node)
+{
+    tree_free (node->meta, node->childindex);
+    node->childindex = NULL;
+    node->indexcap = 0;
+    qsort (node->children, node->childcount, sizeof (tree), tree_cmpchild);
+}
+
+/**
+ * @brief Adds child to children of node, name and hash of child must be set
+ *
+ * Up to TREE_LINEAR_MAX children, children are kept in insertion order.
+ * Up to TREE_SORTED_MAX children, children are kept sorted by hash and name.
+ * Beyond that, children are kept in insertion order along with a hash index.
+ *
+ * @return bool False if allocation failed
+ */
+static bool tree_addchild (tree node, tree child)
+{
+    if (node->childcount == node->childcap) {
+        uint64_t childcap = node->childcap ? 2 * node->childcap : 4;
+        tree *children = tree_realloc (node->meta, node->children,
+            node->childcap * sizeof (tree), childcap * sizeof (tree));
+        if (!children)
+            return false;
+        node->children = children;
+        node->childcap = childcap;
+    }
+    if (node->childindex) {
+        // keep load factor of hash index under 1/2
+        if (2 * (node->childcount + 1) > node->indexcap
+            && !tree_buildindex (node, 2 * node->indexcap))
+            return false;
+        uint64_t mask = node->indexcap - 1;
+        uint64_t i = child->hash & mask;
+        while (node->childindex[i])
+            i = (i + 1) & mask;
+        node->childindex[i] = node->childcount + 1;
+        node->children[node->childcount++] = child;
+    } else if (node->childcount < TREE_LINEAR_MAX) {
+        node->children[node->childcount++] = child;
+    } else if (node->childcount < TREE_SORTED_MAX) {
+        if (node->childcount == TREE_LINEAR_MAX)
+            qsort (node->children, node->childcount, sizeof (tree), tree_cmpchild);
+        uint64_t lo = 0, hi = node->childcount;
+        while (lo < hi) {
+            uint64_t mid = lo + (hi - lo) / 2;
+            if (tree_cmpname (child->hash, child->nameid, node->children[mid]) < 0)
+                hi = mid;
+            else
+                lo = mid + 1;
+        }
+        memmove (&node->children[lo + 1], &node->children[lo], (node->childcount - lo) * sizeof (tree));
+        node->children[lo] = child;
+        node->childcount++;
+    } else {
+        node->children[node->childcount++] = child;
+        if (!tree_buildindex (node, 4 * TREE_SORTED_MAX)) {
+            node->childcount--;
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Removes child at index from children of node, the child isn't freed
+ */
+static void tree_removechild (tree node, uint64_t index)
+{
+    uint64_t last = node->childcount - 1;
+    if (!node->childindex) {
+        memmove (&node->children[index], &node->children[index + 1], (last - index) * sizeof (tree));
+        node->childcount--;
+        return;
+    }
+    // backward shift deletion, so that no probe sequence is broken
+    uint64_t mask = node->indexcap - 1;
+    uint64_t i = tree_findslot (node, node->children[index]->hash, index);
+    for (uint64_t j = (i + 1) & mask; node->childindex[j]; j = (j + 1) & mask) {
+        uint64_t home = node->children[node->childindex[j] - 1]->hash & mask;
+        if ((j > i && (home <= i || home > j)) || (j < i && home <= i && home > j)) {
+            node->childindex[i] = node->childindex[j];
+            i = j;
+        }
+    }
+    node->childindex[i] = 0;
+    // last child takes the place of removed child
+    if (index != last) {
+        tree moved = node->children[last];
+        node->childindex[tree_findslot (node, moved->hash, last)] = index + 1;
+        node->children[index] = moved;
+    }
+    node->childcount--;
+    if (node->childcount <= TREE_SORTED_MAX / 2)
+        tree_dropindex (node);
+}
+
+/**
+ * @brief Deep copies node and its subtree into a tree
+ *
+ * Names are interned into the name table of the destination tree, so
+ * node may belong to any tree. Like tree_delete, the copy follows parent
+ * links instead of recursing, the number of children copied so far tells
+ * which child of the source node is next, so trees of any depth can be
+ * copied.
+ *
+ * @param node The node to copy
+ * @param parent Parent of the copy
+ * @param meta State of the destination tree
+ * @return tree The copy, NULL if allocation failed
+ */
+static tree tree_copy (tree node, tree parent, struct _tree_meta *meta)
+{
+    tree copy = NULL, src = node, dst = parent;
+    for (;;) {
+        uint32_t nameid = src->nameid;
+        if (src->meta != meta) {
+            struct _tree_name *name = &src->meta->names[src->nameid];
+            nameid = tree_intern (meta, name->str, name->len, name->hash);
+            if (nameid == TREE_NONAME)
+                break;
+        }
+        tree child = tree_newnode (meta, nameid, dst);
+        if (!child)
+            break;
+        child->value = src->value;
+        if (!copy)
+            copy = child;
+        else if (!tree_addchild (dst, child)) {
+            tree_delete (&child);
+            break;
+        }
+        dst = child;
+        // climb up to the first node that has children left to copy
+        while (dst->childcount == src->childcount) {
+            if (meta->aggregates)
+                tree_aggcompute (dst);
+            if (src == node)
+                return copy;
+            src = src->parent;
+            dst = dst->parent;
+        }
+        src = src->children[dst->childcount];
+    }
+    tree_delete (&copy);
+    return NULL;
+}
+
+/**
+ * @brief Frees a path cache, cache may be NULL
+ */
+static void tree_freecache (struct _tree_cache *cache)
+{
+    if (!cache)
+        return;
+    for (uint64_t i = 0; i < cache->count; i++)
+        free (cache->entries[i].path);
+    free (cache->entries);
+    free (cache->index);
+    free (cache);
+}
+
+/**
+ * @brief Finds entry of a path in the path cache
+ * @return struct _tree_cacheentry* NULL if path isn't cached
+ */
+static struct _tree_cacheentry *tree_cachefind (struct _tree_cache *cache, const char *path, uint64_t len, uint64_t hash)
+{
+    uint64_t mask = cache->indexcap - 1;
+    for (uint64_t i = hash & mask; cache->index[i]; i = (i + 1) & mask) {
+        struct _tree_cacheentry *entry = &cache->entries[cache->index[i] - 1];
+        if (entry->hash == hash && entry->len == len && !memcmp (entry->path, path, len))
+            return entry;
+    }
+    return NULL;
+}
+
+/**
+ * @brief Removes an entry from the hash index of the path cache
+ */
+static void tree_cacheunindex (struct _tree_cache *cache, uint64_t entry)
+{
+    // backward shift deletion, so that no probe sequence is broken
+    uint64_t mask = cache->indexcap - 1;
+    uint64_t i = cache->entries[entry].hash & mask;
+    while (cache->index[i] != entry + 1)
+        i = (i + 1) & mask;
+    for (uint64_t j = (i + 1) & mask; cache->index[j]; j = (j + 1) & mask) {
+        uint64_t home = cache->entries[cache->index[j] - 1].hash & mask;
+        if ((j > i && (home <= i || home > j)) || (j < i && home <= i && home > j)) {
+            cache->index[i] = cache->index[j];
+            i = j;
+        }
+    }
+    cache->index[i] = 0;
+}
+
+/**
+ * @brief Caches a path to node lookup, evicting an entry if the cache is full
+ *
+ * Entries whose reference bit is clear or that are stale get evicted,
+ * the reference bits of entries passed over are cleared. If allocation
+ * fails, the path simply isn't cached.
+ */
+static void tree_cacheput (struct _tree_meta *meta, const char *path, uint64_t len, uint64_t hash, tree node)
+{
+    struct _tree_cache *cache = meta->cache;
+    struct _tree_cacheentry *entry = tree_cachefind (cache, path, len, hash);
+    if (!entry) {
+        uint64_t victim;
+        if (cache->count < cache->capacity) {
+            victim = cache->count;
+            cache->entries[victim].path = NULL;
+        } else {
+            for (;;) {
+                entry = &cache->entries[cache->hand];
+                if (!entry->referenced || entry->generation != meta->generation)
+                    break;
+                entry->referenced = false;
+                cache->hand = (cache->hand + 1) % cache->capacity;
+            }
+            victim = cache->hand;
+            cache->hand = (cache->hand + 1) % cache->capacity;
+            tree_cacheunindex (cache, victim);
+        }
+        entry = &cache->entries[victim];
+        char *copy = realloc (entry->path, len ? len : 1);
+        if (!copy) {
+            // realloc left the victim as it was, so put it back
+            if (victim < cache->count) {
+                uint64_t mask = cache->indexcap - 1;
+                uint64_t i = entry->hash & mask;
+                while (cache->index[i])
+                    i = (i + 1) & mask;
+                cache->index[i] = victim + 1;
+            }
+            return;
+        }
+        memcpy (copy, path, len);
+        entry->path = copy;
+        entry->len = len;
+        entry->hash = hash;
+        uint64_t mask = cache->indexcap - 1;
+        uint64_t i = hash & mask;
+        while (cache->index[i])
+            i = (i + 1) & mask;
+        cache->index[i] = victim + 1;
+        if (victim == cache->count)
+            cache->count++;
+    }
+    entry->node = node;
+    entry->generation = meta->generation;
+    entry->referenced = false;
+}
+
+/**
+ * @brief Enables, resizes or disables the path cache of a tree
+ *
+ * The path cache maps whole path strings to nodes, so that repeated
+ * lookups of the same path from the root cost one hash probe instead of
+ * a walk. It holds at most capacity paths and evicts with the CLOCK
+ * algorithm. Removing or replacing nodes invalidates all entries.
+ *
+ * Paths are cached as given, so "/a/b" and "a//b" take separate entries.
+ * Only lookups made from the root of the tree use the cache.
+ *
+ * NOTE:
+ * With the cache enabled, lookups update the cache, so the tree may no
+ * longer be read from many threads at once.
+ *
+ * @param tr The tree root
+ * @param capacity Max number of cached paths, 0 disables the cache
+ * @return bool True if successful
+ */
+bool tree_setcache (tree tr, uint64_t capacity)
+{
+    if (!tr)
+        return false;
+    struct _tree_meta *meta = tr->meta;
+    tree_freecache (meta->cache);
+    meta->cache = NULL;
+    if (capacity == 0)
+        return true;
+    if (capacity > 0x7fffffff)
+        return false;
+    struct _tree_cache *cache = malloc (1 * sizeof (struct _tree_cache));
+    if (!cache)
+        return false;
+    cache->capacity = capacity;
+    cache->count = 0;
+    cache->hand = 0;
+    // keep load factor of hash index under 1/2
+    cache->indexcap = 1;
+    while (cache->indexcap < 2 * capacity)
+        cache->indexcap *= 2;
+    cache->entries = malloc (capacity * sizeof (struct _tree_cacheentry));
+    cache->index = calloc (cache->indexcap, sizeof (uint32_t));
+    if (!cache->entries || !cache->index) {
+        free (cache->entries);
+        free (cache->index);
+        free (cache);
+        return false;
+    }
+    meta->cache = cache;
+    return true;
+}
+
+/**
+ * @brief Computes aggregates of a node once those of its children are, for tree_setaggregate
+ */
+static bool tree_aggnode (tree node, uint64_t depth, void *ctx)
+{
+    tree_aggcompute (node);
+    return true;
+}
+
+/**
+ * @brief Enables or disables subtree aggregates of a tree
+ *
+ * While enabled, every node keeps the sum, count, min and max of the
+ * values in its subtree, and tree_setdata, tree_setnode and tree_rmnode
+ * update them along the parent chain of the changed node. Sum and count
+ * are updated in O(1) per ancestor. Min and max too, unless the old min
+ * or max of an ancestor is gone, in which case the children of that
+ * ancestor are scanned.
+ *
+ * Enabling computes the aggregates of all nodes, in O(number of nodes).
+ *
+ * @param tr The tree root
+ * @param enable True to enable, false to disable
+ * @return bool True if successful, false for a mapped tree
+ */
+bool tree_setaggregate (tree tr, bool enable)
+{
+    if (!tr || tr->meta->image)
+        return false;
+    struct _tree_meta *meta = tr->meta;
+    if (!enable || meta->aggregates) {
+        meta->aggregates = enable;
+        return true;
+    }
+    if (!tree_walk (meta->root, TREE_DFS, NULL, tree_aggnode, NULL))
+        return false;
+    meta->aggregates = true;
+    return true;
+}
+
+/**
+ * @brief Adds value of a node to aggregates in ctx, for tree_aggregate without aggregates enabled
+ */
+static bool tree_aggadd (tree node, uint64_t depth, void *ctx)
+{
+    struct _tree_aggregate *agg = ctx;
+    agg->sum = (int64_t) ((uint64_t) agg->sum + (uint64_t) node->value);
+    agg->count++;
+    if (node->value < agg->min)
+        agg->min = node->value;
+    if (node->value > agg->max)
+        agg->max = node->value;
+    return true;
+}
+
+/**
+ * @brief Gets aggregates of the values of a node and its subtree
+ *
+ * Takes O(depth) with aggregates enabled, otherwise the subtree is walked.
+ *
+ * @param tr The tree root
+ * @param path Path to target node, need not be null terminated
+ * @param len Length of path
+ * @param agg Set to the aggregates
+ * @return bool False if path doesn't exist
+ */
+bool tree_aggregate (tree tr, const char *path, uint64_t len, struct _tree_aggregate *agg)
+{
+    tree node = tree_getnode (tr, path, len);
+    if (!node)
+        return false;
+    if (node->meta->aggregates) {
+        *agg = node->agg;
+        return true;
+    }
+    struct _tree_aggregate sum = { 0, 0, INT64_MAX, INT64_MIN };
+    if (!tree_walk (node, TREE_DFS, tree_aggadd, NULL, &sum))
+        return false;
+    *agg = sum;
+    return true;
+}
+
+/**
+ * @brief Allocates a tree with only a root
+ * @param arenanodes True if nodes are to be allocated from the arena
+ * @return tree NULL if allocation failed
+ */
+static tree tree_newtree (bool arenanodes)
+{
+    struct _tree_meta *meta = tree_newmeta (arenanodes);
+    if (!meta)
+        return NULL;
+    uint32_t nameid = tree_intern (meta, "", 0, tree_hash ("", 0));
+    tree root = nameid == TREE_NONAME ? NULL : tree_newnode (meta, nameid, NULL);
+    if (!root) {
+        tree_freemeta (meta);
+        return NULL;
+    }
+    meta->root = root;
+    return root;
+}
 
 /**
  * @brief Allocates a new tree in the heap
@@ -12,45 +945,308 @@ tree tree_mknode (tree tr, const string path);
  */
 tree new_tree()
 {
-    tree root = malloc (1 * sizeof (struct _tree_node));
-    if (!root)
-        return NULL;
-    root->name = "";
-    root->value = 0;
-    root->parent = NULL;
-    root->children = NULL;
-    root->childcount = 0;
-    return root;
+    return tree_newtree (false);
+}
+
+/**
+ * @brief Allocates a new tree whose nodes live in an arena
+ *
+ * Nodes and their child arrays are carved out of large blocks owned by
+ * the tree, so building the tree makes few calls to malloc, and
+ * tree_delete on the root releases the whole tree by freeing the blocks,
+ * without visiting any node.
+ *
+ * NOTE:
+ * Memory of nodes removed by tree_rmnode or tree_setnode, and of child
+ * arrays that grew, is only reclaimed when the whole tree is deleted.
+ *
+ * @return tree
+ */
+tree new_tree_arena()
+{
+    return tree_newtree (true);
+}
+
+/**
+ * @brief Gets name of a node
+ * @param node The node
+ * @return const char* Null terminated name, owned by the tree
+ */
+const char *tree_getname (tree node)
+{
+    return node->meta->names[node->nameid].str;
 }
 
 /**
  * @brief Sets data of a node
  * @param tr The tree root
- * @param path Path to target node
+ * @param path Path to target node, need not be null terminated
+ * @param len Length of path
  * @param val Value to be set at target node
  * @return bool True if successful
  */
-bool tree_setdata (tree tr, const string path, int64_t val)
+bool tree_setdata (tree tr, const char *path, uint64_t len, int64_t val)
 {
-    tree node = tree_getnode (tr, path);
-    if (!node) {
-        node = tree_mknode (tr, path);
+    struct _tree_meta *meta = tr->meta;
+    if (meta->image)
+        return false;
+    if (meta->cache && tr == meta->root) {
+        uint64_t hash = tree_hash (path, len);
+        struct _tree_cacheentry *entry = tree_cachefind (meta->cache, path, len, hash);
+        if (entry && entry->generation == meta->generation) {
+            entry->referenced = true;
+            tree_setvalue (entry->node, val);
+            return true;
+        }
+        tree node = tree_mknode (tr, path, len);
         if (!node)
             return false;
+        tree_cacheput (meta, path, len, hash, node);
+        tree_setvalue (node, val);
+        return true;
     }
-    node->value = val;
+    tree node = tree_mknode (tr, path, len);
+    if (!node)
+        return false;
+    tree_setvalue (node, val);
     return true;
 }
 
+/**
+ * @brief Finds child of node named by a path segment
+ * @return tree NULL if there's no such child
+ */
+static tree tree_segchild (tree node, const char *seg, uint64_t seglen)
+{
+    uint32_t hash = tree_hash (seg, seglen);
+    uint32_t nameid = tree_findname (node->meta, seg, seglen, hash);
+    return nameid == TREE_NONAME ? NULL : tree_findchild (node, nameid, hash, NULL);
+}
+
+/**
+ * @brief Finds child of node named by a path segment, creating it if needed
+ * @return tree NULL if allocation failed
+ */
+static tree tree_mkchild (tree node, const char *seg, uint64_t seglen)
+{
+    uint32_t hash = tree_hash (seg, seglen);
+    uint32_t nameid = tree_intern (node->meta, seg, seglen, hash);
+    if (nameid == TREE_NONAME)
+        return NULL;
+    tree child = tree_findchild (node, nameid, hash, NULL);
+    if (child)
+        return child;
+    child = tree_newnode (node->meta, nameid, node);
+    if (!child)
+        return NULL;
+    if (!tree_addchild (node, child)) {
+        tree_free (node->meta, child);
+        return NULL;
+    }
+    if (node->meta->aggregates) {
+        struct _tree_aggregate empty = { 0, 0, INT64_MAX, INT64_MIN };
+        tree_aggchange (node, empty, child->agg);
+    }
+    return child;
+}
+
+/**
+ * @brief Checks if two paths have the same segments
+ */
+static bool tree_samepath (const char *path1, uint64_t len1, const char *path2, uint64_t len2)
+{
+    uint64_t pos1 = 0, pos2 = 0;
+    const char *seg1, *seg2;
+    uint64_t seglen1, seglen2;
+    for (;;) {
+        bool more1 = tree_nextseg (path1, len1, &pos1, &seg1, &seglen1);
+        bool more2 = tree_nextseg (path2, len2, &pos2, &seg2, &seglen2);
+        if (!more1 || !more2)
+            return more1 == more2;
+        if (seglen1 != seglen2 || memcmp (seg1, seg2, seglen1))
+            return false;
+    }
+}
+
+/**
+ * @brief Sets or gets data of many paths, walking each parent path once
+ *
+ * A hash table maps the hash of the segments of a parent path to the node
+ * at that path. On a hit the parent path is compared with that of the
+ * first path of the group, so paths whose parents only share a hash
+ * aren't mixed up, they probe on to their own group.
+ *
+ * @param setvals Values to set, NULL to get values instead
+ * @param getvals Set to values got, used if setvals is NULL
+ * @return bool True if all paths were set or found
+ */
+static bool tree_batch (tree tr, const char **paths, const uint64_t *lens, uint64_t count,
+    const int64_t *setvals, int64_t *getvals, bool *success)
+{
+    bool all = true;
+    uint64_t groupcap = 1024, groupcount = 0;
+    struct _tree_batchgroup prev = { 0, 0, NULL };
+    struct _tree_batchgroup *groups = calloc (groupcap, sizeof (struct _tree_batchgroup));
+    // parent path of each path ends where its last segment starts
+    uint64_t *parentlens = malloc ((count ? count : 1) * sizeof (uint64_t));
+    if (!groups || !parentlens || tr->meta->image) {
+        // one path at a time, as if no batch
+        for (uint64_t i = 0; i < count; i++) {
+            bool found;
+            if (setvals) {
+                found = tree_setdata (tr, paths[i], lens[i], setvals[i]);
+            } else {
+                getvals[i] = tree_getdata (tr, paths[i], lens[i]);
+                found = getvals[i] != TREE_ERROR;
+            }
+            if (success)
+                success[i] = found;
+            all = all && found;
+        }
+        free (groups);
+        free (parentlens);
+        return all;
+    }
+    for (uint64_t i = 0; i < count; i++) {
+        const char *path = paths[i];
+        uint64_t len = lens[i], pos = 0;
+        const char *seg, *last = NULL;
+        uint64_t seglen, lastlen = 0;
+        uint64_t hash = 0xcbf29ce484222325ull;
+        while (tree_nextseg (path, len, &pos, &seg, &seglen)) {
+            if (last)
+                hash = (hash * 0x100000001b3ull) ^ tree_hash (last, lastlen);
+            last = seg;
+            lastlen = seglen;
+        }
+        tree node = tr;
+        if (last)
+            parentlens[i] = last - path;
+        if (last && prev.index && prev.hash == hash && parentlens[prev.index - 1] == parentlens[i]
+            && !memcmp (paths[prev.index - 1], path, parentlens[i])) {
+            // consecutive paths often share a parent, so the last group is tried first
+            node = prev.parent ? (setvals ? tree_mkchild (prev.parent, last, lastlen)
+                : tree_segchild (prev.parent, last, lastlen)) : NULL;
+        } else if (last) {
+            // keep load factor of groups under 1/2
+            if (2 * (groupcount + 1) > groupcap) {
+                struct _tree_batchgroup *grown = calloc (2 * groupcap, sizeof (struct _tree_batchgroup));
+                if (grown) {
+                    for (uint64_t g = 0; g < groupcap; g++) {
+                        if (!groups[g].index)
+                            continue;
+                        uint64_t j = groups[g].hash & (2 * groupcap - 1);
+                        while (grown[j].index)
+                            j = (j + 1) & (2 * groupcap - 1);
+                        grown[j] = groups[g];
+                    }
+                    free (groups);
+                    groups = grown;
+                    groupcap *= 2;
+                }
+            }
+            uint64_t mask = groupcap - 1, j;
+            for (j = hash & mask; groups[j].index; j = (j + 1) & mask) {
+                uint64_t first = groups[j].index - 1;
+                if (groups[j].hash != hash)
+                    continue;
+                // paths are usually written alike, so try bytes before segments
+                if ((parentlens[first] == parentlens[i] && !memcmp (paths[first], path, parentlens[i]))
+                    || tree_samepath (paths[first], parentlens[first], path, parentlens[i]))
+                    break;
+            }
+            if (groups[j].index) {
+                node = groups[j].parent;
+                prev = groups[j];
+            } else {
+                if (setvals) {
+                    node = tree_mknode (tr, path, parentlens[i]);
+                } else {
+                    uint64_t found;
+                    node = tree_glvnip (tr, path, parentlens[i], &found);
+                    if (found != parentlens[i])
+                        node = NULL;
+                }
+                prev.hash = hash;
+                prev.index = i + 1;
+                prev.parent = node;
+                // a full table just means no group is kept for this parent
+                if ((node || !setvals) && 2 * (groupcount + 1) <= groupcap) {
+                    groups[j] = prev;
+                    groupcount++;
+                }
+                if (!node && setvals)
+                    prev.index = 0;
+            }
+            if (node)
+                node = setvals ? tree_mkchild (node, last, lastlen) : tree_segchild (node, last, lastlen);
+        }
+        if (node && setvals)
+            tree_setvalue (node, setvals[i]);
+        else if (!setvals)
+            getvals[i] = node ? node->value : TREE_ERROR;
+        if (success)
+            success[i] = node != NULL;
+        all = all && node;
+    }
+    free (groups);
+    free (parentlens);
+    return all;
+}
+
+/**
+ * @brief Sets data of many nodes
+ *
+ * Paths are grouped by their parent path, that is all but the last
+ * segment. The parent path of each group is walked once, after that
+ * each path costs a hash of its bytes and one child lookup. Paths are
+ * set in the given order, so a path given twice gets the later value.
+ *
+ * @param tr The tree root
+ * @param paths Paths to target nodes, need not be null terminated
+ * @param lens Lengths of paths
+ * @param vals Values to be set at target nodes
+ * @param count Number of paths
+ * @param success If not NULL, success[i] is set to true if paths[i] was set
+ * @return bool True if all paths were set
+ */
+bool tree_setdata_batch (tree tr, const char **paths, const uint64_t *lens, const int64_t *vals,
+    uint64_t count, bool *success)
+{
+    return tree_batch (tr, paths, lens, count, vals, NULL, success);
+}
+
+/**
+ * @brief Gets data of many nodes
+ *
+ * Paths are grouped by parent path like in tree_setdata_batch.
+ *
+ * @param tr The tree root
+ * @param paths Paths to target nodes, need not be null terminated
+ * @param lens Lengths of paths
+ * @param count Number of paths
+ * @param vals vals[i] is set to data at paths[i], TREE_ERROR if it doesn't exist
+ * @param success If not NULL, success[i] is set to true if paths[i] exists
+ * @return bool True if all paths exist
+ */
+bool tree_getdata_batch (tree tr, const char **paths, const uint64_t *lens, uint64_t count,
+    int64_t *vals, bool *success)
+{
+    return tree_batch (tr, paths, lens, count, NULL, vals, success);
+}
+
 /**
  * @brief Gets data of a node
  * @param tr The tree root
- * @param path Path to target node
+ * @param path Path to target node, need not be null terminated
+ * @param len Length of path
  * @return int64_t Returns TREE_ERROR on error
  */
-int64_t tree_getdata (tree tr, const string path)
+int64_t tree_getdata (tree tr, const char *path, uint64_t len)
 {
-    tree node = tree_getnode (tr, path);
+    if (tr->meta->image)
+        return tree_imagegetdata (tr->meta, path, len);
+    tree node = tree_getnode (tr, path, len);
     if (!node)
         return TREE_ERROR;
     return node->value;
@@ -59,132 +1255,704 @@ int64_t tree_getdata (tree tr, const string path)
 /**
  * @brief Sets node to another node
  *
- * WARNING:
- * This method allows circular reference & and setting of one tree
- * root to the node of another tree. Abuse of this function will
- * only result in hellish mental pain.
- *
- * NOTE:
- * Circular references may result in infinite recursive calls when
- * using tree_delete or tree_rmnode. In such cases, you'll need to
- * write your own deletion function.
+ * The value of node2 and a deep copy of its subtree replace the value and
+ * subtree of the target node. Name and parent of target node are unchanged.
+ * As a copy is made, node2 may be anywhere, even inside the target subtree.
  *
  * @param tr The tree root
- * @param path Path to target node
+ * @param path Path to target node, need not be null terminated
+ * @param len Length of path
  * @param node2 The node to be set to at target node
  * @return bool True if successful
  */
-bool tree_setnode (tree tr, const string path, tree node2)
+bool tree_setnode (tree tr, const char *path, uint64_t len, tree node2)
 {
-    tree node = tree_getnode (tr, path);
-    if (!node)
+    tree node = tree_getnode (tr, path, len);
+    if (!node || !node2)
         return false;
+    tree copy = tree_copy (node2, node->parent, node->meta);
+    if (!copy)
+        return false;
+    for (uint64_t i = 0; i < node->childcount; i++)
+        tree_delete (&node->children[i]);
+    tree_free (node->meta, node->children);
+    tree_free (node->meta, node->childindex);
     // name and parent of node unchanged
-    node->value = node2->value;
-    if (node->children)
-        free (node->children);
-    node->children = node2->children;
+    struct _tree_aggregate old = node->agg;
+    node->agg = copy->agg;
+    node->value = copy->value;
+    node->children = copy->children;
+    node->childcount = copy->childcount;
+    node->childcap = copy->childcap;
+    node->childindex = copy->childindex;
+    node->indexcap = copy->indexcap;
+    for (uint64_t i = 0; i < node->childcount; i++)
+        node->children[i]->parent = node;
+    tree_free (node->meta, copy);
+    if (node->meta->aggregates)
+        tree_aggchange (node->parent, old, node->agg);
+    node->meta->generation++;
     return true;
 }
 
 /**
  * @brief Gets target node
+ *
+ * Each path segment is found in O(1) expected time for nodes with many
+ * children, and by binary or linear search for nodes with fewer children.
+ *
  * @param tr The tree root
- * @param path Path to target node
+ * @param path Path to target node, need not be null terminated
+ * @param len Length of path
  * @return tree Returns NULL if path doesn't exist
  */
-tree tree_getnode (tree node, const string path)
+tree tree_getnode (tree node, const char *path, uint64_t len)
 {
-    string token = strtok (path, "/");
-    while (token) {
-        uint64_t i = 0;
-        for (i = 0; i < node->childcount; i++) {
-            if (!strcmp (node->children[i]->name, token)) {
-                token = strtok (NULL, "/");
-                node = node->children[i];
-                break;
-            }
+    struct _tree_meta *meta = node->meta;
+    if (meta->image)
+        return NULL;
+    uint64_t pos;
+    if (meta->cache && node == meta->root) {
+        uint64_t hash = tree_hash (path, len);
+        struct _tree_cacheentry *entry = tree_cachefind (meta->cache, path, len, hash);
+        if (entry && entry->generation == meta->generation) {
+            entry->referenced = true;
+            return entry->node;
         }
-        if (!node->parent->children[i -1])
+        node = tree_glvnip (node, path, len, &pos);
+        if (pos != len)
             return NULL;
+        tree_cacheput (meta, path, len, hash, node);
+        return node;
     }
+    node = tree_glvnip (node, path, len, &pos);
+    if (pos != len)
+        return NULL;
     return node;
 }
 
 /**
  * @brief Returns last valid node in path string: tree_get_last_valid_node_in_path
+ *
+ * A segment that was never interned can't name any node, so the walk
+ * stops there without looking at any children.
+ *
  * @param node The node from where to traverse tree
- * @param path Path to node
- * @param index Pointer to uint64_t variable, holds index of returned node in children array of the parent
- */
-tree tree_glvnip (tree node, const string path, uint64_t *index)
-{
-    string token = strtok (path, "/");
-    while (token) {
-        uint64_t i = 0;
-        for (i = 0; i < node->childcount; i++) {
-            if (!strcmp (node->children[i]->name, token)) {
-                token = strtok (NULL, "/");
-                node = node->children[i];
-                *index = i;
-                break;
-            }
-        }
-        if (!node->parent->children[i -1]) {
-            *index = TREE_ERROR;
-            break;
+ * @param path Path to node, need not be null terminated
+ * @param len Length of path
+ * @param pos Set to offset of first path segment that doesn't exist, len if whole path exists
+ */
+tree tree_glvnip (tree node, const char *path, uint64_t len, uint64_t *pos)
+{
+    const char *seg;
+    uint64_t seglen;
+    uint64_t next = 0;
+    while (tree_nextseg (path, len, &next, &seg, &seglen)) {
+        uint32_t hash = tree_hash (seg, seglen);
+        uint32_t nameid = tree_findname (node->meta, seg, seglen, hash);
+        tree child = nameid == TREE_NONAME ? NULL : tree_findchild (node, nameid, hash, NULL);
+        if (!child) {
+            *pos = seg - path;
+            return node;
         }
+        node = child;
     }
+    *pos = len;
     return node;
 }
 
 /**
  * @brief Creates nodes based on path string, already created nodes are unaffected
- * @return The last newly created node
+ * @return The target node, NULL if allocation failed
  */
-tree tree_mknode (tree tr, const string path)
+tree tree_mknode (tree tr, const char *path, uint64_t len)
 {
-    uint64_t index;
-    tree node = tree_glvnip (tr, path, &index);
-    if (!node)
-        return NULL;
-    // tree parent = node->parent;
-    string token = strtok (path, "/");
-    bool flag_start = false;
-    while (token) {
-        if (!flag_start && strcmp (token, node->name)) {
-            flag_start = true;
+    uint64_t pos;
+    const char *seg;
+    uint64_t seglen;
+    tree node = tree_glvnip (tr, path, len, &pos);
+    tree base = node, first = NULL, target = node;
+    while (tree_nextseg (path, len, &pos, &seg, &seglen)) {
+        uint32_t nameid = tree_intern (node->meta, seg, seglen, tree_hash (seg, seglen));
+        tree newnode = nameid == TREE_NONAME ? NULL : tree_newnode (node->meta, nameid, node);
+        if (newnode && !tree_addchild (node, newnode)) {
+            tree_free (node->meta, newnode);
+            newnode = NULL;
         }
-        if (flag_start) {
-            node->children = realloc (node->children, sizeof (struct _tree_node) * ++(node->childcount));
-            node->children[node->childcount -1] = new_tree();
-            tree newnode = node->children[node->childcount -1];
-            newnode->name = token;
-            newnode->parent = node;
-            node = newnode;
+        if (!newnode) {
+            target = NULL;
+            break;
         }
-        token = strtok (NULL, "/");
+        if (!first)
+            first = newnode;
+        node = target = newnode;
     }
-    if (!flag_start)
-        return NULL;
-    return node;
+    if (first && base->meta->aggregates) {
+        // new nodes form a chain of zeros, each counts the ones below it
+        uint64_t count = 1;
+        for (tree n = node; n != base; n = n->parent)
+            n->agg.count = count++;
+        struct _tree_aggregate empty = { 0, 0, INT64_MAX, INT64_MIN };
+        tree_aggchange (base, empty, first->agg);
+    }
+    return target;
 }
 
 /**
  * @brief Deletes a node
+ *
+ * The root of a tree can't be removed, use tree_delete instead.
+ *
  * @param tr The tree root
- * @param path Path to target node
+ * @param path Path to target node, need not be null terminated
+ * @param len Length of path
  * @return bool True if successful
  */
-bool tree_rmnode (tree tr, const string path)
+bool tree_rmnode (tree tr, const char *path, uint64_t len)
 {
-    tree node = tree_getnode (tr, path);
-    if (!node)
+    tree node = tree_getnode (tr, path, len);
+    if (!node || !node->parent)
         return false;
+    uint64_t index;
+    tree_findchild (node->parent, node->nameid, node->hash, &index);
+    tree_removechild (node->parent, index);
+    if (tr->meta->aggregates) {
+        struct _tree_aggregate empty = { 0, 0, INT64_MAX, INT64_MIN };
+        tree_aggchange (node->parent, node->agg, empty);
+    }
     tree_delete (&node);
+    tr->meta->generation++;
+    return true;
+}
+
+/**
+ * @brief Writes all of buf to fd, retrying partial writes
+ */
+static bool tree_writeall (int fd, const void *buf, uint64_t len)
+{
+    const char *bytes = buf;
+    while (len > 0) {
+        ssize_t written = write (fd, bytes, len);
+        if (written < 0)
+            return false;
+        bytes += written;
+        len -= written;
+    }
+    return true;
+}
+
+/**
+ * @brief Counts nodes for tree_save
+ */
+static bool tree_countnode (tree node, uint64_t depth, void *ctx)
+{
+    (*(uint64_t *) ctx)++;
     return true;
 }
 
+/**
+ * @brief Writes a subtree to a file as an image that tree_map can load
+ *
+ * The image holds the names of the tree in a string table, and the nodes
+ * in breadth first order with the children of each node as a range of
+ * indices. It contains no pointers, so it can be mapped at any address,
+ * but it is in the byte order of the machine that wrote it.
+ *
+ * @param node The node to save, saved as the root of the image
+ * @param fd File descriptor open for writing
+ * @return bool True if successful
+ */
+bool tree_save (tree node, int fd)
+{
+    if (!node || node->meta->image)
+        return false;
+    struct _tree_meta *meta = node->meta;
+    uint64_t nodecount = 0;
+    if (!tree_walk (node, TREE_DFS, tree_countnode, NULL, &nodecount) || nodecount > TREE_NONAME)
+        return false;
+    struct _tree_imageheader header;
+    memset (&header, 0, sizeof (header));
+    memcpy (header.magic, TREE_IMAGE_MAGIC, sizeof (header.magic));
+    header.nodecount = nodecount;
+    header.namecount = meta->namecount;
+    header.namesoff = sizeof (header);
+    header.strtaboff = header.namesoff + meta->namecount * sizeof (struct _tree_imagename);
+    for (uint32_t id = 0; id < meta->namecount; id++)
+        header.strtabsize += meta->names[id].len + 1;
+    // nodes hold 64-bit values, keep them aligned
+    header.nodesoff = (header.strtaboff + header.strtabsize + 7) & ~(uint64_t) 7;
+    // nodes in the order they go into the image
+    tree *order = malloc (nodecount * sizeof (tree));
+    struct _tree_imagename *names = malloc ((meta->namecount ? meta->namecount : 1) * sizeof (struct _tree_imagename));
+    bool success = false;
+    if (!order || !names)
+        goto done;
+    if (!tree_writeall (fd, &header, sizeof (header)))
+        goto done;
+    uint64_t off = 0;
+    for (uint32_t id = 0; id < meta->namecount; id++) {
+        names[id].off = off;
+        names[id].len = meta->names[id].len;
+        names[id].hash = meta->names[id].hash;
+        off += meta->names[id].len + 1;
+    }
+    if (!tree_writeall (fd, names, meta->namecount * sizeof (struct _tree_imagename)))
+        goto done;
+    for (uint32_t id = 0; id < meta->namecount; id++)
+        if (!tree_writeall (fd, meta->names[id].str, meta->names[id].len + 1))
+            goto done;
+    static const char padding[8];
+    if (!tree_writeall (fd, padding, header.nodesoff - header.strtaboff - header.strtabsize))
+        goto done;
+    // breadth first, children of each node are placed together sorted by hash
+    struct _tree_imagenode buffer[1024];
+    uint64_t buffered = 0, tail = 1;
+    order[0] = node;
+    for (uint64_t head = 0; head < nodecount; head++) {
+        tree current = order[head];
+        struct _tree_imagenode *record = &buffer[buffered++];
+        record->value = current->value;
+        record->first = tail;
+        record->childcount = current->childcount;
+        record->nameid = current->nameid;
+        record->hash = current->hash;
+        if (current->childcount) {
+            memcpy (&order[tail], current->children, current->childcount * sizeof (tree));
+            qsort (&order[tail], current->childcount, sizeof (tree), tree_cmpchild);
+            tail += current->childcount;
+        }
+        if (buffered == sizeof (buffer) / sizeof (buffer[0]) || head + 1 == nodecount) {
+            if (!tree_writeall (fd, buffer, buffered * sizeof (struct _tree_imagenode)))
+                goto done;
+            buffered = 0;
+        }
+    }
+    success = true;
+done:
+    free (order);
+    free (names);
+    return success;
+}
+
+/**
+ * @brief Maps an image written by tree_save
+ *
+ * The file is mapped read only and nothing is copied out of it, so
+ * loading takes the same time whatever the size of the tree. Lookups
+ * with tree_getdata binary search the children of each node in the image.
+ *
+ * NOTE:
+ * The mapped tree is read only: tree_getnode returns NULL, and
+ * tree_setdata, tree_setnode and tree_rmnode fail. tree_delete unmaps it.
+ *
+ * @param path Path of the image file, null terminated
+ * @return tree NULL if the file can't be mapped or isn't an image
+ */
+tree tree_map (const char *path)
+{
+    int fd = open (path, O_RDONLY);
+    if (fd < 0)
+        return NULL;
+    struct stat st;
+    if (fstat (fd, &st) < 0 || (uint64_t) st.st_size < sizeof (struct _tree_imageheader)) {
+        close (fd);
+        return NULL;
+    }
+    uint64_t size = st.st_size;
+    void *image = mmap (NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close (fd);
+    if (image == MAP_FAILED)
+        return NULL;
+    // the sections must lie inside the file, nodes are checked as they are reached
+    const struct _tree_imageheader *header = image;
+    if (memcmp (header->magic, TREE_IMAGE_MAGIC, sizeof (header->magic))
+        || header->nodecount == 0 || header->nodecount > TREE_NONAME
+        || header->namecount > TREE_NONAME
+        || header->nodesoff % 8 || header->namesoff % 8
+        || header->nodesoff > size || header->namesoff > size || header->strtaboff > size
+        || (size - header->nodesoff) / sizeof (struct _tree_imagenode) < header->nodecount
+        || (size - header->namesoff) / sizeof (struct _tree_imagename) < header->namecount
+        || size - header->strtaboff < header->strtabsize) {
+        munmap (image, size);
+        return NULL;
+    }
+    tree root = tree_newtree (false);
+    if (!root) {
+        munmap (image, size);
+        return NULL;
+    }
+    root->meta->image = image;
+    root->meta->imagesize = size;
+    return root;
+}
+
+/**
+ * @brief Gets data of a node of a mapped image
+ * @return int64_t Returns TREE_ERROR if path doesn't exist or image is damaged
+ */
+static int64_t tree_imagegetdata (struct _tree_meta *meta, const char *path, uint64_t len)
+{
+    const struct _tree_imageheader *header = (const void *) meta->image;
+    const struct _tree_imagenode *nodes = (const void *) (meta->image + header->nodesoff);
+    const struct _tree_imagename *names = (const void *) (meta->image + header->namesoff);
+    const char *strtab = meta->image + header->strtaboff;
+    const struct _tree_imagenode *node = &nodes[0];
+    const char *seg;
+    uint64_t seglen;
+    uint64_t next = 0;
+    while (tree_nextseg (path, len, &next, &seg, &seglen)) {
+        uint32_t hash = tree_hash (seg, seglen);
+        uint64_t lo = node->first, hi = lo + node->childcount;
+        if (hi > header->nodecount)
+            return TREE_ERROR;
+        // first child with the same hash
+        while (lo < hi) {
+            uint64_t mid = lo + (hi - lo) / 2;
+            if (nodes[mid].hash < hash)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        const struct _tree_imagenode *child = NULL;
+        for (hi = node->first + node->childcount; lo < hi && nodes[lo].hash == hash; lo++) {
+            if (nodes[lo].nameid >= header->namecount)
+                return TREE_ERROR;
+            const struct _tree_imagename *name = &names[nodes[lo].nameid];
+            if (name->len == seglen && seglen < header->strtabsize
+                && name->off < header->strtabsize - seglen
+                && !memcmp (strtab + name->off, seg, seglen)) {
+                child = &nodes[lo];
+                break;
+            }
+        }
+        if (!child)
+            return TREE_ERROR;
+        node = child;
+    }
+    return node->value;
+}
+
+/**
+ * @brief Matches a name against a glob of '*' and '?'
+ */
+static bool tree_globmatch (const char *glob, uint64_t globlen, const char *name, uint64_t namelen)
+{
+    uint64_t g = 0, n = 0;
+    // on a mismatch, the last '*' takes one more char and matching resumes after it
+    bool star = false;
+    uint64_t starg = 0, starn = 0;
+    while (n < namelen) {
+        if (g < globlen && glob[g] == '*') {
+            star = true;
+            starg = g++;
+            starn = n;
+        } else if (g < globlen && (glob[g] == '?' || glob[g] == name[n])) {
+            g++;
+            n++;
+        } else if (star) {
+            g = starg + 1;
+            n = ++starn;
+        } else {
+            return false;
+        }
+    }
+    while (g < globlen && glob[g] == '*')
+        g++;
+    return g == globlen;
+}
+
+/**
+ * @brief Adds the states reachable by skipping "**" segments that match no names
+ */
+static uint64_t tree_queryclose (const struct _tree_queryseg *segs, uint64_t states)
+{
+    // "**" only leads forward, so one pass in order is enough
+    for (uint64_t i = 0; i < TREE_QUERY_MAXSEGS; i++)
+        if ((states >> i & 1) && segs[i].kind == TREE_SEG_GLOBSTAR)
+            states |= 1ull << (i + 1);
+    return states;
+}
+
+/**
+ * @brief States a child is in, given the states its parent is in
+ * @param segs The compiled pattern
+ * @param count Number of segments, state count means the whole pattern matched
+ * @param states States of the parent
+ * @param child The child
+ * @return uint64_t States of the child, 0 if no path through it can match
+ */
+static uint64_t tree_querystep (const struct _tree_queryseg *segs, uint64_t count, uint64_t states, tree child)
+{
+    uint64_t next = 0;
+    struct _tree_name *name = &child->meta->names[child->nameid];
+    for (uint64_t i = 0; i < count; i++) {
+        if (!(states >> i & 1))
+            continue;
+        switch (segs[i].kind) {
+            case TREE_SEG_LITERAL:
+                if (child->nameid == segs[i].nameid)
+                    next |= 1ull << (i + 1);
+                break;
+            case TREE_SEG_STAR:
+                next |= 1ull << (i + 1);
+                break;
+            case TREE_SEG_WILD:
+                if (tree_globmatch (segs[i].str, segs[i].len, name->str, name->len))
+                    next |= 1ull << (i + 1);
+                break;
+            case TREE_SEG_GLOBSTAR:
+                next |= 1ull << i;
+                break;
+        }
+    }
+    return tree_queryclose (segs, next);
+}
+
+/**
+ * @brief Calls back on every node whose path matches a glob pattern
+ *
+ * The pattern is split into segments like a path. A segment "*" matches
+ * any one name, "**" matches any number of names, zero included, and
+ * other segments with '*' or '?' match names like a shell glob does.
+ * Everything else must match a name exactly. For example, a pattern with
+ * segments svc, *, metrics, ** and latency matches "/svc/a/metrics/latency"
+ * and "/svc/b/metrics/http/p99/latency".
+ *
+ * The pattern is compiled once, then the tree is walked a single time,
+ * keeping for each node the set of pattern segments that can come next.
+ * Subtrees where that set is empty are skipped, and where only exact
+ * names can come next, the children are looked up rather than scanned.
+ *
+ * @param tr The node paths are relative to
+ * @param pattern The pattern, need not be null terminated
+ * @param len Length of pattern
+ * @param callback Called on each matching node, returning false stops the query
+ * @param ctx Passed on to callback
+ * @return bool False if stopped, allocation failed, the pattern has more
+ *              than TREE_QUERY_MAXSEGS segments, or the tree is mapped
+ */
+bool tree_query (tree tr, const char *pattern, uint64_t len,
+    bool (*callback)(tree node, void *ctx), void *ctx)
+{
+    if (!tr || tr->meta->image)
+        return false;
+    struct _tree_queryseg segs[TREE_QUERY_MAXSEGS + 1];
+    uint64_t count = 0, pos = 0;
+    // states that move on by exact name only
+    uint64_t literals = 0;
+    const char *seg;
+    uint64_t seglen;
+    while (tree_nextseg (pattern, len, &pos, &seg, &seglen)) {
+        if (count == TREE_QUERY_MAXSEGS)
+            return false;
+        struct _tree_queryseg *qs = &segs[count];
+        qs->str = seg;
+        qs->len = seglen;
+        if (seglen == 1 && seg[0] == '*') {
+            qs->kind = TREE_SEG_STAR;
+        } else if (seglen == 2 && seg[0] == '*' && seg[1] == '*') {
+            // "**" twice in a row is the same as once
+            if (count && segs[count - 1].kind == TREE_SEG_GLOBSTAR)
+                continue;
+            qs->kind = TREE_SEG_GLOBSTAR;
+        } else if (memchr (seg, '*', seglen) || memchr (seg, '?', seglen)) {
+            qs->kind = TREE_SEG_WILD;
+        } else {
+            qs->kind = TREE_SEG_LITERAL;
+            qs->hash = tree_hash (seg, seglen);
+            qs->nameid = tree_findname (tr->meta, seg, seglen, qs->hash);
+            literals |= 1ull << count;
+        }
+        count++;
+    }
+    segs[count].kind = TREE_SEG_LITERAL;
+    uint64_t accept = 1ull << count;
+    uint64_t cap = 64, top = 0;
+    struct _tree_querystate *stack = malloc (cap * sizeof (struct _tree_querystate));
+    if (!stack)
+        return false;
+    bool success = false;
+    stack[top].node = tr;
+    stack[top++].states = tree_queryclose (segs, 1);
+    while (top) {
+        struct _tree_querystate current = stack[--top];
+        if ((current.states & accept) && !callback (current.node, ctx))
+            goto done;
+        uint64_t states = current.states & ~accept;
+        tree node = current.node;
+        if (!states || !node->childcount)
+            continue;
+        // room for every child, so pushing can't fail below
+        if (top + node->childcount > cap) {
+            uint64_t newcap = cap;
+            while (top + node->childcount > newcap)
+                newcap *= 2;
+            struct _tree_querystate *grown = realloc (stack, newcap * sizeof (struct _tree_querystate));
+            if (!grown)
+                goto done;
+            stack = grown;
+            cap = newcap;
+        }
+        if (!(states & ~literals)) {
+            // only exact names can come next, look them up
+            for (uint64_t i = 0; i < count; i++) {
+                if (!(states >> i & 1) || segs[i].nameid == TREE_NONAME)
+                    continue;
+                // a name that is in several states is looked up once
+                bool seen = false;
+                for (uint64_t j = 0; j < i && !seen; j++)
+                    seen = (states >> j & 1) && segs[j].nameid == segs[i].nameid;
+                tree child = seen ? NULL : tree_findchild (node, segs[i].nameid, segs[i].hash, NULL);
+                if (child) {
+                    stack[top].node = child;
+                    stack[top++].states = tree_querystep (segs, count, states, child);
+                }
+            }
+            continue;
+        }
+        for (uint64_t i = node->childcount; i-- > 0;) {
+            uint64_t next = tree_querystep (segs, count, states, node->children[i]);
+            if (next) {
+                stack[top].node = node->children[i];
+                stack[top++].states = next;
+            }
+        }
+    }
+    success = true;
+done:
+    free (stack);
+    return success;
+}
+
+// a node on the stack of a depth first walk
+struct _tree_walkentry {
+    tree node;
+    uint64_t next;      // index of next child to visit
+};
+
+/**
+ * @brief Walks depth first, pre is called before and post after visiting the children
+ */
+static bool tree_walkdfs (tree node, bool (*pre)(tree node, uint64_t depth, void *ctx),
+    bool (*post)(tree node, uint64_t depth, void *ctx), void *ctx)
+{
+    uint64_t cap = 64, top = 0;
+    struct _tree_walkentry *stack = malloc (cap * sizeof (struct _tree_walkentry));
+    if (!stack)
+        return false;
+    bool success = false;
+    if (pre && !pre (node, 0, ctx))
+        goto done;
+    stack[0].node = node;
+    stack[0].next = 0;
+    for (;;) {
+        struct _tree_walkentry *entry = &stack[top];
+        if (entry->next < entry->node->childcount) {
+            tree child = entry->node->children[entry->next++];
+            if (pre && !pre (child, top + 1, ctx))
+                goto done;
+            if (top + 1 == cap) {
+                struct _tree_walkentry *grown = realloc (stack, 2 * cap * sizeof (struct _tree_walkentry));
+                if (!grown)
+                    goto done;
+                stack = grown;
+                cap *= 2;
+            }
+            top++;
+            stack[top].node = child;
+            stack[top].next = 0;
+            continue;
+        }
+        if (post && !post (entry->node, top, ctx))
+            goto done;
+        if (top == 0)
+            break;
+        top--;
+    }
+    success = true;
+done:
+    free (stack);
+    return success;
+}
+
+/**
+ * @brief Walks breadth first, pre is called on each node in level order
+ */
+static bool tree_walkbfs (tree node, bool (*pre)(tree node, uint64_t depth, void *ctx), void *ctx)
+{
+    // queue of nodes, the depth goes up by one at each level boundary
+    uint64_t cap = 64, head = 0, tail = 0;
+    tree *queue = malloc (cap * sizeof (tree));
+    if (!queue)
+        return false;
+    bool success = false;
+    uint64_t depth = 0, levelend = 1;
+    queue[tail++] = node;
+    while (head < tail) {
+        if (head == levelend) {
+            depth++;
+            levelend = tail;
+        }
+        tree current = queue[head++];
+        if (pre && !pre (current, depth, ctx))
+            goto done;
+        if (!current->childcount)
+            continue;
+        if (tail + current->childcount > cap) {
+            // drop visited nodes first, grow only if that isn't enough
+            memmove (queue, &queue[head], (tail - head) * sizeof (tree));
+            tail -= head;
+            levelend -= head;
+            head = 0;
+            if (tail + current->childcount > cap) {
+                uint64_t newcap = cap;
+                while (tail + current->childcount > newcap)
+                    newcap *= 2;
+                tree *grown = realloc (queue, newcap * sizeof (tree));
+                if (!grown)
+                    goto done;
+                queue = grown;
+                cap = newcap;
+            }
+        }
+        memcpy (&queue[tail], current->children, current->childcount * sizeof (tree));
+        tail += current->childcount;
+    }
+    success = true;
+done:
+    free (queue);
+    return success;
+}
+
+/**
+ * @brief Walks a subtree, calling back on each node
+ *
+ * The walk uses an explicit stack or queue instead of recursion, so
+ * trees of any depth can be walked. Depth of node is 0.
+ *
+ * For TREE_DFS, pre is called on a node before its children are visited,
+ * post after all of them are. For TREE_BFS, pre is called on nodes level
+ * by level, post isn't used.
+ *
+ * Callbacks may change values of nodes but must not add or remove nodes.
+ *
+ * @param node The node to start from
+ * @param order TREE_DFS or TREE_BFS
+ * @param pre Called before children, may be NULL, returning false stops the walk
+ * @param post Called after children, may be NULL, returning false stops the walk
+ * @param ctx Passed on to the callbacks
+ * @return bool True if every node was visited, false if stopped or allocation failed
+ */
+bool tree_walk (tree node, int order, bool (*pre)(tree node, uint64_t depth, void *ctx),
+    bool (*post)(tree node, uint64_t depth, void *ctx), void *ctx)
+{
+    if (!node)
+        return false;
+    if (order == TREE_BFS)
+        return tree_walkbfs (node, pre, ctx);
+    return tree_walkdfs (node, pre, post, ctx);
+}
+
 /**
  * @brief Deletes a tree
  *
@@ -196,16 +1964,39 @@ bool tree_rmnode (tree tr, const string path)
  * another tree operation will cause some undefined behaviour.
  * Additionally, this function is more convenient.
  *
+ * The interned names are freed along with the root of the tree.
+ * Nodes are freed bottom up by following parent links, so no stack
+ * space is used whatever the depth. The root of an arena tree frees
+ * all nodes at once.
+ *
  * @param tree* Reference to the tree, is set to NULL.
  */
 void tree_delete (tree *root)
 {
-    if ((*root)->children) {
-        for (uint64_t i = 0; i < (*root)->childcount; i++) {
-            tree_delete (&((*root)->children[i]));
-        }
-    } else {
-        free (*root);
-        *root = NULL;
+    if (!root || !*root)
+        return;
+    tree top = *root;
+    struct _tree_meta *meta = top->meta;
+    *root = NULL;
+    if (meta->arenanodes) {
+        if (meta->root == top)
+            tree_freemeta (meta);
+        return;
+    }
+    bool isroot = meta->root == top;
+    tree node = top;
+    for (;;) {
+        // last child goes first, so the parent need only count down
+        while (node->childcount)
+            node = node->children[node->childcount - 1];
+        tree parent = node->parent;
+        bool last = node == top;
+        tree_freenode (node);
+        if (last)
+            break;
+        parent->childcount--;
+        node = parent;
     }
+    if (isroot)
+        tree_freemeta (meta);
 }
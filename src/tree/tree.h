@@ -9,17 +9,165 @@
 
 # define TREE_ERROR 0x0123456789abcdeful
 
+// children of a node are searched linearly up to this many children
+# define TREE_LINEAR_MAX 8
+// children of a node are kept sorted and binary searched up to this many children,
+// beyond that a hash index over the children is used
+# define TREE_SORTED_MAX 64
+// size of each block of the name arena
+# define TREE_ARENA_BLOCK 65536
+// name id of a name that isn't interned
+# define TREE_NONAME 0xffffffffu
+// first bytes of a tree image written by tree_save
+# define TREE_IMAGE_MAGIC "CDSTREE1"
+// max number of segments in a pattern of tree_query
+# define TREE_QUERY_MAXSEGS 63
+// orders of tree_walk
+# define TREE_DFS 0
+# define TREE_BFS 1
+
 typedef char* string;
 typedef struct _tree_node* tree;
 
+// an interned name
+struct _tree_name {
+    const char *str;        // null terminated, inside the name arena
+    uint32_t len;
+    uint32_t hash;
+};
+
+// a cached path lookup
+struct _tree_cacheentry {
+    char *path;                 // copy of path, owned by the cache
+    uint64_t len;
+    uint64_t hash;              // hash of whole path
+    tree node;
+    uint64_t generation;        // generation of the tree when entry was made
+    bool referenced;            // CLOCK reference bit
+};
+
+// cache of whole path to node lookups, with CLOCK eviction
+struct _tree_cache {
+    struct _tree_cacheentry *entries;
+    uint64_t capacity;          // max number of entries
+    uint64_t count;
+    uint64_t hand;              // CLOCK hand, next entry considered for eviction
+    uint32_t *index;            // hash index over entries, each slot holds entry index + 1, 0 if empty
+    uint64_t indexcap;
+};
+
+// aggregates of values over a subtree, the node itself included
+struct _tree_aggregate {
+    int64_t sum;                // wraps around on overflow
+    uint64_t count;             // number of nodes
+    int64_t min;
+    int64_t max;
+};
+
+// paths of a batch with the same parent path
+struct _tree_batchgroup {
+    uint64_t hash;              // hash of parent path
+    uint64_t index;             // index + 1 of first path of group in the batch, 0 if slot is empty
+    tree parent;                // node at parent path, NULL if it doesn't exist
+};
+
+// a compiled segment of a tree_query pattern
+struct _tree_queryseg {
+    uint8_t kind;               // one of the kinds below
+    const char *str;            // the segment in the pattern
+    uint64_t len;
+    uint32_t nameid;            // for a literal, TREE_NONAME if no node has the name
+    uint32_t hash;              // for a literal
+};
+
+// kinds of a pattern segment
+# define TREE_SEG_LITERAL 0     // matches a name exactly
+# define TREE_SEG_STAR 1        // "*", matches any one name
+# define TREE_SEG_WILD 2        // has '*' or '?', matches names like a shell glob
+# define TREE_SEG_GLOBSTAR 3    // "**", matches zero or more names
+
+// a node to visit in tree_query, with the pattern states it's in
+struct _tree_querystate {
+    tree node;
+    uint64_t states;            // bit i set if the first i segments match the path to node
+};
+
+// header at the start of a tree image, offsets are from the start of the image
+struct _tree_imageheader {
+    char magic[8];              // TREE_IMAGE_MAGIC
+    uint64_t nodecount;
+    uint64_t namecount;
+    uint64_t nodesoff;          // array of nodecount struct _tree_imagenode
+    uint64_t namesoff;          // array of namecount struct _tree_imagename
+    uint64_t strtaboff;         // null terminated names, back to back
+    uint64_t strtabsize;
+    uint64_t reserved;
+};
+
+// a node in a tree image, nodes are in breadth first order
+struct _tree_imagenode {
+    int64_t value;
+    uint32_t first;             // index of first child, children are consecutive and sorted by hash
+    uint32_t childcount;
+    uint32_t nameid;            // index into names of the image
+    uint32_t hash;              // hash of name
+};
+
+// a name in a tree image
+struct _tree_imagename {
+    uint64_t off;               // offset into string table
+    uint32_t len;
+    uint32_t hash;
+};
+
+// state shared by all nodes of a tree, owned by the root
+struct _tree_meta {
+    tree root;
+    uint64_t generation;        // bumped whenever nodes are removed or replaced
+    struct _tree_cache *cache;  // NULL unless path cache is enabled
+    char *arena;                // current arena block, starts with pointer to previous block
+    uint64_t arenaused;         // bytes used in current block
+    uint64_t arenacap;          // bytes available in current block
+    bool arenanodes;            // nodes and child arrays come from the arena too
+    bool aggregates;            // subtree aggregates of nodes are kept up to date
+    struct _tree_name *names;   // interned names, indexed by name id
+    uint32_t namecount;
+    uint32_t namecap;
+    uint32_t *nameindex;        // hash index over names, each slot holds name id + 1, 0 if empty
+    uint64_t nameindexcap;
+    const char *image;          // image mapped by tree_map, NULL for other trees
+    uint64_t imagesize;
+};
+
 typedef struct _tree_node {
-    string name;
+    uint32_t nameid;        // id of name in the name table of the tree
+    uint32_t hash;          // hash of name, precomputed
     int64_t value;
     tree parent;
+    struct _tree_meta *meta;
     uint64_t childcount;
+    uint64_t childcap;      // allocated length of children
     tree *children;
+    uint32_t *childindex;   // hash index over children, NULL unless more than TREE_SORTED_MAX children
+    uint64_t indexcap;      // number of slots in childindex
+    struct _tree_aggregate agg;     // over subtree, only valid while aggregates of the tree are enabled
 } _tree_node;
 
+/**
+ * Paths are split into segments at '/', empty segments are ignored, so
+ * "/a//b/" is the same as "a/b". Paths are never modified, and lookups
+ * keep no hidden state, so a tree that isn't being modified may be read
+ * from many threads at once.
+ *
+ * Node names are interned: each distinct name is stored once in an arena
+ * owned by the tree, and nodes refer to it by a 32-bit name id. Names stay
+ * in the arena until the tree is deleted.
+ *
+ * A tree saved with tree_save can be mapped back with tree_map. The
+ * mapped tree serves tree_getdata straight from the image, without
+ * building any nodes, and is read only.
+ */
+
 /**
  * @brief Allocates a new tree in the heap
  *
@@ -29,58 +177,252 @@ typedef struct _tree_node {
  */
 tree new_tree();
 
+/**
+ * @brief Allocates a new tree whose nodes live in an arena
+ *
+ * Nodes and their child arrays are carved out of large blocks owned by
+ * the tree, so building the tree makes few calls to malloc, and
+ * tree_delete on the root releases the whole tree by freeing the blocks,
+ * without visiting any node.
+ *
+ * NOTE:
+ * Memory of nodes removed by tree_rmnode or tree_setnode, and of child
+ * arrays that grew, is only reclaimed when the whole tree is deleted.
+ *
+ * @return tree
+ */
+tree new_tree_arena();
+
+/**
+ * @brief Gets name of a node
+ * @param node The node
+ * @return const char* Null terminated name, owned by the tree
+ */
+const char *tree_getname (tree node);
+
+/**
+ * @brief Enables, resizes or disables the path cache of a tree
+ *
+ * The path cache maps whole path strings to nodes, so that repeated
+ * lookups of the same path from the root cost one hash probe instead of
+ * a walk. It holds at most capacity paths and evicts with the CLOCK
+ * algorithm. Removing or replacing nodes invalidates all entries.
+ *
+ * Paths are cached as given, so "/a/b" and "a//b" take separate entries.
+ * Only lookups made from the root of the tree use the cache.
+ *
+ * NOTE:
+ * With the cache enabled, lookups update the cache, so the tree may no
+ * longer be read from many threads at once.
+ *
+ * @param tr The tree root
+ * @param capacity Max number of cached paths, 0 disables the cache
+ * @return bool True if successful
+ */
+bool tree_setcache (tree tr, uint64_t capacity);
+
+/**
+ * @brief Enables or disables subtree aggregates of a tree
+ *
+ * While enabled, every node keeps the sum, count, min and max of the
+ * values in its subtree, and tree_setdata, tree_setnode and tree_rmnode
+ * update them along the parent chain of the changed node. Sum and count
+ * are updated in O(1) per ancestor. Min and max too, unless the old min
+ * or max of an ancestor is gone, in which case the children of that
+ * ancestor are scanned.
+ *
+ * Enabling computes the aggregates of all nodes, in O(number of nodes).
+ *
+ * @param tr The tree root
+ * @param enable True to enable, false to disable
+ * @return bool True if successful, false for a mapped tree
+ */
+bool tree_setaggregate (tree tr, bool enable);
+
+/**
+ * @brief Gets aggregates of the values of a node and its subtree
+ *
+ * Takes O(depth) with aggregates enabled, otherwise the subtree is walked.
+ *
+ * @param tr The tree root
+ * @param path Path to target node, need not be null terminated
+ * @param len Length of path
+ * @param agg Set to the aggregates
+ * @return bool False if path doesn't exist
+ */
+bool tree_aggregate (tree tr, const char *path, uint64_t len, struct _tree_aggregate *agg);
+
 /**
  * @brief Sets data of a node
  * @param tr The tree root
- * @param path Path to target node
+ * @param path Path to target node, need not be null terminated
+ * @param len Length of path
  * @param val Value to be set at target node
  * @return bool True if successful
  */
-bool tree_setdata (tree tr, const string path, int64_t val);
+bool tree_setdata (tree tr, const char *path, uint64_t len, int64_t val);
 
 /**
  * @brief Gets data of a node
  * @param tr The tree root
- * @param path Path to target node
+ * @param path Path to target node, need not be null terminated
+ * @param len Length of path
  * @return int64_t Returns TREE_ERROR on error
  */
-int64_t tree_getdata (tree tr, const string path);
+int64_t tree_getdata (tree tr, const char *path, uint64_t len);
 
 /**
- * @brief Sets node to another node
+ * @brief Sets data of many nodes
  *
- * WARNING:
- * This method allows circular reference & and setting of one tree
- * root to the node of another tree. Abuse of this function will
- * only result in hellish mental pain.
+ * Paths are grouped by their parent path, that is all but the last
+ * segment. The parent path of each group is walked once, after that
+ * each path costs a hash of its bytes and one child lookup. Paths are
+ * set in the given order, so a path given twice gets the later value.
  *
- * NOTE:
- * Circular references may result in infinite recursive calls when
- * using tree_delete or tree_rmnode. In such cases, you'll need to
- * write your own deletion function.
+ * @param tr The tree root
+ * @param paths Paths to target nodes, need not be null terminated
+ * @param lens Lengths of paths
+ * @param vals Values to be set at target nodes
+ * @param count Number of paths
+ * @param success If not NULL, success[i] is set to true if paths[i] was set
+ * @return bool True if all paths were set
+ */
+bool tree_setdata_batch (tree tr, const char **paths, const uint64_t *lens, const int64_t *vals,
+    uint64_t count, bool *success);
+
+/**
+ * @brief Gets data of many nodes
+ *
+ * Paths are grouped by parent path like in tree_setdata_batch.
  *
  * @param tr The tree root
- * @param path Path to target node
+ * @param paths Paths to target nodes, need not be null terminated
+ * @param lens Lengths of paths
+ * @param count Number of paths
+ * @param vals vals[i] is set to data at paths[i], TREE_ERROR if it doesn't exist
+ * @param success If not NULL, success[i] is set to true if paths[i] exists
+ * @return bool True if all paths exist
+ */
+bool tree_getdata_batch (tree tr, const char **paths, const uint64_t *lens, uint64_t count,
+    int64_t *vals, bool *success);
+
+/**
+ * @brief Sets node to another node
+ *
+ * The value of node2 and a deep copy of its subtree replace the value and
+ * subtree of the target node. Name and parent of target node are unchanged.
+ * As a copy is made, node2 may be anywhere, even inside the target subtree.
+ *
+ * @param tr The tree root
+ * @param path Path to target node, need not be null terminated
+ * @param len Length of path
  * @param node2 The node to be set to at target node
  * @return bool True if successful
  */
-bool tree_setnode (tree tr, const string path, tree node2);
+bool tree_setnode (tree tr, const char *path, uint64_t len, tree node2);
 
 /**
  * @brief Gets target node
+ *
+ * Each path segment is found in O(1) expected time for nodes with many
+ * children, and by binary or linear search for nodes with fewer children.
+ *
  * @param tr The tree root
- * @param path Path to target node
- * @return tree
+ * @param path Path to target node, need not be null terminated
+ * @param len Length of path
+ * @return tree Returns NULL if path doesn't exist
  */
-tree tree_getnode (tree tr, const string path);
+tree tree_getnode (tree tr, const char *path, uint64_t len);
 
 /**
  * @brief Deletes a node
+ *
+ * The root of a tree can't be removed, use tree_delete instead.
+ *
  * @param tr The tree root
- * @param path Path to target node
+ * @param path Path to target node, need not be null terminated
+ * @param len Length of path
  * @return bool True if successful
  */
-bool tree_rmnode (tree tr, const string path);
+bool tree_rmnode (tree tr, const char *path, uint64_t len);
+
+/**
+ * @brief Writes a subtree to a file as an image that tree_map can load
+ *
+ * The image holds the names of the tree in a string table, and the nodes
+ * in breadth first order with the children of each node as a range of
+ * indices. It contains no pointers, so it can be mapped at any address,
+ * but it is in the byte order of the machine that wrote it.
+ *
+ * @param node The node to save, saved as the root of the image
+ * @param fd File descriptor open for writing
+ * @return bool True if successful
+ */
+bool tree_save (tree node, int fd);
+
+/**
+ * @brief Maps an image written by tree_save
+ *
+ * The file is mapped read only and nothing is copied out of it, so
+ * loading takes the same time whatever the size of the tree. Lookups
+ * with tree_getdata binary search the children of each node in the image.
+ *
+ * NOTE:
+ * The mapped tree is read only: tree_getnode returns NULL, and
+ * tree_setdata, tree_setnode and tree_rmnode fail. tree_delete unmaps it.
+ *
+ * @param path Path of the image file, null terminated
+ * @return tree NULL if the file can't be mapped or isn't an image
+ */
+tree tree_map (const char *path);
+
+/**
+ * @brief Calls back on every node whose path matches a glob pattern
+ *
+ * The pattern is split into segments like a path. A segment "*" matches
+ * any one name, "**" matches any number of names, zero included, and
+ * other segments with '*' or '?' match names like a shell glob does.
+ * Everything else must match a name exactly. For example, a pattern with
+ * segments svc, *, metrics, ** and latency matches "/svc/a/metrics/latency"
+ * and "/svc/b/metrics/http/p99/latency".
+ *
+ * The pattern is compiled once, then the tree is walked a single time,
+ * keeping for each node the set of pattern segments that can come next.
+ * Subtrees where that set is empty are skipped, and where only exact
+ * names can come next, the children are looked up rather than scanned.
+ *
+ * @param tr The node paths are relative to
+ * @param pattern The pattern, need not be null terminated
+ * @param len Length of pattern
+ * @param callback Called on each matching node, returning false stops the query
+ * @param ctx Passed on to callback
+ * @return bool False if stopped, allocation failed, the pattern has more
+ *              than TREE_QUERY_MAXSEGS segments, or the tree is mapped
+ */
+bool tree_query (tree tr, const char *pattern, uint64_t len,
+    bool (*callback)(tree node, void *ctx), void *ctx);
+
+/**
+ * @brief Walks a subtree, calling back on each node
+ *
+ * The walk uses an explicit stack or queue instead of recursion, so
+ * trees of any depth can be walked. Depth of node is 0.
+ *
+ * For TREE_DFS, pre is called on a node before its children are visited,
+ * post after all of them are. For TREE_BFS, pre is called on nodes level
+ * by level, post isn't used.
+ *
+ * Callbacks may change values of nodes but must not add or remove nodes.
+ *
+ * @param node The node to start from
+ * @param order TREE_DFS or TREE_BFS
+ * @param pre Called before children, may be NULL, returning false stops the walk
+ * @param post Called after children, may be NULL, returning false stops the walk
+ * @param ctx Passed on to the callbacks
+ * @return bool True if every node was visited, false if stopped or allocation failed
+ */
+bool tree_walk (tree node, int order, bool (*pre)(tree node, uint64_t depth, void *ctx),
+    bool (*post)(tree node, uint64_t depth, void *ctx), void *ctx);
 
 /**
  * @brief Deletes a tree
@@ -93,6 +435,11 @@ bool tree_rmnode (tree tr, const string path);
  * another tree operation will cause some undefined behaviour.
  * Additionally, this function is more convenient.
  *
+ * The interned names are freed along with the root of the tree.
+ * Nodes are freed bottom up by following parent links, so no stack
+ * space is used whatever the depth. The root of an arena tree frees
+ * all nodes at once.
+ *
  * @param tree* Reference to the tree, is set to NULL.
  */
 void tree_delete (tree *root);